@@ -0,0 +1,558 @@
+// Native benchmark for alien-clock: pio run -e native, then from the project directory
+//   .pio/build/native/program [--frames N] [--dump DIR] [--only NAME] [--assets DIR] [--profile] [--verbose]
+// Links the real sketch (setup()/loop()) against native/HostShims.
+
+#include <Arduino.h>
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include <host_bench.h>
+#include <host_stream.h>
+#include <frame_scheduler.h>
+#include <frame_profiler.h>
+#include <boot_trace.h>
+#include <color_depth.h>
+#include <virtual_canvas.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pattern_renderer.h"
+
+// Sketch globals (main.cpp)
+extern MatrixPanel_I2S_DMA *dma_display;
+extern FrameScheduler frame_scheduler;
+extern VirtualCanvas canvas;
+extern BootTrace boot_trace;
+extern ColorDepthProfile depth_profile;
+
+// Same default as the sketch (build flags reach both)
+#ifndef FAST_BOOT
+#define FAST_BOOT 1
+#endif
+
+// On the simulated clock boot takes only the delays setup() waits out: none with
+// FAST_BOOT, the FM6126A's 100 + 50 + 50 ms without. Nothing before the loop() case
+// moves the clock, and the scheduler starts its first frame at once.
+#define BOOT_FIRST_FRAME_US (FAST_BOOT ? 0u : 200000u)
+
+// A panel wall of its own for the canvas cases
+struct Wall
+{
+  MatrixPanel_I2S_DMA *display;
+  VirtualCanvas canvas;
+  PatternRenderer renderer;
+};
+
+void setup();
+void loop();
+
+// Every frame from scratch: all patterns re-seeded and every panel fully redrawn
+static void benchFullRedraw(void *ctx, uint32_t frame)
+{
+  Wall *wall = (Wall *)ctx;
+  PatternRenderer *renderer = &wall->renderer;
+  int patterns = renderer->patternsX * renderer->patternsY;
+  for (int x = 0; x < renderer->patternsX; x++)
+    for (int y = 0; y < renderer->patternsY; y++)
+      setPatternSeed(renderer, x, y, frame * patterns + x * renderer->patternsY + y + 1);
+  canvasMarkAllDirty(&wall->canvas);
+  renderPatterns(wall->display, &wall->canvas, renderer);
+}
+
+// One pattern re-seeded per frame, drawn incrementally (the sketch's steady state)
+static void benchIncremental(void *ctx, uint32_t frame)
+{
+  Wall *wall = (Wall *)ctx;
+  PatternRenderer *renderer = &wall->renderer;
+  int x = random(renderer->patternsX);
+  int y = random(renderer->patternsY);
+  setPatternSeed(renderer, x, y, frame + 1);
+  renderPatterns(wall->display, &wall->canvas, renderer);
+}
+
+// Full, then incremental frames on a wall. The incremental case starts from a fresh
+// renderer whose first frame, drawing the whole wall, is not timed.
+static void benchWall(const char *prefix, Wall *wall, const BenchOptions *options)
+{
+  char name[48];
+  patternRendererInit(&wall->renderer, &wall->canvas);
+  snprintf(name, sizeof(name), "%s/full", prefix);
+  hostBenchRun(name, wall->display, benchFullRedraw, wall, options);
+
+  patternRendererInit(&wall->renderer, &wall->canvas);
+  canvasMarkAllDirty(&wall->canvas);
+  renderPatterns(wall->display, &wall->canvas, &wall->renderer);
+  randomSeed(1);
+  snprintf(name, sizeof(name), "%s/incremental", prefix);
+  hostBenchRun(name, wall->display, benchIncremental, wall, options);
+  freePatternRenderer(&wall->renderer);
+}
+
+// The same on a wall of `columns` x `rows` 64x64 panels with snaking rows, so the cost
+// of a frame can be compared across wall sizes
+static void benchPanelWall(uint8_t columns, uint8_t rows, const BenchOptions *options)
+{
+  Wall wall = {new MatrixPanel_I2S_DMA(HUB75_I2S_CFG(64, 64, columns * rows)), VIRTUAL_CANVAS_INIT,
+               PATTERN_RENDERER_INIT};
+  wall.display->begin();
+  canvasInitGrid(&wall.canvas, 64, 64, columns, rows, 0, true);
+
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), "canvas/%upanels", columns * rows);
+  benchWall(prefix, &wall, options);
+  delete wall.display;
+}
+
+// Whether every canvas pixel lands on its own pixel of the chain, and rectangles split
+// and rotated per panel draw exactly what drawing them pixel by pixel does
+static bool canvasMapsOneToOne(const VirtualCanvas *wall)
+{
+  int16_t chainWidth = wall->panelWidth * wall->panelCount;
+  uint8_t *hit = (uint8_t *)calloc((size_t)chainWidth * wall->panelHeight, 1);
+  bool ok = hit != nullptr;
+  for (int16_t y = 0; ok && y < wall->height; y++)
+  {
+    for (int16_t x = 0; ok && x < wall->width; x++)
+    {
+      CanvasRect pixel = {x, y, 1, 1};
+      uint32_t panels = canvasPanelsIn(wall, &pixel);
+      uint8_t index = 0;
+      while (panels > 1 && !(panels & 1))
+      {
+        panels >>= 1;
+        index++;
+      }
+      ok = panels == 1; // Exactly one panel under every pixel of a full grid
+      if (!ok)
+        break;
+      CanvasRect out = canvasToChain(wall, index, &pixel);
+      size_t at = (size_t)out.y * chainWidth + out.x;
+      ok = out.w == 1 && out.h == 1 && out.x >= 0 && out.x < chainWidth && out.y >= 0 && out.y < wall->panelHeight &&
+           !hit[at];
+      if (ok)
+        hit[at] = 1;
+    }
+  }
+  free(hit);
+  if (!ok)
+    return false;
+
+  MatrixPanel_I2S_DMA byRect(HUB75_I2S_CFG(wall->panelWidth, wall->panelHeight, wall->panelCount));
+  MatrixPanel_I2S_DMA byPixel(HUB75_I2S_CFG(wall->panelWidth, wall->panelHeight, wall->panelCount));
+  byRect.begin();
+  byPixel.begin();
+  randomSeed(7);
+  for (int i = 0; i < 64; i++)
+  {
+    int16_t w = random(1, wall->width / 2), h = random(1, wall->height / 2);
+    CanvasRect rect = {(int16_t)random(wall->width - w), (int16_t)random(wall->height - h), w, h};
+    uint16_t color = random(1, 0x10000);
+    canvasFillRect(wall, &byRect, &rect, color);
+    for (int16_t y = rect.y; y < rect.y + rect.h; y++)
+    {
+      for (int16_t x = rect.x; x < rect.x + rect.w; x++)
+      {
+        CanvasRect pixel = {x, y, 1, 1};
+        canvasFillRect(wall, &byPixel, &pixel, color);
+      }
+    }
+  }
+  return hostPanelHash(&byRect) == hostPanelHash(&byPixel);
+}
+
+// Chains, grids, snaking grids and every rotation
+static int countCanvasLayouts(int *total)
+{
+  static const uint8_t layouts[][4] = {
+      // columns, rows, rotation, serpentine
+      {1, 1, 0, 0}, {1, 1, 1, 0}, {1, 1, 2, 0}, {1, 1, 3, 0}, {4, 1, 0, 0},
+      {2, 2, 0, 1}, {2, 2, 3, 1}, {4, 4, 0, 1}, {4, 4, 1, 1}, {8, 2, 2, 0}};
+  *total = sizeof(layouts) / sizeof(layouts[0]);
+  int passed = 0;
+  for (int i = 0; i < *total; i++)
+  {
+    VirtualCanvas wall = VIRTUAL_CANVAS_INIT;
+    canvasInitGrid(&wall, 64, 32, layouts[i][0], layouts[i][1], layouts[i][2], layouts[i][3]);
+    passed += canvasMapsOneToOne(&wall);
+  }
+  return passed;
+}
+
+// Serial streaming: the sketch's steady state (one pattern re-seeded per frame) captured
+// from the panel and sent over a pty loopback, then drawn from the packets on a panel of
+// its own, only the rectangle each one changed
+#define STREAM_BENCH_FRAMES 48
+
+struct StreamBench
+{
+  MatrixPanel_I2S_DMA *display; // Receiving panel
+  uint16_t *source;             // STREAM_BENCH_FRAMES captured RGB565 frames
+  uint16_t *frame;              // Picture applied from the packets
+  uint16_t width;
+  uint16_t height;
+  HostStreamLink link;
+  uint32_t matches;
+};
+
+// Panel contents as packed RGB565 (the panel stores RGB565 expanded, so this is exact)
+static void capturePanel565(const MatrixPanel_I2S_DMA *panel, uint16_t *out)
+{
+  const uint8_t *rgb = panel->pixels();
+  size_t pixels = (size_t)panel->panelWidthPx() * panel->panelHeightPx();
+  for (size_t i = 0; i < pixels; i++, rgb += 3)
+    out[i] = MatrixPanel_I2S_DMA::color565(rgb[0], rgb[1], rgb[2]);
+}
+
+// Display side: take the next packet, apply it, hand the buffer back, draw its rows as
+// runs of one colour
+static void benchStream(void *ctx, uint32_t frame)
+{
+  StreamBench *bench = (StreamBench *)ctx;
+  const StreamPacket *packet = hostStreamWait(&bench->link);
+  if (!packet)
+    return;
+  StreamPacket applied = *packet;
+  bool ok = streamApply(packet, bench->frame, bench->width, bench->width, bench->height);
+  streamRelease(&bench->link.receiver);
+  if (!ok)
+    return;
+
+  for (int16_t y = applied.y; y < applied.y + applied.h; y++)
+  {
+    const uint16_t *row = bench->frame + (size_t)y * bench->width;
+    for (int16_t x = applied.x; x < applied.x + applied.w;)
+    {
+      int16_t end = x + 1;
+      while (end < applied.x + applied.w && row[end] == row[x])
+        end++;
+      CanvasRect run = {x, y, (int16_t)(end - x), 1};
+      canvasFillChainRect(bench->display, &run, row[x]);
+      x = end;
+    }
+  }
+
+  size_t pixels = (size_t)bench->width * bench->height;
+  bench->matches += memcmp(bench->frame, bench->source + (frame % STREAM_BENCH_FRAMES) * pixels, pixels * 2) == 0;
+}
+
+static void printReport(void *, const uint8_t *data, size_t length)
+{
+  fwrite(data, 1, length, stdout);
+}
+
+static void benchLoop(void *, uint32_t)
+{
+  loop();
+}
+
+// Incremental redraws against a full redraw of the same seeds on a panel of its own,
+// over a run of single-pattern seed changes (the sketch's steady state)
+static bool checkIncrementalRedraw(int changes)
+{
+  HUB75_I2S_CFG config(dma_display->panelWidthPx(), dma_display->panelHeightPx());
+  MatrixPanel_I2S_DMA incremental(config), full(config);
+  incremental.begin();
+  full.begin();
+  size_t bytes = (size_t)config.mx_width * config.mx_height * 3;
+
+  VirtualCanvas incrementalCanvas = canvas, fullCanvas = canvas;
+  canvasMarkAllDirty(&incrementalCanvas);
+  PatternRenderer renderer = PATTERN_RENDERER_INIT, fresh = PATTERN_RENDERER_INIT;
+  bool identical = patternRendererInit(&renderer, &incrementalCanvas) && patternRendererInit(&fresh, &fullCanvas);
+  int patterns = renderer.patternsX * renderer.patternsY;
+  for (int i = 0; identical && i < changes; i++)
+  {
+    setPatternSeed(&renderer, random(renderer.patternsX), random(renderer.patternsY), i + 1);
+    renderPatterns(&incremental, &incrementalCanvas, &renderer);
+    memcpy(fresh.seeds, renderer.seeds, patterns * sizeof(int));
+    canvasMarkAllDirty(&fullCanvas);
+    full.clearScreen();
+    renderPatterns(&full, &fullCanvas, &fresh);
+    identical = memcmp(incremental.pixels(), full.pixels(), bytes) == 0;
+  }
+  freePatternRenderer(&renderer);
+  freePatternRenderer(&fresh);
+  return identical;
+}
+
+// Frame scheduler on a scripted clock: waiting lands a fixed latency after the deadline,
+// and each frame's work advances the clock by a scripted amount
+struct ScriptedClock
+{
+  uint32_t now;
+  uint32_t wakeLatencyUs;
+};
+
+static uint32_t scriptedNow(void *ctx)
+{
+  return ((ScriptedClock *)ctx)->now;
+}
+
+static void scriptedWaitUntil(void *ctx, uint32_t deadlineUs)
+{
+  ScriptedClock *clock = (ScriptedClock *)ctx;
+  clock->now = deadlineUs + clock->wakeLatencyUs;
+}
+
+// One scripted frame: its work, and the slots dropped and start jitter it must see
+struct ScriptedFrame
+{
+  uint32_t workUs;
+  uint32_t dropped;
+  uint32_t jitterUs;
+};
+
+// 100 fps with a 5 us wake-up latency. Frame 1 overruns by one and a half periods (one
+// slot dropped, the next frame 5005 us late), frame 3 ends exactly on the next deadline
+// (on time, no wait) and frame 4 overruns by exactly two periods.
+#define SCRIPT_PERIOD_US 10000
+#define SCRIPT_LATENCY_US 5
+static const ScriptedFrame schedulerScript[] = {
+    {2000, 0, 0}, {25000, 0, 5}, {3000, 1, 5005}, {9995, 0, 5}, {30000, 0, 0}, {1000, 2, 0}, {2000, 0, 5}};
+
+// Run the script from `startUs` (the first frame anchors the timeline there), then a long
+// steady stretch, checking every frame against it
+static void checkScheduler(uint32_t startUs)
+{
+  ScriptedClock scripted = {startUs, SCRIPT_LATENCY_US};
+  SchedulerClock clock = {scriptedNow, scriptedWaitUntil, &scripted};
+  FrameScheduler scheduler;
+  frameSchedulerInit(&scheduler, 1000000 / SCRIPT_PERIOD_US, &clock);
+
+  const int scriptLength = sizeof(schedulerScript) / sizeof(schedulerScript[0]);
+  uint32_t dropped = 0, jitterTotal = 0, jitterMax = 0, workMin = UINT32_MAX, workMax = 0;
+  bool perFrame = true;
+  for (int i = 0; i < scriptLength; i++)
+  {
+    const ScriptedFrame &frame = schedulerScript[i];
+    perFrame &= frameSchedulerBeginFrame(&scheduler) == frame.dropped && scheduler.stats.lastJitterUs == frame.jitterUs;
+    scripted.now += frame.workUs;
+    frameSchedulerEndFrame(&scheduler);
+    dropped += frame.dropped;
+    jitterTotal += frame.jitterUs;
+    jitterMax = frame.jitterUs > jitterMax ? frame.jitterUs : jitterMax;
+    workMin = frame.workUs < workMin ? frame.workUs : workMin;
+    workMax = frame.workUs > workMax ? frame.workUs : workMax;
+  }
+
+  const FrameStats &stats = scheduler.stats;
+  hostBenchCheck(perFrame && stats.frames == (uint32_t)scriptLength && stats.droppedFrames == dropped &&
+                     stats.overruns == 2,
+                 "scheduler from %u us: %u frames, %u slots dropped in %u overruns", startUs, stats.frames,
+                 stats.droppedFrames, stats.overruns);
+  hostBenchCheck(stats.maxJitterUs == jitterMax && frameSchedulerAverageJitterUs(&scheduler) == jitterTotal / scriptLength,
+                 "scheduler from %u us: jitter max %u us, mean %u us", startUs, stats.maxJitterUs,
+                 frameSchedulerAverageJitterUs(&scheduler));
+  hostBenchCheck(stats.minFrameUs == workMin && stats.maxFrameUs == workMax, "scheduler from %u us: frame time %u-%u us",
+                 startUs, stats.minFrameUs, stats.maxFrameUs);
+
+  // A long on-time stretch: every frame starts exactly the wake latency after its slot,
+  // so the deadlines stay on the grid laid down by the first frame
+  const uint32_t steadyFrames = 100000;
+  bool onGrid = true;
+  for (uint32_t i = 0; i < steadyFrames; i++)
+  {
+    frameSchedulerBeginFrame(&scheduler);
+    uint32_t slot = (scheduler.frameStartUs - startUs) / SCRIPT_PERIOD_US;
+    onGrid &= scheduler.frameStartUs - startUs == slot * SCRIPT_PERIOD_US + SCRIPT_LATENCY_US;
+    scripted.now += 3333;
+    frameSchedulerEndFrame(&scheduler);
+  }
+  uint32_t slots = stats.frames + stats.droppedFrames;
+  hostBenchCheck(onGrid && stats.droppedFrames == dropped &&
+                     scheduler.nextDeadlineUs - startUs == slots * SCRIPT_PERIOD_US,
+                 "scheduler from %u us: deadline after %u slots is start + %u us", startUs, slots,
+                 scheduler.nextDeadlineUs - startUs);
+}
+
+// The cell hash the sketch used before cellHash(): the fractional part of a scaled
+// double-precision sin()
+static bool isEvenCellFilledSin(int globalX, int globalY, int seed)
+{
+  float hash = sin(globalX * 12.9898 + globalY * 78.233 + seed * 45.164) * 43758.5453;
+  hash = hash - floor(hash);
+  return hash >= 0.5;
+}
+
+// Fraction of cells isEvenCellFilled() fills over a grid of coordinates and seeds
+#define FILL_GRID 256
+#define FILL_SEEDS 64
+
+static double cellFillFraction()
+{
+  uint32_t filled = 0;
+  for (int seed = 1; seed <= FILL_SEEDS; seed++)
+    for (int x = 0; x < FILL_GRID; x++)
+      for (int y = 0; y < FILL_GRID; y++)
+        filled += isEvenCellFilled(x, y, seed);
+  return (double)filled / ((uint32_t)FILL_GRID * FILL_GRID * FILL_SEEDS);
+}
+
+// One frame's worth of cells of the sketch's grid, each hashed with the frame as seed
+// (ctx non-null = the sin() hash)
+static PatternRenderer hashGrid = PATTERN_RENDERER_INIT;
+static volatile uint32_t hashSink;
+
+static void benchCellHash(void *ctx, uint32_t frame)
+{
+  uint32_t filled = 0;
+  for (int x = 0; x < hashGrid.cellsX; x++)
+    for (int y = 0; y < hashGrid.cellsY; y++)
+      filled += ctx ? isEvenCellFilledSin(x, y, frame + 1) : isEvenCellFilled(x, y, frame + 1);
+  hashSink = filled;
+}
+
+// Display bring-up inside setup(), and the first frame after it at exactly the delays
+// setup() waits out
+static void checkBootTrace()
+{
+  const BootEvent *setupPhase = bootTraceFind(&boot_trace, "setup");
+  const BootEvent *displayPhase = bootTraceFind(&boot_trace, "display");
+  const BootEvent *firstFrame = bootTraceFind(&boot_trace, "first frame");
+  bool ordered = setupPhase && displayPhase && setupPhase->done && displayPhase->done &&
+                 setupPhase < displayPhase && displayPhase->startUs >= setupPhase->startUs &&
+                 displayPhase->endUs <= setupPhase->endUs;
+  uint32_t firstFrameUs = ordered && firstFrame ? firstFrame->startUs - setupPhase->startUs : 0;
+  hostBenchCheck(ordered && firstFrame && firstFrame->startUs >= setupPhase->endUs &&
+                     firstFrameUs == BOOT_FIRST_FRAME_US,
+                 "boot trace: phases %s, first frame %s at %u us (expected %u)", ordered ? "in order" : "out of order",
+                 firstFrame ? "shown" : "missing", firstFrameUs, BOOT_FIRST_FRAME_US);
+}
+
+int main(int argc, char **argv)
+{
+  BenchOptions options;
+  if (!hostBenchParseArgs(argc, argv, &options))
+    return 1;
+
+  randomSeed(1);
+  // Boot phases run on the simulated clock: only the delays they wait out take time
+  boot_trace.now = hostClockNow;
+  setup();
+
+  // Same rate, but waiting for a deadline advances virtual time instead of sleeping
+  SchedulerClock clock = {hostClockNow, hostClockWaitUntil, nullptr};
+  frameSchedulerInit(&frame_scheduler, 1000000 / frame_scheduler.periodUs, &clock);
+
+  hostBenchPrintHeader();
+  Wall sketchWall = {dma_display, canvas, PATTERN_RENDERER_INIT};
+  benchWall("renderPatterns", &sketchWall, &options);
+
+  // Walls of 1, 4 and 16 panels: full frames scale with the wall, incremental ones should not
+  benchPanelWall(1, 1, &options);
+  benchPanelWall(2, 2, &options);
+  benchPanelWall(4, 4, &options);
+
+  // The integer cell hash against the sin() one it replaced, over the sketch's grid
+  double hashNs[2] = {};
+  if (patternRendererInit(&hashGrid, &canvas))
+  {
+    BenchResult result;
+    if (hostBenchRun("cellHash/integer", dma_display, benchCellHash, nullptr, &options, &result))
+      hashNs[0] = result.nsPerFrame;
+    if (hostBenchRun("cellHash/sin", dma_display, benchCellHash, (void *)1, &options, &result))
+      hashNs[1] = result.nsPerFrame;
+  }
+
+  // Capture frames from the sketch's panel (through a copy of its canvas, so loop() still
+  // starts from a fully dirty one), then stream them to a second panel
+  StreamBench stream;
+  stream.display = new MatrixPanel_I2S_DMA(HUB75_I2S_CFG(canvas.panelWidth, canvas.panelHeight, canvas.panelCount));
+  stream.width = dma_display->panelWidthPx();
+  stream.height = dma_display->panelHeightPx();
+  stream.matches = 0;
+  stream.display->begin();
+  size_t streamPixels = (size_t)stream.width * stream.height;
+  stream.source = (uint16_t *)malloc(streamPixels * 2 * STREAM_BENCH_FRAMES);
+  stream.frame = (uint16_t *)calloc(streamPixels, 2);
+  double streamFps = 0, streamBytes = 0;
+  PatternRenderer renderer = PATTERN_RENDERER_INIT;
+  VirtualCanvas captureCanvas = canvas;
+  bool captured = stream.source && stream.frame && patternRendererInit(&renderer, &captureCanvas);
+  if (captured)
+  {
+    dma_display->clearScreen();
+    canvasMarkAllDirty(&captureCanvas);
+    randomSeed(1);
+    for (int i = 0; i < STREAM_BENCH_FRAMES; i++)
+    {
+      setPatternSeed(&renderer, random(renderer.patternsX), random(renderer.patternsY), i + 1);
+      renderPatterns(dma_display, &captureCanvas, &renderer);
+      capturePanel565(dma_display, stream.source + i * streamPixels);
+    }
+    BenchResult result;
+    if (hostStreamStart(&stream.link, stream.source, STREAM_BENCH_FRAMES, stream.width, stream.height,
+                        options.frames))
+    {
+      if (hostBenchRun("stream/patterns", stream.display, benchStream, &stream, &options, &result))
+      {
+        streamFps = 1e9 / result.nsPerFrame;
+        streamBytes = (double)stream.link.receiver.bytesReceived / stream.link.receiver.packetsReceived;
+      }
+      hostStreamStop(&stream.link);
+    }
+  }
+  freePatternRenderer(&renderer);
+
+  dma_display->clearScreen();
+  randomSeed(1);
+  profilerReset();
+  hostBenchRun("loop", dma_display, benchLoop, nullptr, &options);
+
+  // Per-stage timings of the loop() case, as the sketch reports them over Serial
+  if (options.profile)
+    profilerDumpCsv(printReport, nullptr);
+
+  if (hostBenchSelected(&options, "loop"))
+    checkBootTrace();
+  randomSeed(1);
+  hostBenchCheck(checkIncrementalRedraw(2000), "incremental renderPatterns identical to a full redraw (2000 seed changes)");
+
+  // Once from an ordinary time, once just before the 32-bit microsecond clock wraps
+  checkScheduler(1000);
+  checkScheduler(UINT32_MAX - 15000);
+
+  double fill = cellFillFraction();
+  hostBenchCheck(fabs(fill - 0.5) <= 0.01, "isEvenCellFilled fills %.3f%% of %u cells (50%% +/- 1%%)", fill * 100,
+                 (uint32_t)FILL_GRID * FILL_GRID * FILL_SEEDS);
+
+  int layouts = 0;
+  int mapped = countCanvasLayouts(&layouts);
+  printf("\ncanvas layouts mapping one to one (chains, grids, snaking, rotations): %d/%d", mapped, layouts);
+  if (streamFps)
+    printf("\nstream (patterns, %d frames looped): %.0f bytes/frame (full frame %zu), %u/%u frames identical, %.0f "
+           "fps over pty; fps at 921600 baud %.1f, 2000000 baud %.1f",
+           STREAM_BENCH_FRAMES, streamBytes, streamMaxPacketSize(stream.width, stream.height), stream.matches,
+           options.frames, streamFps, 92160 / streamBytes, 200000 / streamBytes);
+  if (hashNs[0] && hashNs[1])
+    printf("\ncell hash (%dx%d cells per frame): integer %.0f ns, sin() %.0f ns (%.1fx)", hashGrid.cellsX,
+           hashGrid.cellsY, hashNs[0], hashNs[1], hashNs[1] / hashNs[0]);
+  // Colour depth: the levels actually drawn (from the captured frames) against what the
+  // sketch asked for, and the library's defaults (8 planes) at the same clock
+  if (captured)
+  {
+    ColorLevels levels = COLOR_LEVELS_INIT;
+    colorLevelsAddRGB565(&levels, stream.source, streamPixels * STREAM_BENCH_FRAMES);
+    ColorDepthPanel depthPanel = {(uint16_t)canvas.panelWidth, (uint16_t)canvas.panelHeight, canvas.panelCount, 1,
+                                  true};
+    ColorDepthTiming drawn = colorDepthChoose(&levels, &depth_profile, &depthPanel);
+    ColorDepthTiming full = colorDepthTiming(&depthPanel, 8, drawn.i2sHz, depth_profile.minRefreshHz);
+    printf("\ncolour depth: sketch %d bits; frames use %d levels -> %d bits at %u MHz, %u Hz, %u DMA bytes (8 bits: "
+           "%u Hz, %u bytes, transition bit %d)",
+           dma_display->getPixelColorDepthBits(), colorLevelsCount(&levels), drawn.bits, drawn.i2sHz / 1000000,
+           drawn.refreshHz, drawn.dmaBytes, full.refreshHz, full.dmaBytes, full.transitionBit);
+  }
+
+  const BootEvent *setupPhase = bootTraceFind(&boot_trace, "setup");
+  const BootEvent *displayPhase = bootTraceFind(&boot_trace, "display");
+  printf("\nboot (simulated clock): setup %u us of which display %u us, first frame %s",
+         setupPhase ? setupPhase->endUs - setupPhase->startUs : 0,
+         displayPhase ? displayPhase->endUs - displayPhase->startUs : 0,
+         bootTraceFind(&boot_trace, "first frame") ? "shown" : "missing");
+  printf("\n");
+
+  freePatternRenderer(&hashGrid);
+  delete stream.display;
+  free(stream.source);
+  free(stream.frame);
+  return hostBenchFailures() ? 1 : 0;
+}
@@ -1,5 +1,10 @@
 
 #include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include "pattern_renderer.h"
+#include <frame_scheduler.h>
+#include <frame_profiler.h>
+#include <boot_trace.h>
+#include <color_depth.h>
 
 // Configure for your panel(s) as appropriate!
 #define PANEL_WIDTH 64
@@ -7,29 +12,47 @@
 #define PANELS_NUMBER 1 // Number of chained panels, if just a single panel, obviously set to 1
 #define PIN_E 18
 
-#define PANE_WIDTH PANEL_WIDTH *PANELS_NUMBER
-#define PANE_HEIGHT PANEL_HEIGHT
+// How the chained panels form the wall (see virtual_canvas.h)
+#define PANEL_COLUMNS PANELS_NUMBER // Panels across; PANELS_NUMBER / PANEL_COLUMNS rows
+#define PANEL_SERPENTINE false      // true if odd rows are cabled right to left, mounted upside down
+
+#define TARGET_FPS 60         // Frames start on fixed 1/60 s deadlines
+#define STATS_INTERVAL 10000  // Print frame timing every 10 s
+
+// Colour depth and clock (see color_depth.h): the patterns are pure black and white, so
+// the controller picks the fewest bit planes and the slowest clock for this refresh floor.
+// HZ_8M stays the ceiling: 3.3V signals on 5V HUB75 inputs are marginal above it.
+#define MIN_REFRESH_HZ 60
+ColorDepthProfile depth_profile = {COLOR_DEPTH_MIN_BITS, 8, MIN_REFRESH_HZ, HUB75_I2S_CFG::HZ_8M};
+
+// 1 = trust begin() and clear the panel once; 0 = the original settle delays and repeated
+// clears. Either way the boot phases are traced and printed with the first frame.
+#ifndef FAST_BOOT
+#define FAST_BOOT 1
+#endif
 
 // placeholder for the matrix object
 MatrixPanel_I2S_DMA *dma_display = nullptr;
+FrameScheduler frame_scheduler;
+unsigned long last_stats_print = 0;
 
 unsigned long last_pattern_change = 0;
 int randomization_seed = 0;
-int pattern_seeds[2][2] = {{0, 0}, {0, 0}};
 int target_pattern_x = 0;
 int target_pattern_y = 0;
 
-// Simple hash function to generate deterministic random bool from coordinates + seed
-bool isEvenCellFilled(int globalX, int globalY, int seed)
-{
-  // Use a simple hash function based on global cell coordinates and seed
-  float hash = sin(globalX * 12.9898 + globalY * 78.233 + seed * 45.164) * 43758.5453;
-  hash = hash - floor(hash); // Get fractional part (0.0 to 1.0)
-  return hash >= 0.5;        // 50% chance to be filled
-}
+// The wall as one drawing surface, with a dirty bit per panel
+VirtualCanvas canvas = VIRTUAL_CANVAS_INIT;
+
+// Tracks what is on the panels so loop() only redraws cells that changed
+PatternRenderer pattern_renderer = PATTERN_RENDERER_INIT;
+
+// When each step of setup() ran, up to the first frame ('t' over Serial prints it again)
+BootTrace boot_trace = {};
 
 void setup()
 {
+  uint8_t setup_phase = bootPhaseBegin(&boot_trace, "setup");
 
   Serial.begin(115200);
 
@@ -47,19 +70,32 @@ void setup()
   mxconfig.gpio.e = PIN_E;                  // we MUST assign pin e to some free pin on a board to drive 64 pix height panels with 1/32 scan
   mxconfig.driver = HUB75_I2S_CFG::FM6126A; // in case that we use panels based on FM6126A chip, we can change that
 
-  // Try slower I2S speed to reduce signal integrity issues with 3.3V ESP32 signals
-  mxconfig.i2sspeed = HUB75_I2S_CFG::HZ_8M; // Default is HZ_10M, try slower: HZ_8M
+  // Only black and white are ever drawn: two levels need the fewest planes, which leaves
+  // refresh to spare at the slow clock that helps signal integrity with 3.3V ESP32 signals
+  ColorLevels levels = COLOR_LEVELS_INIT;
+  colorLevelsAdd(&levels, 0);
+  colorLevelsAdd(&levels, 255);
+  ColorDepthPanel depth_panel = {PANEL_WIDTH, PANEL_HEIGHT, PANELS_NUMBER, 1, true};
+  ColorDepthTiming depth = colorDepthChoose(&levels, &depth_profile, &depth_panel);
+  mxconfig.i2sspeed = (HUB75_I2S_CFG::clk_speed)depth.i2sHz;
+  mxconfig.min_refresh_rate = MIN_REFRESH_HZ;
 
   // OK, now we can create our matrix object
+  uint8_t phase = bootPhaseBegin(&boot_trace, "display");
   dma_display = new MatrixPanel_I2S_DMA(mxconfig);
+  dma_display->setPixelColorDepthBits(depth.bits); // Before begin(), which sizes the DMA buffers
 
   // Reduce brightness to 50% - can help with signal integrity issues
   dma_display->setBrightness8(128); // range is 0-255, trying 50% instead of 75%
 
-  // Allocate memory and start DMA display
+  // Allocate memory and start DMA display. begin() also sends the FM6126A its
+  // configuration and starts DMA from zeroed buffers, so the panel is ready when it returns.
   if (not dma_display->begin())
     Serial.println("****** !KABOOM! I2S memory allocation failed ***********");
 
+#if FAST_BOOT
+  dma_display->clearScreen();
+#else
   // FM6126A panels need extra initialization time
   Serial.println("Initializing FM6126A driver...");
   delay(100); // Give FM6126A time to initialize properly
@@ -70,99 +106,94 @@ void setup()
   dma_display->fillScreenRGB888(0, 0, 0);
   delay(50);
   dma_display->clearScreen();
+#endif
+  bootPhaseEnd(&boot_trace, phase);
+
+  Serial.print("Colour depth: ");
+  Serial.print(depth.bits);
+  Serial.print(" bits, I2S ");
+  Serial.print(depth.i2sHz / 1000000);
+  Serial.print(" MHz, refresh ");
+  Serial.print(depth.refreshHz);
+  Serial.print(" Hz, DMA ");
+  Serial.print(depth.dmaBytes);
+  Serial.println(" bytes");
+
+  // Patterns fill the whole wall; every panel starts dirty, so the first frame draws it all
+  canvasInitGrid(&canvas, PANEL_WIDTH, PANEL_HEIGHT, PANEL_COLUMNS, PANELS_NUMBER / PANEL_COLUMNS, 0, PANEL_SERPENTINE);
+  if (!patternRendererInit(&pattern_renderer, &canvas))
+    Serial.println("****** Pattern grid does not fit the panels ***********");
 
   Serial.println("Starting letter pattern effect...");
+
+  frameSchedulerInit(&frame_scheduler, TARGET_FPS);
+  bootPhaseEnd(&boot_trace, setup_phase);
+}
+
+// Profiler reports and the boot trace go straight out of the serial port
+void serialWrite(void *, const uint8_t *data, size_t length)
+{
+  Serial.write(data, length);
 }
 
 void loop()
 {
+  // Pace the loop on fixed deadlines instead of spinning flat out
+  frameSchedulerBeginFrame(&frame_scheduler);
 
   // Every 200ms, pick a random pattern and randomize it once
-  if (millis() - last_pattern_change >= 100)
+  if (pattern_renderer.seeds && millis() - last_pattern_change >= 100)
   {
-    target_pattern_x = random(2);
-    target_pattern_y = random(2);
+    target_pattern_x = random(pattern_renderer.patternsX);
+    target_pattern_y = random(pattern_renderer.patternsY);
     randomization_seed++;
-    pattern_seeds[target_pattern_x][target_pattern_y] = randomization_seed;
+    setPatternSeed(&pattern_renderer, target_pattern_x, target_pattern_y, randomization_seed);
     last_pattern_change = millis();
   }
 
-  // Configuration: 2×2 grid of 7×7 cell patterns centered in 64×64 display
-  // Each pattern: 7 cells × 4px per cell = 28px
-  // 2 patterns: 2 × 28px = 56px
-  // Remaining: 64 - 56 = 8px → 4px padding on each side to center
-  const int CELL_SIZE = 4;
-  const int PATTERN_SIZE = 28;
-  const int OUTER_PADDING = 4;
+  // Draw only the cells of the re-seeded pattern that flipped; nothing at all between changes
+  {
+    PROFILE_SCOPE(PROFILE_PRESENT);
+    renderPatterns(dma_display, &canvas, &pattern_renderer);
+  }
+
+  // The first pass draws the whole wall: that is the end of boot
+  static bool boot_shown = false;
+  if (!boot_shown)
+  {
+    boot_shown = true;
+    bootTraceMark(&boot_trace, "first frame");
+    bootTracePrint(&boot_trace, serialWrite, nullptr);
+  }
+
+  frameSchedulerEndFrame(&frame_scheduler);
+  PROFILE_FRAME_END();
+
+  // Serial commands: 'p' profiler report as CSV, 'b' binary report, 'r' reset, 't' boot trace
+  while (Serial.available())
+  {
+    int command = Serial.read();
+    if (command == 't')
+      bootTracePrint(&boot_trace, serialWrite, nullptr);
+    else
+      profilerHandleCommand(command, serialWrite, nullptr);
+  }
 
-  for (int x = 0; x < PANE_WIDTH; x++)
+  if (millis() - last_stats_print >= STATS_INTERVAL)
   {
-    for (int y = 0; y < PANE_HEIGHT; y++)
-    {
-      // Check if we're in outer padding (to center the 56×56 grid in 64×64 display)
-      if (x < OUTER_PADDING || x >= (PANE_WIDTH - OUTER_PADDING) ||
-          y < OUTER_PADDING || y >= (PANE_HEIGHT - OUTER_PADDING))
-      {
-        // Outer padding - draw black
-        dma_display->drawPixelRGB888(x, y, 0, 0, 0);
-        continue;
-      }
-
-      // NOTE: Display is physically rotated, so swap X and Y
-      int contentX = y - OUTER_PADDING; // Use Y for horizontal, remove padding
-      int contentY = x - OUTER_PADDING; // Use X for vertical, remove padding
-
-      // Which pattern in the 2×2 grid? (0-1 on each axis)
-      int gridX = contentX / PATTERN_SIZE;
-      int gridY = contentY / PATTERN_SIZE;
-
-      // Position within the pattern
-      int patternLocalX = contentX % PATTERN_SIZE;
-      int patternLocalY = contentY % PATTERN_SIZE;
-
-      // Which cell of the 7×7 grid within this pattern?
-      int cellX = patternLocalX / CELL_SIZE;
-      int cellY = patternLocalY / CELL_SIZE;
-
-      uint8_t brightness = 0;
-
-      // Outer border cells are always black
-      if (cellX == 0 || cellX == 6 || cellY == 0 || cellY == 6)
-      {
-        brightness = 0;
-      }
-      else
-      {
-        // Inner 5×5 grid
-        bool isOddX = (cellX % 2) == 1;
-        bool isOddY = (cellY % 2) == 1;
-
-        if (isOddX && isOddY)
-        {
-          // 9 dots at odd positions - always white
-          brightness = 255;
-        }
-        else if ((cellX == 2 || cellX == 4) && (cellY == 2 || cellY == 4))
-        {
-          // 4 diagonal cells around center - always black
-          brightness = 0;
-        }
-        else
-        {
-          // Remaining even cells - random fill based on pattern seed
-          int globalCellX = gridX * 7 + cellX;
-          int globalCellY = gridY * 7 + cellY;
-          int seed = pattern_seeds[gridX][gridY];
-
-          if (isEvenCellFilled(globalCellX, globalCellY, seed))
-          {
-            brightness = 255;
-          }
-        }
-      }
-
-      // Draw pixel
-      dma_display->drawPixelRGB888(x, y, brightness, brightness, brightness);
-    }
+    Serial.print("Frames: ");
+    Serial.print(frame_scheduler.stats.frames);
+    Serial.print(" dropped: ");
+    Serial.print(frame_scheduler.stats.droppedFrames);
+    Serial.print(" avg us: ");
+    Serial.print(frameSchedulerAverageFrameUs(&frame_scheduler));
+    Serial.print(" max us: ");
+    Serial.print(frame_scheduler.stats.maxFrameUs);
+    Serial.print(" jitter avg/max us: ");
+    Serial.print(frameSchedulerAverageJitterUs(&frame_scheduler));
+    Serial.print("/");
+    Serial.println(frame_scheduler.stats.maxJitterUs);
+    frameSchedulerResetStats(&frame_scheduler);
+    last_stats_print = millis();
   }
 }
@@ -0,0 +1,217 @@
+#include "pattern_renderer.h"
+
+// 7×7 template table built from templateCell() at compile time, indexed [cellX][cellY]
+#define TEMPLATE_COLUMN(x) {templateCell(x, 0), templateCell(x, 1), templateCell(x, 2), templateCell(x, 3), \
+                            templateCell(x, 4), templateCell(x, 5), templateCell(x, 6)}
+static constexpr CellKind CELL_TEMPLATE[PATTERN_CELLS][PATTERN_CELLS] = {
+    TEMPLATE_COLUMN(0), TEMPLATE_COLUMN(1), TEMPLATE_COLUMN(2), TEMPLATE_COLUMN(3),
+    TEMPLATE_COLUMN(4), TEMPLATE_COLUMN(5), TEMPLATE_COLUMN(6)};
+
+// Integer hash based on global cell coordinates and seed: the inputs are spread with
+// odd multipliers, then mixed with the MurmurHash3 32-bit finalizer
+uint32_t cellHash(int globalX, int globalY, int seed)
+{
+  uint32_t h = (uint32_t)seed * 0x9E3779B9u;
+  h ^= (uint32_t)globalX * 0x85EBCA6Bu;
+  h ^= (uint32_t)globalY * 0xC2B2AE35u;
+
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35u;
+  h ^= h >> 16;
+  return h;
+}
+
+// Deterministic random bool from coordinates + seed
+bool isEvenCellFilled(int globalX, int globalY, int seed)
+{
+  return cellHash(globalX, globalY, seed) < CELL_FILL_THRESHOLD; // 50% chance to be filled
+}
+
+// Brightness of a cell (0 or 255) given its pattern's seed
+uint8_t cellBrightness(int globalCellX, int globalCellY, int seed)
+{
+  switch (CELL_TEMPLATE[globalCellX % PATTERN_CELLS][globalCellY % PATTERN_CELLS])
+  {
+  case CELL_WHITE:
+    return 255;
+  case CELL_RANDOM:
+    return isEvenCellFilled(globalCellX, globalCellY, seed) ? 255 : 0;
+  default:
+    return 0;
+  }
+}
+
+bool patternRendererInit(PatternRenderer *renderer, const VirtualCanvas *canvas)
+{
+  freePatternRenderer(renderer);
+
+  // Rotated display: pattern X counts down the canvas, pattern Y across it
+  int16_t patternsX = (canvas->height - 2 * OUTER_PADDING) / PATTERN_SIZE;
+  int16_t patternsY = (canvas->width - 2 * OUTER_PADDING) / PATTERN_SIZE;
+  if (patternsX <= 0 || patternsY <= 0)
+    return false;
+
+  renderer->patternsX = patternsX;
+  renderer->patternsY = patternsY;
+  renderer->cellsX = patternsX * PATTERN_CELLS;
+  renderer->cellsY = patternsY * PATTERN_CELLS;
+  renderer->grid.w = patternsY * PATTERN_SIZE;
+  renderer->grid.h = patternsX * PATTERN_SIZE;
+  renderer->grid.x = (canvas->width - renderer->grid.w) / 2;
+  renderer->grid.y = (canvas->height - renderer->grid.h) / 2;
+
+  size_t patterns = (size_t)patternsX * patternsY;
+  renderer->seeds = (int *)calloc(patterns, sizeof(int));
+  renderer->drawnSeeds = (int *)calloc(patterns, sizeof(int));
+  renderer->drawnCells = (uint8_t *)calloc((size_t)renderer->cellsX * renderer->cellsY, 1);
+  if (!renderer->seeds || !renderer->drawnSeeds || !renderer->drawnCells)
+  {
+    freePatternRenderer(renderer);
+    return false;
+  }
+  return true;
+}
+
+void freePatternRenderer(PatternRenderer *renderer)
+{
+  free(renderer->seeds);
+  free(renderer->drawnSeeds);
+  free(renderer->drawnCells);
+  *renderer = PATTERN_RENDERER_INIT;
+}
+
+// Fill a canvas rectangle with one grey level on the panels in `panels`: one display
+// call per panel it covers (the canvas maps it to chain coordinates, panel rotation
+// included, once per rectangle rather than per pixel). Returns the number of calls.
+static uint32_t fillCanvasRect(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const CanvasRect *rect,
+                               uint8_t brightness, uint32_t panels)
+{
+  return canvasFillRect(canvas, display, rect, display->color565(brightness, brightness, brightness), panels);
+}
+
+// Draw `count` cells of one brightness side by side, starting at (globalCellX, globalCellY)
+// and running along cell Y. NOTE: Display is physically rotated, so X and Y are swapped:
+// the cells' horizontal position comes from cell Y, their vertical position from cell X,
+// and a run along cell Y is a horizontal strip on the canvas.
+static uint32_t drawCells(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const PatternRenderer *renderer,
+                          int globalCellX, int globalCellY, int count, uint8_t brightness, uint32_t panels)
+{
+  CanvasRect cells = {(int16_t)(renderer->grid.x + globalCellY * CELL_SIZE),
+                      (int16_t)(renderer->grid.y + globalCellX * CELL_SIZE), (int16_t)(count * CELL_SIZE), CELL_SIZE};
+  return fillCanvasRect(display, canvas, &cells, brightness, panels);
+}
+
+// Bring a cell up to date with its pattern's seed and return its brightness
+static uint8_t refreshCell(PatternRenderer *renderer, int gx, int gy)
+{
+  int seed = renderer->seeds[(gx / PATTERN_CELLS) * renderer->patternsY + gy / PATTERN_CELLS];
+  uint8_t brightness = cellBrightness(gx, gy, seed);
+  renderer->drawnCells[gx * renderer->cellsY + gy] = brightness;
+  return brightness;
+}
+
+// Redraw everything on one panel: the black padding around the grid, then every row of
+// cells that falls on it as runs of equal brightness, one fill per run (runs straddling
+// a seam are clipped to this panel). A 64×64 panel takes 4 padding fills and about 100
+// runs instead of 4096 pixels.
+static uint32_t drawPanel(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, PatternRenderer *renderer,
+                          uint8_t index)
+{
+  const CanvasRect *area = &canvas->panels[index].area;
+  const CanvasRect *grid = &renderer->grid;
+  uint32_t panel = (uint32_t)1 << index;
+  uint32_t calls = 0;
+
+  // Padding as four strips: above, below, left and right of the grid
+  const CanvasRect padding[4] = {
+      {0, 0, canvas->width, grid->y},
+      {0, (int16_t)(grid->y + grid->h), canvas->width, (int16_t)(canvas->height - grid->y - grid->h)},
+      {0, grid->y, grid->x, grid->h},
+      {(int16_t)(grid->x + grid->w), grid->y, (int16_t)(canvas->width - grid->x - grid->w), grid->h}};
+  for (int i = 0; i < 4; i++)
+  {
+    if (padding[i].w > 0 && padding[i].h > 0)
+      calls += fillCanvasRect(display, canvas, &padding[i], 0, panel);
+  }
+
+  CanvasRect cells;
+  if (!canvasIntersect(area, grid, &cells))
+    return calls;
+
+  // Range of cells under the panel; X runs down the canvas, Y across
+  int firstX = (cells.y - grid->y) / CELL_SIZE;
+  int lastX = (cells.y + cells.h - 1 - grid->y) / CELL_SIZE;
+  int firstY = (cells.x - grid->x) / CELL_SIZE;
+  int lastY = (cells.x + cells.w - 1 - grid->x) / CELL_SIZE;
+  for (int gx = firstX; gx <= lastX; gx++)
+  {
+    // Runs carry on across pattern borders: a black border cell joins its black neighbours
+    int runStart = firstY;
+    uint8_t runBrightness = refreshCell(renderer, gx, firstY);
+    for (int gy = firstY + 1; gy <= lastY; gy++)
+    {
+      uint8_t brightness = refreshCell(renderer, gx, gy);
+      if (brightness == runBrightness)
+        continue;
+      calls += drawCells(display, canvas, renderer, gx, runStart, gy - runStart, runBrightness, panel);
+      runStart = gy;
+      runBrightness = brightness;
+    }
+    calls += drawCells(display, canvas, renderer, gx, runStart, lastY + 1 - runStart, runBrightness, panel);
+  }
+  return calls;
+}
+
+// Redraw dirty panels, then only the cells whose brightness changed
+uint32_t renderPatterns(MatrixPanel_I2S_DMA *display, VirtualCanvas *canvas, PatternRenderer *renderer)
+{
+  uint32_t calls = 0;
+
+  // Dirty panels (all of them on the first frame): padding plus every cell, fixed ones
+  // included. This also brings their cells up to date with the current seeds.
+  for (uint8_t i = 0; i < canvas->panelCount; i++)
+  {
+    if (canvas->dirty & ((uint32_t)1 << i))
+      calls += drawPanel(display, canvas, renderer, i);
+  }
+  canvasClearDirty(canvas);
+
+  // Afterwards only patterns with a new seed are revisited, and within them only random
+  // cells whose brightness actually flipped are drawn, one fill each. Fixed cells never
+  // change, and no two random cells are side by side, so there are no runs to join.
+  for (int px = 0; px < renderer->patternsX; px++)
+  {
+    for (int py = 0; py < renderer->patternsY; py++)
+    {
+      int pattern = px * renderer->patternsY + py;
+      int seed = renderer->seeds[pattern];
+      if (seed == renderer->drawnSeeds[pattern])
+        continue;
+      renderer->drawnSeeds[pattern] = seed;
+
+      for (int cx = 0; cx < PATTERN_CELLS; cx++)
+      {
+        for (int cy = 0; cy < PATTERN_CELLS; cy++)
+        {
+          if (CELL_TEMPLATE[cx][cy] != CELL_RANDOM)
+            continue;
+
+          // One hash per random cell per seed change
+          int gx = px * PATTERN_CELLS + cx;
+          int gy = py * PATTERN_CELLS + cy;
+          uint8_t brightness = isEvenCellFilled(gx, gy, seed) ? 255 : 0;
+          uint8_t *drawn = &renderer->drawnCells[gx * renderer->cellsY + gy];
+          if (brightness == *drawn)
+            continue;
+
+          *drawn = brightness;
+          calls += drawCells(display, canvas, renderer, gx, gy, 1, brightness, CANVAS_ALL_PANELS);
+        }
+      }
+    }
+  }
+
+  return calls;
+}
@@ -0,0 +1,90 @@
+#ifndef PATTERN_RENDERER_H
+#define PATTERN_RENDERER_H
+
+#include <Arduino.h>
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include <virtual_canvas.h>
+
+// Configuration: a grid of 7×7 cell patterns centered on the canvas. Each pattern is
+// 7 cells × 4px per cell = 28px; as many fit as leave at least OUTER_PADDING of black
+// on every side. One 64×64 panel: 2 × 28px = 56px, 4px padding each side, a 2×2 grid.
+#define PATTERN_CELLS 7
+#define CELL_SIZE 4
+#define PATTERN_SIZE (PATTERN_CELLS * CELL_SIZE)
+#define OUTER_PADDING 4
+
+// Remembers what is already on the panels so that only changed cells are redrawn.
+// The panels keep their DMA buffer between calls, so untouched cells stay lit.
+//
+// NOTE: the display is physically rotated, so X and Y are swapped: cell X runs down the
+// canvas and cell Y across it. Patterns are indexed [patternX][patternY] the same way.
+struct PatternRenderer
+{
+  int16_t patternsX;   // Patterns down the canvas
+  int16_t patternsY;   // Patterns across the canvas
+  int16_t cellsX;      // patternsX * PATTERN_CELLS
+  int16_t cellsY;
+  CanvasRect grid;     // Canvas area covered by patterns; the rest is padding
+  int *seeds;          // Seed each pattern should show [patternX * patternsY + patternY]
+  int *drawnSeeds;     // Seed each pattern was last drawn with
+  uint8_t *drawnCells; // Brightness of each cell on the panels [globalCellX * cellsY + globalCellY]
+};
+
+// Empty renderer (patternRendererInit lays it out)
+#define PATTERN_RENDERER_INIT {0, 0, 0, 0, {0, 0, 0, 0}, nullptr, nullptr, nullptr}
+
+// Fit the pattern grid to the canvas and allocate its state (all seeds 0). Dirty
+// panels of the canvas are redrawn in full by the next renderPatterns().
+// Returns false if the canvas is too small for one pattern or allocation fails.
+bool patternRendererInit(PatternRenderer *renderer, const VirtualCanvas *canvas);
+
+// Release the renderer's state
+void freePatternRenderer(PatternRenderer *renderer);
+
+// Show pattern (patternX, patternY) with a new seed from the next renderPatterns()
+inline void setPatternSeed(PatternRenderer *renderer, int patternX, int patternY, int seed)
+{
+  renderer->seeds[patternX * renderer->patternsY + patternY] = seed;
+}
+
+// Kind of each cell in the fixed 7×7 pattern template
+enum CellKind : uint8_t
+{
+  CELL_BLACK,  // Always off
+  CELL_WHITE,  // Always on
+  CELL_RANDOM  // On or off depending on the pattern seed
+};
+
+// Template rules, evaluated at compile time:
+//   - outer border cells are always black
+//   - 9 dots at odd positions are always white
+//   - 4 diagonal cells around the center are always black
+//   - remaining even cells are random
+constexpr CellKind templateCell(int cellX, int cellY)
+{
+  return (cellX == 0 || cellX == 6 || cellY == 0 || cellY == 6)       ? CELL_BLACK
+         : ((cellX % 2) == 1 && (cellY % 2) == 1)                     ? CELL_WHITE
+         : ((cellX == 2 || cellX == 4) && (cellY == 2 || cellY == 4)) ? CELL_BLACK
+                                                                      : CELL_RANDOM;
+}
+
+// Fill threshold for random cells: a cell is filled when its 32-bit hash is below this.
+// 0x80000000 = 50% fill, 0x4CCCCCCD = 30% fill, etc.
+#define CELL_FILL_THRESHOLD 0x80000000UL
+
+// Deterministic 32-bit hash of global cell coordinates + seed (integer only, no FPU)
+uint32_t cellHash(int globalX, int globalY, int seed);
+
+// Deterministic random bool from global cell coordinates + seed
+bool isEvenCellFilled(int globalX, int globalY, int seed);
+
+// Brightness of a cell (0 or 255) given its pattern's seed
+uint8_t cellBrightness(int globalCellX, int globalCellY, int seed);
+
+// Redraw the canvas's dirty panels in full (padding and every cell on them, as runs of
+// equal cells) and clear their dirty bits, then draw only the cells whose brightness
+// changed since the last call. Every piece is one solid fill. Returns the number of
+// display calls (0 when nothing changed and the frame was skipped).
+uint32_t renderPatterns(MatrixPanel_I2S_DMA *display, VirtualCanvas *canvas, PatternRenderer *renderer);
+
+#endif
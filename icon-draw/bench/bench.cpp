@@ -0,0 +1,1702 @@
+// Native benchmark for icon-draw: pio run -e native, then from the project directory
+//   .pio/build/native/program [--frames N] [--dump DIR] [--only NAME] [--assets DIR] [--profile] [--verbose]
+// Links the real sketch (setup()/loop() in single-core mode) against native/HostShims.
+
+#include <Arduino.h>
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include <host_bench.h>
+#include <host_stream.h>
+#include <frame_scheduler.h>
+#include <frame_profiler.h>
+#include <boot_trace.h>
+#include <color_depth.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include "bmp_handler.h"
+#include "asset_archive.h"
+#include "crossfade.h"
+#include "frame_pipeline.h"
+#include "image_cache.h"
+#include "pixel_convert.h"
+#include "slideshow.h"
+
+// Sketch globals (main.cpp)
+extern MatrixPanel_I2S_DMA *dma_display;
+extern VirtualCanvas canvas;
+extern FrameScheduler frameScheduler;
+extern GlitchRenderer glitchRenderer;
+extern BootTrace bootTrace;
+extern ColorLevels contentLevels;
+extern ColorDepthProfile depthProfile;
+extern AssetArchive iconArchive;
+extern Slideshow slideshow;
+extern const char *imageFiles[];
+int imageCount();
+
+void setup();
+void loop();
+
+// Palettized BMPs written by scripts/make_bmp_fixtures.py, relative to the project
+// directory like data/. The indexed cases run on these (the shipped icons are 24-bit).
+#define BENCH_FIXTURE_DIR "bench/fixtures"
+static const char *fixtureFiles[] = {"/pal8.bmp", "/pal4.bmp", "/pal1.bmp"};
+#define FIXTURE_COUNT 3
+
+static GlitchFramebuffer benchFrame = GLITCH_FRAMEBUFFER_INIT;
+static GlitchFramebuffer benchOther = GLITCH_FRAMEBUFFER_INIT; // Second image for crossfades
+static AssetArchive benchArchive = {};
+static const char **benchFiles = imageFiles; // Images the per-format cases load
+static int benchFileCount = 0;
+
+static void benchDrawBMP(void *, uint32_t frame)
+{
+  drawBMP(dma_display, &canvas, imageFiles[frame % imageCount()], 0, 0);
+}
+
+static void benchLoadBMP(void *ctx, uint32_t frame)
+{
+  loadBMPToFramebuffer(benchFiles[frame % benchFileCount], &benchFrame, *(FramebufferFormat *)ctx);
+}
+
+// "/i0.bmp" -> "/i0.qoi"
+static std::string qoiName(int index)
+{
+  std::string name = imageFiles[index];
+  return name.substr(0, name.size() - 4) + ".qoi";
+}
+
+static void benchLoadQOI(void *ctx, uint32_t frame)
+{
+  loadQOIToFramebuffer(qoiName(frame % imageCount()).c_str(), &benchFrame, *(FramebufferFormat *)ctx);
+}
+
+static size_t fileSize(const std::string &path)
+{
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+// Every .qoi must decode to exactly the pixels of its BMP
+static int countQOIMatches(const char *assetDir)
+{
+  GlitchFramebuffer bmp = GLITCH_FRAMEBUFFER_INIT;
+  GlitchFramebuffer qoi = GLITCH_FRAMEBUFFER_INIT;
+  std::string dataDir = hostFsRoot();
+  int matches = 0;
+  for (int i = 0; i < imageCount(); i++)
+  {
+    hostSetFsRoot(dataDir.c_str());
+    bool ok = loadBMPToFramebuffer(imageFiles[i], &bmp);
+    hostSetFsRoot(assetDir);
+    ok = ok && loadQOIToFramebuffer(qoiName(i).c_str(), &qoi);
+    if (ok && framebufferSize(&bmp) == framebufferSize(&qoi) && memcmp(bmp.data, qoi.data, framebufferSize(&bmp)) == 0)
+      matches++;
+  }
+  hostSetFsRoot(dataDir.c_str());
+  freeFramebuffer(&bmp);
+  freeFramebuffer(&qoi);
+  return matches;
+}
+
+static void benchArchiveLoad(void *, uint32_t frame)
+{
+  assetArchiveLoad(&benchArchive, frame % assetArchiveCount(&benchArchive), &benchFrame, false);
+}
+
+static void benchPresent(void *, uint32_t)
+{
+  presentFramebuffer(dma_display, &canvas, &benchFrame, 0, 0);
+}
+
+static void benchGlitched(void *, uint32_t)
+{
+  drawFramebufferGlitched(dma_display, &canvas, &glitchRenderer, &benchFrame, 0, 0);
+}
+
+// Weight sweeps through a whole transition every 256 frames
+static void benchCrossfade(void *, uint32_t frame)
+{
+  crossfadeFramebuffer(&benchFrame, &benchOther, crossfadeWeight(FADE_SMOOTH, frame & 0xFF));
+}
+
+// Scalar float reference for crossfadeFramebuffer: one channel at a time
+static uint8_t mixFloat(uint8_t a, uint8_t b, float t)
+{
+  return (uint8_t)(a * (1.0f - t) + b * t + 0.5f);
+}
+
+static void crossfadeFloat(GlitchFramebuffer *fb, const GlitchFramebuffer *other, uint16_t weight)
+{
+  float t = (float)weight / FADE_ONE;
+  if (fb->format == FB_RGB565)
+  {
+    uint16_t *pixels = (uint16_t *)fb->data;
+    const uint16_t *others = (const uint16_t *)other->data;
+    for (size_t i = 0; i < fb->planeSize / 2; i++)
+    {
+      uint16_t a = pixels[i], b = others[i];
+      pixels[i] = (mixFloat(a >> 11, b >> 11, t) << 11) | (mixFloat((a >> 5) & 0x3F, (b >> 5) & 0x3F, t) << 5) |
+                  mixFloat(a & 0x1F, b & 0x1F, t);
+    }
+    return;
+  }
+  for (size_t i = 0; i < framebufferSize(fb); i++)
+    fb->data[i] = mixFloat(fb->data[i], other->data[i], t);
+}
+
+static void benchCrossfadeFloat(void *, uint32_t frame)
+{
+  crossfadeFloat(&benchFrame, &benchOther, crossfadeWeight(FADE_SMOOTH, frame & 0xFF));
+}
+
+// Largest channel difference (in the format's own channel units) between crossfadeFramebuffer and the float reference over
+// every weight
+static int crossfadeMaxError()
+{
+  GlitchFramebuffer swar = GLITCH_FRAMEBUFFER_INIT;
+  GlitchFramebuffer reference = GLITCH_FRAMEBUFFER_INIT;
+  allocateFramebuffer(&swar, benchFrame.width, benchFrame.height, benchFrame.format);
+  allocateFramebuffer(&reference, benchFrame.width, benchFrame.height, benchFrame.format);
+  size_t size = framebufferSize(&benchFrame);
+  int maxError = 0;
+  for (uint16_t weight = 0; weight <= FADE_ONE; weight++)
+  {
+    memcpy(swar.data, benchFrame.data, size);
+    memcpy(reference.data, benchFrame.data, size);
+    crossfadeFramebuffer(&swar, &benchOther, weight);
+    crossfadeFloat(&reference, &benchOther, weight);
+    if (swar.format == FB_RGB565)
+    {
+      const uint16_t *p = (const uint16_t *)swar.data, *q = (const uint16_t *)reference.data;
+      for (size_t i = 0; i < size / 2; i++)
+      {
+        int errors[3] = {abs((p[i] >> 11) - (q[i] >> 11)), abs(((p[i] >> 5) & 0x3F) - ((q[i] >> 5) & 0x3F)),
+                         abs((p[i] & 0x1F) - (q[i] & 0x1F))};
+        for (int e : errors)
+          maxError = e > maxError ? e : maxError;
+      }
+      continue;
+    }
+    for (size_t i = 0; i < size; i++)
+      maxError = abs(swar.data[i] - reference.data[i]) > maxError ? abs(swar.data[i] - reference.data[i]) : maxError;
+  }
+  freeFramebuffer(&swar);
+  freeFramebuffer(&reference);
+  return maxError;
+}
+
+// Conversion kernels: a whole panel's worth of pixels per frame as one long row
+#define CONVERT_PIXELS 4096
+alignas(4) static uint8_t convertIn[4][CONVERT_PIXELS * 3]; // BGR888 / R, G, B planes
+alignas(4) static uint16_t convert565[CONVERT_PIXELS];
+static Rgb565Lut convertLut;
+
+// Scalar references, one pixel at a time
+static void convertBGRScalar(uint16_t *out, const uint8_t *bgr, int16_t width)
+{
+  for (int16_t x = 0; x < width; x++, bgr += 3)
+    out[x] = ((bgr[2] & 0xF8) << 8) | ((bgr[1] & 0xFC) << 3) | (bgr[0] >> 3);
+}
+
+static void convertPlanarScalar(uint16_t *out, const uint8_t *r, const uint8_t *g, const uint8_t *b, int16_t width)
+{
+  for (int16_t x = 0; x < width; x++)
+    out[x] = ((r[x] & 0xF8) << 8) | ((g[x] & 0xFC) << 3) | (b[x] >> 3);
+}
+
+static void splitBGRScalar(uint8_t *r, uint8_t *g, uint8_t *b, const uint8_t *bgr, int16_t width)
+{
+  for (int16_t x = 0; x < width; x++, bgr += 3)
+  {
+    b[x] = bgr[0];
+    g[x] = bgr[1];
+    r[x] = bgr[2];
+  }
+}
+
+static void benchConvertBGR(void *ctx, uint32_t)
+{
+  (ctx ? convertBGRScalar : convertBGR888To565)(convert565, convertIn[0], CONVERT_PIXELS);
+}
+
+static void benchConvertRGB(void *, uint32_t)
+{
+  convertRGB888To565(convert565, convertIn[0], CONVERT_PIXELS);
+}
+
+static void benchConvertPlanar(void *ctx, uint32_t)
+{
+  (ctx ? convertPlanarScalar : convertPlanarTo565)(convert565, convertIn[1], convertIn[2], convertIn[3], CONVERT_PIXELS);
+}
+
+static void benchSplitBGR(void *ctx, uint32_t)
+{
+  (ctx ? splitBGRScalar : splitBGR888)(convertIn[1], convertIn[2], convertIn[3], convertIn[0], CONVERT_PIXELS);
+}
+
+// Every kernel against the scalar formula for all 2^24 colours (aligned rows of 256),
+// then on unaligned pointers and every tail length. Returns the kernels that match.
+static int countConvertMatches(int *kernels)
+{
+  alignas(4) static uint8_t bgr[256 * 3 + 4], rgb[256 * 3 + 4], planes[3][256 + 4], bytes[3][256 * 3 + 4];
+  alignas(4) static uint16_t out[256 + 2];
+  bool ok[7] = {true, true, true, true, true, true, true};
+  *kernels = 7;
+
+  for (int offset = 0; offset < 4; offset++)
+  {
+    for (int color = 0; color < (1 << 24); color += 256)
+    {
+      // The full sweep runs aligned; offsets 1-3 sample every 4097th row at odd widths
+      if (offset && color % (4097 * 256))
+        continue;
+      int16_t width = offset ? 256 - offset : 256;
+      uint8_t *src = bgr + offset, *srcRgb = rgb + offset;
+      uint8_t *r = planes[0] + offset, *g = planes[1] + offset, *b = planes[2] + offset;
+      for (int i = 0; i < width; i++)
+      {
+        uint8_t cr = color >> 16, cg = color >> 8, cb = i;
+        src[i * 3] = srcRgb[i * 3 + 2] = b[i] = cb;
+        src[i * 3 + 1] = srcRgb[i * 3 + 1] = g[i] = cg;
+        src[i * 3 + 2] = srcRgb[i * 3] = r[i] = cr;
+      }
+      uint16_t *dst = out + (offset & 1);
+
+      convertBGR888To565(dst, src, width);
+      for (int i = 0; i < width; i++)
+        ok[0] &= dst[i] == rgb565(src[i * 3 + 2], src[i * 3 + 1], src[i * 3]);
+      convertRGB888To565(dst, srcRgb, width);
+      for (int i = 0; i < width; i++)
+        ok[1] &= dst[i] == rgb565(src[i * 3 + 2], src[i * 3 + 1], src[i * 3]);
+      convertPlanarTo565(dst, r, g, b, width);
+      for (int i = 0; i < width; i++)
+        ok[2] &= dst[i] == rgb565(r[i], g[i], b[i]);
+      swapBGR888(bytes[0] + offset, src, width);
+      ok[3] &= memcmp(bytes[0] + offset, srcRgb, width * 3) == 0;
+      splitBGR888(bytes[0] + offset, bytes[1] + offset, bytes[2] + offset, src, width);
+      ok[4] &= memcmp(bytes[0] + offset, r, width) == 0 && memcmp(bytes[1] + offset, g, width) == 0 &&
+               memcmp(bytes[2] + offset, b, width) == 0;
+      convertBGR888To565Lut(dst, src, width, &convertLut);
+      for (int i = 0; i < width; i++)
+        ok[5] &= dst[i] == (convertLut.r[r[i]] | convertLut.g[g[i]] | convertLut.b[b[i]]);
+      convertPlanarTo565Lut(dst, r, g, b, width, &convertLut);
+      for (int i = 0; i < width; i++)
+        ok[6] &= dst[i] == (convertLut.r[r[i]] | convertLut.g[g[i]] | convertLut.b[b[i]]);
+    }
+  }
+
+  int matches = 0;
+  for (bool k : ok)
+    matches += k;
+  return matches;
+}
+
+// Stream seed of every glitch case, so each is reproducible on its own (--only)
+#define BENCH_GLITCH_SEED 1
+
+static GlitchFramebuffer glitchTarget = GLITCH_FRAMEBUFFER_INIT;
+
+// Colour lookup of the bench's own composes (the sketch's renderer may be composing on its producer)
+static GlitchRenderer benchRenderer = GLITCH_RENDERER_INIT;
+
+// One effect alone, every frame
+static void benchEffect(void *ctx, uint32_t frame)
+{
+  const GlitchEffect effect = {*(GlitchEffectType *)ctx, 1, GLITCH_ALWAYS};
+  const GlitchEffectChain chain = {&effect, 1};
+  glitchCompose(&benchRenderer, &glitchTarget, &benchFrame, &chain, glitchFrameSeed(BENCH_GLITCH_SEED, frame));
+}
+
+static uint64_t fnv1a(const uint8_t *data, size_t size)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ data[i]) * 0x100000001b3ull;
+  return hash;
+}
+
+// Compose frames of the sketch's chain in order, then again from their seeds alone on
+// two threads at once, each with its own renderer: in order here, and in reverse order
+// into a fresh buffer on the other. Returns the frames that came out bit-identical on both.
+static int countGlitchReplays(int frames)
+{
+  uint64_t hashes[64];
+  if (frames > 64)
+    frames = 64;
+  for (int i = 0; i < frames; i++)
+  {
+    glitchCompose(&benchRenderer, &glitchTarget, &benchFrame, glitchRenderer.chain,
+                  glitchFrameSeed(BENCH_GLITCH_SEED, i));
+    hashes[i] = fnv1a(glitchTarget.data, framebufferSize(&glitchTarget));
+  }
+
+  static GlitchRenderer replayRenderer = GLITCH_RENDERER_INIT;
+  GlitchFramebuffer replay = GLITCH_FRAMEBUFFER_INIT;
+  bool reversed[64];
+  std::thread reverse([&]() {
+    for (int i = frames - 1; i >= 0; i--)
+    {
+      glitchCompose(&replayRenderer, &replay, &benchFrame, glitchRenderer.chain, glitchFrameSeed(BENCH_GLITCH_SEED, i));
+      reversed[i] = fnv1a(replay.data, framebufferSize(&replay)) == hashes[i];
+    }
+  });
+  bool forward[64];
+  for (int i = 0; i < frames; i++)
+  {
+    glitchCompose(&benchRenderer, &glitchTarget, &benchFrame, glitchRenderer.chain,
+                  glitchFrameSeed(BENCH_GLITCH_SEED, i));
+    forward[i] = fnv1a(glitchTarget.data, framebufferSize(&glitchTarget)) == hashes[i];
+  }
+  reverse.join();
+
+  int matches = 0;
+  for (int i = 0; i < frames; i++)
+    matches += forward[i] && reversed[i];
+  freeFramebuffer(&replay);
+  return matches;
+}
+
+// A wall of chained panels with the sketch's rotation, showing a glitched icon in the middle
+struct WallBench
+{
+  MatrixPanel_I2S_DMA *display;
+  VirtualCanvas canvas;
+  bool full; // Repaint the whole wall every frame instead of only the dirty panels
+};
+
+static void benchWallPresent(void *ctx, uint32_t frame)
+{
+  WallBench *wall = (WallBench *)ctx;
+  glitchCompose(&benchRenderer, &glitchTarget, &benchFrame, glitchRenderer.chain,
+                glitchFrameSeed(BENCH_GLITCH_SEED, frame));
+
+  CanvasRect rect = {(int16_t)((wall->canvas.width - glitchTarget.width) / 2),
+                     (int16_t)((wall->canvas.height - glitchTarget.height) / 2), glitchTarget.width,
+                     glitchTarget.height};
+  if (wall->full)
+  {
+    CanvasRect all = {0, 0, wall->canvas.width, wall->canvas.height};
+    canvasMarkAllDirty(&wall->canvas);
+    canvasFillRect(&wall->canvas, wall->display, &all, 0);
+  }
+  else
+  {
+    canvasMarkDirty(&wall->canvas, &rect);
+  }
+  presentFramebuffer(wall->display, &wall->canvas, &glitchTarget, rect.x, rect.y, wall->canvas.dirty);
+  canvasClearDirty(&wall->canvas);
+}
+
+// Dirty-panel and whole-wall repaints on a `columns` x `rows` wall of 64x64 panels
+// (snaking rows). Both end on the same picture, so their panel hashes match.
+static void benchWall(uint8_t columns, uint8_t rows, const BenchOptions *options)
+{
+  char name[48];
+  for (int full = 0; full <= 1; full++)
+  {
+    WallBench wall = {new MatrixPanel_I2S_DMA(HUB75_I2S_CFG(64, 64, columns * rows)), VIRTUAL_CANVAS_INIT, full != 0};
+    wall.display->begin();
+    canvasInitGrid(&wall.canvas, 64, 64, columns, rows, canvas.panels[0].rotation, true);
+    snprintf(name, sizeof(name), "canvas/%upanels/%s", columns * rows, full ? "full" : "dirty");
+    hostBenchRun(name, wall.display, benchWallPresent, &wall, options);
+    delete wall.display;
+  }
+}
+
+// Bit planes of the sketch's chain
+static BitplaneLayout benchLayout;
+static BitplaneFrame benchPlanes = BITPLANE_FRAME_INIT;
+
+static void benchEncode(void *, uint32_t)
+{
+  encodeFramebuffer(&benchLayout, benchPlanes.words, &canvas, &benchFrame, 0, 0);
+}
+
+// The library's per-pixel path (updateMatrixDMABuffer) for one physical pixel: bit
+// p + 16 - depth of each CIE 1931 corrected level goes to plane p, R1 G1 B1 for the upper
+// half of the panel, R2 G2 B2 for the lower, with each pair of columns swapped
+static void referencePlanes(const BitplaneLayout *layout, uint16_t *words, int16_t x, int16_t y, const uint8_t *rgb)
+{
+  static uint16_t luminance[256]; // The library's lumConvTab
+  static bool built = false;
+  if (!built)
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      double lightness = i * 100.0 / 255.0;
+      double level = lightness <= 8.0 ? lightness / 903.3 : pow((lightness + 16.0) / 116.0, 3.0);
+      luminance[i] = (uint16_t)lround(level * 65535.0);
+    }
+    built = true;
+  }
+
+  uint8_t offset = y >= layout->rows ? BITPLANE_RGB2_SHIFT : 0;
+  int16_t row = y % layout->rows, col = x ^ 1;
+  for (uint8_t p = 0; p < layout->depth; p++)
+  {
+    uint16_t mask = 1 << (p + 16 - layout->depth), bits = 0;
+    for (int c = 0; c < 3; c++)
+      bits |= (bool)(luminance[rgb[c]] & mask) << c;
+    words[((size_t)row * layout->depth + p) * layout->width + col] |= bits << offset;
+  }
+}
+
+// Present `frame` in the middle of `wall` pixel by pixel on a fresh display and encode it
+// into bit planes. True if the encoding equals the planes the library's per-pixel path
+// would build from the pixels the display was given.
+static bool bitplanesMatch(const VirtualCanvas *wall, const GlitchFramebuffer *frame)
+{
+  HUB75_I2S_CFG config(wall->panelWidth, wall->panelHeight, wall->panelCount);
+  MatrixPanel_I2S_DMA drawn(config);
+  drawn.begin();
+  int16_t x = (wall->width - frame->width) / 2, y = (wall->height - frame->height) / 2;
+  presentFramebuffer(&drawn, wall, frame, x, y);
+
+  BitplaneLayout layout;
+  BitplaneFrame planes = BITPLANE_FRAME_INIT, expected = BITPLANE_FRAME_INIT;
+  bitplaneLayoutInit(&layout, wall->panelWidth, wall->panelHeight, wall->panelCount, PIXEL_COLOR_DEPTH_BITS);
+  bool ok = allocateBitplaneFrame(&planes, &layout) && allocateBitplaneFrame(&expected, &layout);
+  ok = ok && encodeFramebuffer(&layout, planes.words, wall, frame, x, y) == (uint32_t)frame->width * frame->height;
+
+  for (int16_t py = 0; ok && py < drawn.panelHeightPx(); py++)
+  {
+    for (int16_t px = 0; px < drawn.panelWidthPx(); px++)
+      referencePlanes(&layout, expected.words, px, py, drawn.pixels() + ((size_t)py * drawn.panelWidthPx() + px) * 3);
+  }
+  ok = ok && memcmp(planes.words, expected.words, planes.count * sizeof(uint16_t)) == 0;
+  freeBitplaneFrame(&planes);
+  freeBitplaneFrame(&expected);
+  return ok;
+}
+
+// Every RGB565 colour once (256 x 256), for the encoder's colour tables
+static bool allColoursMatch(uint8_t columns, uint8_t rows)
+{
+  GlitchFramebuffer colours = GLITCH_FRAMEBUFFER_INIT;
+  if (!allocateFramebuffer(&colours, 256, 256, FB_RGB565))
+    return false;
+  uint16_t *pixels = (uint16_t *)colours.data;
+  for (uint32_t i = 0; i < 65536; i++)
+    pixels[i] = i;
+
+  VirtualCanvas wall = VIRTUAL_CANVAS_INIT;
+  canvasInitGrid(&wall, 64, 64, columns, rows, 0, true);
+  bool ok = bitplanesMatch(&wall, &colours);
+  freeFramebuffer(&colours);
+  return ok;
+}
+
+// Animation playback against the same frames as a sequence of full BMPs
+#define ANIM_BENCH_FRAMES 48
+#define ANIM_BENCH_FRAME_MS 100
+
+static GlitchFramebuffer animFrames[ANIM_BENCH_FRAMES];
+static GlitchFramebuffer animSequence = GLITCH_FRAMEBUFFER_INIT;
+static AnimPlayer animBench = {};
+
+static void put16(std::string *out, uint16_t value)
+{
+  out->push_back((char)(value & 0xFF));
+  out->push_back((char)(value >> 8));
+}
+
+// One span, run-length coded when that is smaller (as scripts/pack_icons.py encodes it)
+static void encodeSpan(std::string *out, int x, int y, const uint16_t *pixels, int count)
+{
+  std::string runs;
+  for (int i = 0; i < count;)
+  {
+    int run = 1;
+    while (i + run < count && pixels[i + run] == pixels[i] && run < 256)
+      run++;
+    runs.push_back((char)(run - 1));
+    put16(&runs, pixels[i]);
+    i += run;
+  }
+  bool rle = runs.size() < (size_t)count * 2;
+  put16(out, x);
+  put16(out, y);
+  put16(out, count | (rle ? ANIM_SPAN_RLE : 0));
+  if (rle)
+    out->append(runs);
+  else
+    for (int i = 0; i < count; i++)
+      put16(out, pixels[i]);
+}
+
+// The pack_icons.py --anim encoding: first frame whole, then per row the runs that
+// differ from the frame before, with gaps of up to 3 unchanged pixels merged
+static std::string encodeAnimation(const GlitchFramebuffer *frames, int count, uint16_t frameMs)
+{
+  int16_t width = frames[0].width, height = frames[0].height;
+  std::string out = "ICAN";
+  const uint16_t header[] = {ANIM_VERSION, (uint16_t)width, (uint16_t)height, (uint16_t)count, frameMs, 0};
+  for (uint16_t value : header)
+    put16(&out, value);
+
+  for (int i = 0; i < count; i++)
+  {
+    std::string spans;
+    uint16_t spanCount = 0;
+    for (int16_t y = 0; y < height; y++)
+    {
+      const uint16_t *row = (const uint16_t *)framebufferRow(&frames[i], y);
+      if (i == 0)
+      {
+        encodeSpan(&spans, 0, y, row, width);
+        spanCount++;
+        continue;
+      }
+      const uint16_t *prev = (const uint16_t *)framebufferRow(&frames[i - 1], y);
+      int start = -1, end = -1;
+      for (int x = 0; x <= width; x++)
+      {
+        bool differs = x < width && row[x] != prev[x];
+        if (differs && start >= 0 && x - end > 3)
+        {
+          encodeSpan(&spans, start, y, row + start, end - start);
+          spanCount++;
+          start = -1;
+        }
+        if (differs)
+        {
+          start = start < 0 ? x : start;
+          end = x + 1;
+        }
+      }
+      if (start >= 0)
+      {
+        encodeSpan(&spans, start, y, row + start, end - start);
+        spanCount++;
+      }
+    }
+    out.push_back((char)(i == 0 ? ANIM_FRAME_KEY : ANIM_FRAME_DELTA));
+    out.push_back(0);
+    put16(&out, spanCount);
+    put16(&out, spans.size() & 0xFFFF);
+    put16(&out, spans.size() >> 16);
+    out += spans;
+  }
+  return out;
+}
+
+// A 24-bit BMP of an RGB565 frame, expanded so it loads back as the same RGB565
+static bool writeBMP565(const char *path, const GlitchFramebuffer *frame)
+{
+  int rowBytes = (frame->width * 3 + 3) & ~3;
+  uint32_t size = 54 + rowBytes * frame->height;
+  uint8_t header[54] = {'B', 'M'};
+  const uint32_t fields[][2] = {{2, size}, {10, 54}, {14, 40}, {18, (uint32_t)frame->width},
+                                {22, (uint32_t)frame->height}, {26, 1 | (24 << 16)}, {34, size - 54}};
+  for (const auto &field : fields)
+    memcpy(header + field[0], &field[1], 4);
+
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+  fwrite(header, 1, sizeof(header), file);
+  std::string row(rowBytes, '\0');
+  for (int16_t y = frame->height - 1; y >= 0; y--)
+  {
+    const uint16_t *pixels = (const uint16_t *)framebufferRow(frame, y);
+    for (int16_t x = 0; x < frame->width; x++)
+    {
+      uint8_t r = pixels[x] >> 11, g = (pixels[x] >> 5) & 0x3F, b = pixels[x] & 0x1F;
+      row[x * 3] = (char)((b << 3) | (b >> 2));
+      row[x * 3 + 1] = (char)((g << 2) | (g >> 4));
+      row[x * 3 + 2] = (char)((r << 3) | (r >> 2));
+    }
+    fwrite(row.data(), 1, rowBytes, file);
+  }
+  return fclose(file) == 0;
+}
+
+// Frames with local motion: the icon with two glitch boxes moved each frame. Written to
+// `dir` as f00.bmp... and as anim.ica. Returns the animation's size, 0 on failure.
+static size_t writeAnimationAssets(const std::string &dir)
+{
+  static const GlitchEffect boxes = {GLITCH_BOX_SHIFT, 2, GLITCH_ALWAYS};
+  static const GlitchEffectChain chain = {&boxes, 1};
+  GlitchFramebuffer base = GLITCH_FRAMEBUFFER_INIT;
+  if (!loadBMPToFramebuffer(imageFiles[0], &base, FB_RGB565))
+    return 0;
+  mkdir(dir.c_str(), 0755);
+
+  char path[64];
+  bool ok = true;
+  for (int i = 0; i < ANIM_BENCH_FRAMES; i++)
+  {
+    animFrames[i] = GLITCH_FRAMEBUFFER_INIT;
+    ok = ok && glitchCompose(&benchRenderer, &animFrames[i], &base, &chain, glitchFrameSeed(BENCH_GLITCH_SEED, i));
+    snprintf(path, sizeof(path), "/f%02d.bmp", i);
+    ok = ok && writeBMP565((dir + path).c_str(), &animFrames[i]);
+  }
+  freeFramebuffer(&base);
+  if (!ok)
+    return 0; // Frames after a failed write were never composed
+
+  std::string animation = encodeAnimation(animFrames, ANIM_BENCH_FRAMES, ANIM_BENCH_FRAME_MS);
+  FILE *file = fopen((dir + "/anim.ica").c_str(), "wb");
+  ok = ok && file && fwrite(animation.data(), 1, animation.size(), file) == animation.size();
+  if (file)
+    ok = fclose(file) == 0 && ok;
+  return ok ? animation.size() : 0;
+}
+
+// Every frame of the animation decoded from memory, over two passes (so across the wrap),
+// against the frames it was encoded from. Returns the frames that came out identical.
+static int countAnimationMatches(const std::string &path)
+{
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file)
+    return 0;
+  std::string data;
+  char chunk[4096];
+  for (size_t got; (got = fread(chunk, 1, sizeof(chunk), file)) > 0;)
+    data.append(chunk, got);
+  fclose(file);
+
+  BmpMemorySource source = {(const uint8_t *)data.data(), data.size(), 0};
+  AnimPlayer player = {};
+  animPlayerInit(&player, bmpMemoryRead, animMemorySeek, &source);
+  int matches = 0;
+  if (animPlayerOpen(&player) == ANIM_OK)
+  {
+    for (int i = 0; i < ANIM_BENCH_FRAMES * 2; i++)
+    {
+      const GlitchFramebuffer *expected = &animFrames[i % ANIM_BENCH_FRAMES];
+      matches += animPlayerNextFrame(&player) == ANIM_OK && i >= ANIM_BENCH_FRAMES &&
+                 memcmp(player.frame.data, expected->data, framebufferSize(expected)) == 0;
+    }
+  }
+  freeAnimPlayer(&player);
+  return matches;
+}
+
+// The sketch's way of showing a still: decode the whole BMP, present the whole frame
+static void benchBMPSequence(void *, uint32_t frame)
+{
+  char path[16];
+  snprintf(path, sizeof(path), "/f%02u.bmp", (unsigned)(frame % ANIM_BENCH_FRAMES));
+  loadBMPToFramebuffer(path, &animSequence, FB_RGB565);
+  presentFramebuffer(dma_display, &canvas, &animSequence, (canvas.width - animSequence.width) / 2,
+                     (canvas.height - animSequence.height) / 2);
+}
+
+// Streamed delta playback: apply the next frame in place, present only its spans
+static void benchAnimPlay(void *, uint32_t)
+{
+  animPlayerNextFrame(&animBench);
+  const GlitchFramebuffer *fb = &animBench.frame;
+  presentFramebufferSpans(dma_display, &canvas, fb, &animBench.changed, (canvas.width - fb->width) / 2,
+                          (canvas.height - fb->height) / 2);
+}
+
+// Present a frame as row spans of 1-6 pixels (odd offsets included) and as a whole: the
+// panel must come out the same
+static bool spansMatchFull(const GlitchFramebuffer *frame)
+{
+  size_t panelBytes = (size_t)dma_display->panelWidthPx() * dma_display->panelHeightPx() * 3;
+  int16_t x = (canvas.width - frame->width) / 2, y = (canvas.height - frame->height) / 2;
+  dma_display->clearScreen();
+  presentFramebuffer(dma_display, &canvas, frame, x, y);
+  std::string full((const char *)dma_display->pixels(), panelBytes);
+
+  dma_display->clearScreen();
+  AnimSpanList spans = {};
+  for (int16_t row = 0; row < frame->height; row++)
+  {
+    for (int16_t x0 = 0, w; x0 < frame->width; x0 += w)
+    {
+      w = std::min<int16_t>(1 + (row + x0) % 6, frame->width - x0);
+      spans.spans[spans.count++] = {x0, row, w};
+      if (spans.count == ANIM_MAX_SPANS)
+      {
+        presentFramebufferSpans(dma_display, &canvas, frame, &spans, x, y);
+        spans.count = 0;
+      }
+    }
+  }
+  presentFramebufferSpans(dma_display, &canvas, frame, &spans, x, y);
+  bool same = memcmp(full.data(), dma_display->pixels(), panelBytes) == 0;
+  dma_display->clearScreen();
+  return same;
+}
+
+// Serial streaming: glitched frames of the first icon sent over a pty loopback, applied and
+// presented the way the sketch does (only the rectangle each packet changed)
+#define STREAM_BENCH_FRAMES 48
+
+static uint16_t *streamSource = nullptr; // STREAM_BENCH_FRAMES packed RGB565 frames
+static GlitchFramebuffer streamFrame = GLITCH_FRAMEBUFFER_INIT;
+static HostStreamLink streamLink;
+static uint32_t streamMatches = 0;
+
+// The sketch's glitch stream over the icon, as packed RGB565 frames
+static bool makeStreamFrames()
+{
+  GlitchFramebuffer icon = GLITCH_FRAMEBUFFER_INIT, glitched = GLITCH_FRAMEBUFFER_INIT;
+  bool ok = loadBMPToFramebuffer(imageFiles[0], &icon, FB_RGB565) &&
+            allocateFramebuffer(&streamFrame, icon.width, icon.height, FB_RGB565);
+  size_t pixels = (size_t)icon.width * icon.height;
+  if (ok)
+    streamSource = (uint16_t *)malloc(pixels * 2 * STREAM_BENCH_FRAMES);
+  ok = ok && streamSource;
+  for (int i = 0; ok && i < STREAM_BENCH_FRAMES; i++)
+  {
+    ok = glitchCompose(&benchRenderer, &glitched, &icon, glitchRenderer.chain,
+                       glitchFrameSeed(BENCH_GLITCH_SEED, i));
+    for (int16_t y = 0; ok && y < icon.height; y++)
+      memcpy(streamSource + i * pixels + (size_t)y * icon.width, framebufferRow(&glitched, y), icon.width * 2);
+  }
+  freeFramebuffer(&icon);
+  freeFramebuffer(&glitched);
+  return ok;
+}
+
+// Display side: take the next packet, apply it, hand the buffer back, present its rows
+static void benchStream(void *, uint32_t frame)
+{
+  const StreamPacket *packet = hostStreamWait(&streamLink);
+  if (!packet)
+    return;
+  StreamPacket applied = *packet;
+  bool ok = streamApply(packet, (uint16_t *)streamFrame.data, streamFrame.stride / 2, streamFrame.width,
+                        streamFrame.height);
+  streamRelease(&streamLink.receiver);
+  if (!ok)
+    return;
+
+  int16_t x = (canvas.width - streamFrame.width) / 2, y = (canvas.height - streamFrame.height) / 2;
+  for (uint16_t row = applied.y; row < applied.y + applied.h; row++)
+    presentRow565(dma_display, &canvas, (const uint16_t *)framebufferRow(&streamFrame, row) + applied.x, applied.w,
+                  x + applied.x, y + row);
+
+  const uint16_t *expected = streamSource + (frame % STREAM_BENCH_FRAMES) * streamFrame.width * streamFrame.height;
+  bool same = true;
+  for (int16_t row = 0; same && row < streamFrame.height; row++)
+    same = memcmp(framebufferRow(&streamFrame, row), expected + row * streamFrame.width, streamFrame.width * 2) == 0;
+  streamMatches += same;
+}
+
+// Channel levels of every icon as the panel receives them (RGB565 expanded to 8 bits).
+// Returns the number of icons read.
+static int iconLevels(ColorLevels *levels)
+{
+  GlitchFramebuffer icon = GLITCH_FRAMEBUFFER_INIT;
+  int read = 0;
+  for (int i = 0; i < imageCount(); i++)
+  {
+    if (!loadBMPToFramebuffer(imageFiles[i], &icon, FB_RGB565))
+      continue;
+    for (int16_t row = 0; row < icon.height; row++)
+      colorLevelsAddRGB565(levels, (const uint16_t *)framebufferRow(&icon, row), icon.width);
+    read++;
+  }
+  freeFramebuffer(&icon);
+  return read;
+}
+
+static void printReport(void *, const uint8_t *data, size_t length)
+{
+  fwrite(data, 1, length, stdout);
+}
+
+static void benchLoop(void *, uint32_t)
+{
+  loop();
+}
+
+// Framebuffer and whole-process heap activity so far
+struct FramebufferHeapCounts
+{
+  uint32_t allocations;
+  uint32_t frees;
+  uint64_t heapAllocations;
+};
+
+static FramebufferHeapCounts framebufferHeapCounts()
+{
+  return {framebufferAllocationCount(), framebufferFreeCount(), hostAllocationCount()};
+}
+
+// A case run since `before` allocated no framebuffer block (and, with `wholeHeap`, nothing
+// at all)
+static void checkNoFramebufferHeap(const char *name, FramebufferHeapCounts before, bool wholeHeap)
+{
+  FramebufferHeapCounts after = framebufferHeapCounts();
+  hostBenchCheck(after.allocations == before.allocations && after.frees == before.frees &&
+                     (!wholeHeap || after.heapAllocations == before.heapAllocations),
+                 "%s: %u framebuffer allocs, %u frees, %llu heap allocs after warm-up", name,
+                 after.allocations - before.allocations, after.frees - before.frees,
+                 (unsigned long long)(after.heapAllocations - before.heapAllocations));
+}
+
+// Deterministic generator for the checks' random inputs, in [min, max). Kept apart from
+// random() so the checks leave the sketch's sequence alone, and usable from any thread.
+static int32_t checkRandom(uint32_t *state, int32_t min, int32_t max)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return min + (int32_t)(x % (uint32_t)(max - min));
+}
+
+// Box shifts against the per-pixel modulo loop they replaced: the first cases wrap on
+// both axes and use offsets of 0 and of the whole image, the rest are random boxes
+struct ShiftCase
+{
+  int16_t x, y, w, h;
+  int16_t offsetX, offsetY;
+  int channel; // -1 = all
+};
+
+#define SHIFT_CASES 512
+static ShiftCase shiftCases[SHIFT_CASES];
+static GlitchFramebuffer shiftExpected = GLITCH_FRAMEBUFFER_INIT;
+
+static void makeShiftCases(int16_t width, int16_t height)
+{
+  const ShiftCase fixed[] = {
+      {(int16_t)(width - 5), (int16_t)(height - 7), (int16_t)(width / 2), (int16_t)(height / 2), 3, -2, -1},
+      {-10, -12, (int16_t)(width / 2), (int16_t)(height / 2), -3, 3, 1},
+      {5, 5, 20, 20, 0, 0, -1},
+      {(int16_t)(width - 1), (int16_t)(height - 1), 8, 8, 0, 0, 2},
+      {(int16_t)(width - 4), (int16_t)(height - 4), (int16_t)(width / 2), (int16_t)(height / 2), width, height, -1},
+      {(int16_t)(width - 4), (int16_t)(height - 4), (int16_t)(width / 2), (int16_t)(height / 2), (int16_t)-width,
+       (int16_t)-height, 0},
+      {3, 7, width, height, 1, 1, -1},
+      {(int16_t)-width, (int16_t)-height, width, height, width, (int16_t)-height, 1},
+  };
+  const int fixedCount = sizeof(fixed) / sizeof(fixed[0]);
+  uint32_t rng = 1;
+  for (int i = 0; i < SHIFT_CASES; i++)
+  {
+    if (i < fixedCount)
+    {
+      shiftCases[i] = fixed[i];
+      continue;
+    }
+    ShiftCase &c = shiftCases[i];
+    c.x = checkRandom(&rng, -2 * width, 2 * width);
+    c.y = checkRandom(&rng, -2 * height, 2 * height);
+    c.w = checkRandom(&rng, 1, width + 1);
+    c.h = checkRandom(&rng, 1, height + 1);
+    c.offsetX = checkRandom(&rng, -width, width + 1);
+    c.offsetY = checkRandom(&rng, -height, height + 1);
+    c.channel = checkRandom(&rng, -1, 3);
+  }
+}
+
+// The original shift: four modulo operations and a channel test per pixel
+static void shiftBoxPerPixel(GlitchFramebuffer *dst, const GlitchFramebuffer *src, const ShiftCase &c)
+{
+  int16_t width = src->width, height = src->height;
+  for (int16_t by = 0; by < c.h; by++)
+  {
+    for (int16_t bx = 0; bx < c.w; bx++)
+    {
+      int16_t dx = ((c.x + bx) % width + width) % width;
+      int16_t dy = ((c.y + by) % height + height) % height;
+      int16_t sx = ((c.x + bx + c.offsetX) % width + width) % width;
+      int16_t sy = ((c.y + by + c.offsetY) % height + height) % height;
+      for (uint8_t ch = 0; ch < 3; ch++)
+      {
+        if (c.channel >= 0 && c.channel != ch)
+          continue;
+        if (dst->format == FB_RGB888_PLANAR)
+          framebufferRow(dst, dy, ch)[dx] = framebufferRow(src, sy, ch)[sx];
+        else if (dst->format == FB_RGB888_INTERLEAVED)
+          framebufferRow(dst, dy)[dx * 3 + ch] = framebufferRow(src, sy)[sx * 3 + ch];
+      }
+      if (dst->format == FB_RGB565)
+      {
+        static const uint16_t masks[3] = {0xF800, 0x07E0, 0x001F};
+        uint16_t mask = c.channel < 0 ? 0xFFFF : masks[c.channel];
+        uint16_t &out = ((uint16_t *)framebufferRow(dst, dy))[dx];
+        out = (out & ~mask) | (((const uint16_t *)framebufferRow(src, sy))[sx] & mask);
+      }
+      else if (framebufferIsIndexed(dst->format))
+      {
+        framebufferRow(dst, dy)[dx] = framebufferGetIndex(framebufferRow(src, sy), sx,
+                                                          framebufferBitsPerPixel(src->format));
+      }
+    }
+  }
+}
+
+// Indexed frames move whole indices (a single-channel shift remaps through the palette,
+// which the per-pixel loop does not model)
+static ShiftCase shiftCaseFor(const GlitchFramebuffer *fb, uint32_t index)
+{
+  ShiftCase c = shiftCases[index % SHIFT_CASES];
+  if (framebufferIsIndexed(fb->format))
+    c.channel = -1;
+  return c;
+}
+
+// ctx non-null = per-pixel reference
+static void benchShiftBox(void *ctx, uint32_t frame)
+{
+  ShiftCase c = shiftCaseFor(&glitchTarget, frame);
+  if (ctx)
+    shiftBoxPerPixel(&glitchTarget, &benchFrame, c);
+  else
+    glitchShiftBox(&benchRenderer, &glitchTarget, &benchFrame, c.x, c.y, c.w, c.h, c.offsetX, c.offsetY, c.channel);
+}
+
+// Shift cases where glitchShiftBox leaves exactly the pixels of the per-pixel loop
+static int countShiftMatches()
+{
+  const GlitchEffectChain none = {nullptr, 0};
+  int matches = 0;
+  for (int i = 0; i < SHIFT_CASES; i++)
+  {
+    glitchCompose(&benchRenderer, &glitchTarget, &benchFrame, &none, 0);
+    glitchCompose(&benchRenderer, &shiftExpected, &benchFrame, &none, 0);
+    ShiftCase c = shiftCaseFor(&glitchTarget, i);
+    glitchShiftBox(&benchRenderer, &glitchTarget, &benchFrame, c.x, c.y, c.w, c.h, c.offsetX, c.offsetY, c.channel);
+    shiftBoxPerPixel(&shiftExpected, &benchFrame, c);
+    matches += memcmp(glitchTarget.data, shiftExpected.data, framebufferSize(&glitchTarget)) == 0;
+  }
+  return matches;
+}
+
+// Frame pipeline under load: a producer and a consumer thread hand frames across as fast
+// as they can, each holding a random number of frames at once. Every frame carries its
+// sequence number in its pixels, so the consumer can tell a lost, repeated, reordered or
+// half-written frame. Build with -fsanitize=thread (env:native_tsan) to check the
+// queue's memory ordering as well.
+#define PIPELINE_STRESS_FRAMES 100000
+
+struct PipelineStress
+{
+  FramePipeline pipeline;
+  uint32_t received;
+  uint32_t outOfOrder; // Sequence number other than the next one
+  uint32_t corrupt;    // Pixels that do not carry the frame's sequence number
+  uint32_t duplicates; // A frame handed out while the consumer still held it
+};
+
+static void stressProducer(PipelineStress *stress)
+{
+  FramePipeline *pipeline = &stress->pipeline;
+  uint32_t rng = 1;
+  while (pipeline->nextSequence < PIPELINE_STRESS_FRAMES)
+  {
+    PipelineFrame *held[FRAME_PIPELINE_DEPTH];
+    int batch = checkRandom(&rng, 1, FRAME_PIPELINE_DEPTH + 1), count = 0;
+    while (count < batch && pipeline->nextSequence + count < PIPELINE_STRESS_FRAMES &&
+           (held[count] = framePipelineAcquire(pipeline)))
+      count++;
+    if (!count)
+      std::this_thread::yield();
+
+    for (int i = 0; i < count; i++)
+    {
+      PipelineFrame *frame = held[i];
+      if (!frame->fb.allocated)
+        allocateFramebuffer(&frame->fb, 16, 4, FB_RGB565);
+      uint32_t sequence = pipeline->nextSequence;
+      memset(frame->fb.data, (uint8_t)sequence, framebufferSize(&frame->fb));
+      memcpy(frame->fb.data, &sequence, sizeof(sequence));
+      framePipelineSubmit(pipeline, frame);
+    }
+  }
+}
+
+static void stressConsumer(PipelineStress *stress)
+{
+  FramePipeline *pipeline = &stress->pipeline;
+  uint32_t rng = 2;
+  while (stress->received < PIPELINE_STRESS_FRAMES)
+  {
+    PipelineFrame *held[FRAME_PIPELINE_DEPTH];
+    int batch = checkRandom(&rng, 1, FRAME_PIPELINE_DEPTH + 1), count = 0;
+    while (count < batch && (held[count] = framePipelineTake(pipeline)))
+    {
+      PipelineFrame *frame = held[count];
+      for (int i = 0; i < count; i++)
+        stress->duplicates += held[i] == frame;
+      stress->outOfOrder += frame->sequence != stress->received;
+
+      uint32_t sequence;
+      memcpy(&sequence, frame->fb.data, sizeof(sequence));
+      bool intact = sequence == frame->sequence;
+      for (size_t b = sizeof(sequence); b < framebufferSize(&frame->fb); b++)
+        intact &= frame->fb.data[b] == (uint8_t)frame->sequence;
+      stress->corrupt += !intact;
+      stress->received++;
+      count++;
+    }
+    if (!count)
+      std::this_thread::yield();
+    for (int i = 0; i < count; i++)
+      framePipelineRelease(pipeline, held[i]);
+  }
+}
+
+static void checkPipelineStress()
+{
+  static PipelineStress stress;
+  framePipelineInit(&stress.pipeline);
+  stress.received = stress.outOfOrder = stress.corrupt = stress.duplicates = 0;
+
+  uint64_t start = hostRealNanos();
+  std::thread producer(stressProducer, &stress);
+  std::thread consumer(stressConsumer, &stress);
+  producer.join();
+  consumer.join();
+  double seconds = (hostRealNanos() - start) / 1e9;
+
+  // Every frame back on the free queue exactly once
+  FramePipeline *pipeline = &stress.pipeline;
+  bool slotsBack = frameQueueSize(&pipeline->readyFrames) == 0 &&
+                   frameQueueSize(&pipeline->freeFrames) == FRAME_PIPELINE_DEPTH;
+  uint8_t seen = 0, index;
+  while (frameQueuePop(&pipeline->freeFrames, &index))
+  {
+    slotsBack &= index < FRAME_PIPELINE_DEPTH && !(seen & (1 << index));
+    seen |= 1 << index;
+  }
+  hostBenchCheck(stress.received == PIPELINE_STRESS_FRAMES && !stress.outOfOrder && !stress.corrupt &&
+                     !stress.duplicates && pipeline->produced.load() == PIPELINE_STRESS_FRAMES &&
+                     pipeline->presented.load() == PIPELINE_STRESS_FRAMES && slotsBack,
+                 "pipeline/spsc: %u frames across two threads (%.0f/s), %u out of order, %u corrupt, %u duplicated, "
+                 "slots %s; %u producer stalls, %u consumer starved",
+                 stress.received, stress.received / seconds, stress.outOfOrder, stress.corrupt, stress.duplicates,
+                 slotsBack ? "all returned" : "lost or repeated", pipeline->producerStalls.load(),
+                 pipeline->consumerStarved.load());
+  freeFramePipeline(pipeline);
+}
+
+// Image cache against a fake backing heap that watches every block it hands out. Each
+// image decodes to an RGB565 frame of its own width, filled with its index.
+struct CacheHeap
+{
+  ImageCache *cache;
+  size_t live;      // Bytes handed out and not yet freed
+  size_t peak;
+  bool pinnedFreed; // A block of currentSlot or fillSlot was freed
+  bool lruOrder;    // Every eviction took the least recently used unpinned image
+  int evicted[16];  // Image indices in eviction order
+  int evictions;
+};
+
+static void *cacheHeapAlloc(void *ctx, size_t size)
+{
+  CacheHeap *heap = (CacheHeap *)ctx;
+  void *ptr = malloc(size);
+  heap->live += size;
+  heap->peak = heap->live > heap->peak ? heap->live : heap->peak;
+  return ptr;
+}
+
+static void cacheHeapFree(void *ctx, void *ptr)
+{
+  CacheHeap *heap = (CacheHeap *)ctx;
+  const ImageCache *cache = heap->cache;
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    const ImageCacheSlot &slot = cache->slots[i];
+    if (!slot.fb.allocated || slot.fb.data != ptr)
+      continue;
+    heap->live -= framebufferSize(&slot.fb);
+    heap->pinnedFreed |= i == cache->currentSlot || i == cache->fillSlot;
+    for (int j = 0; j < IMAGE_CACHE_SLOTS; j++)
+    {
+      const ImageCacheSlot &other = cache->slots[j];
+      if (j != i && other.index >= 0 && j != cache->currentSlot && j != cache->fillSlot)
+        heap->lruOrder &= other.lastUse > slot.lastUse;
+    }
+    if (heap->evictions < 16)
+      heap->evicted[heap->evictions] = slot.index;
+    heap->evictions++;
+    break;
+  }
+  free(ptr);
+}
+
+static bool decodeCacheImage(void *, int index, GlitchFramebuffer *fb)
+{
+  if (!allocateFramebuffer(fb, 16 + index * 7 % 48, 32, FB_RGB565))
+    return false;
+  memset(fb->data, index, framebufferSize(fb));
+  return true;
+}
+
+static bool cacheImageIs(const GlitchFramebuffer *fb, int index)
+{
+  return fb && fb->width == 16 + index * 7 % 48 && fb->data[0] == index && fb->data[framebufferSize(fb) - 1] == index;
+}
+
+static void initCacheHeap(CacheHeap *heap, ImageCache *cache, size_t budget)
+{
+  *heap = {};
+  heap->cache = cache;
+  heap->lruOrder = true;
+  FramebufferAllocator backing = {cacheHeapAlloc, cacheHeapFree, heap};
+  imageCacheInit(cache, budget, &backing, decodeCacheImage, nullptr, nullptr);
+}
+
+// A scripted sequence on images of one size, three of which fit the budget, with the
+// hits, misses and evictions worked out by hand
+static void checkCacheScript()
+{
+  static ImageCache cache;
+  CacheHeap heap;
+  const size_t imageBytes = 16 * 2 * 32; // Image 0 and every 48th are 16 px wide
+  initCacheHeap(&heap, &cache, 3 * imageBytes + 100);
+  const int a = 0, b = 48, c = 96, d = 144, e = 192;
+
+  bool images = cacheImageIs(imageCacheGet(&cache, a), a); // miss
+  images &= cacheImageIs(imageCacheGet(&cache, b), b);     // miss
+  images &= cacheImageIs(imageCacheGet(&cache, a), a);     // hit
+  imageCachePrefetch(&cache, c);                           // fits
+  images &= cacheImageIs(imageCacheGet(&cache, c), c);     // hit
+  images &= cacheImageIs(imageCacheGet(&cache, d), d);     // miss: evicts b, least recently used
+  images &= cacheImageIs(imageCacheGet(&cache, a), a);     // hit
+  images &= cacheImageIs(imageCacheGet(&cache, b), b);     // miss: evicts c
+  imageCachePrefetch(&cache, e);                           // evicts d
+  imageCachePrefetch(&cache, c);                           // evicts a
+  imageCachePrefetch(&cache, d);                           // b is now least recently used but pinned: evicts e
+  images &= cacheImageIs(imageCacheGet(&cache, e), e);     // miss: b is unpinned and goes
+
+  const int expected[] = {b, c, d, a, e, b};
+  bool order = heap.evictions == 6 && memcmp(heap.evicted, expected, sizeof(expected)) == 0;
+  hostBenchCheck(images && cache.hits == 3 && cache.misses == 5 && cache.prefetches == 4 && cache.evictions == 6 &&
+                     order,
+                 "image cache script: %u hits, %u misses, %u prefetches, %u evictions (%d %d %d %d %d %d)",
+                 cache.hits, cache.misses, cache.prefetches, cache.evictions, heap.evicted[0], heap.evicted[1],
+                 heap.evicted[2], heap.evicted[3], heap.evicted[4], heap.evicted[5]);
+  imageCacheClear(&cache);
+}
+
+// Random gets and prefetches on images of different sizes under a tight budget
+static void checkCacheRandom()
+{
+  static ImageCache cache;
+  CacheHeap heap;
+  const size_t budget = 6000;
+  initCacheHeap(&heap, &cache, budget);
+  uint32_t rng = 1;
+  bool images = true, budgetKept = true;
+  uint32_t gets = 0;
+  for (int i = 0; i < 20000; i++)
+  {
+    int index = checkRandom(&rng, 0, 24);
+    if (checkRandom(&rng, 0, 4) == 0)
+    {
+      imageCachePrefetch(&cache, index);
+    }
+    else
+    {
+      images &= cacheImageIs(imageCacheGet(&cache, index), index);
+      gets++;
+    }
+    budgetKept &= cache.used <= budget && heap.live == cache.used;
+  }
+  hostBenchCheck(images && budgetKept && heap.peak <= budget && !heap.pinnedFreed && heap.lruOrder &&
+                     cache.hits + cache.misses == gets && (uint32_t)heap.evictions == cache.evictions,
+                 "image cache random: %u gets (%u hits), %u evictions, peak %zu of %zu bytes, pinned slots %s, LRU "
+                 "order %s",
+                 gets, cache.hits, cache.evictions, heap.peak, budget, heap.pinnedFreed ? "evicted" : "kept",
+                 heap.lruOrder ? "kept" : "broken");
+  imageCacheClear(&cache);
+}
+
+// Each fixture presented from its indexed framebuffer must light the panel exactly as
+// the same file loaded through the true-colour path to RGB565
+static void checkIndexedFixtures()
+{
+  std::string dataDir = hostFsRoot();
+  hostSetFsRoot(BENCH_FIXTURE_DIR);
+  GlitchFramebuffer indexed = GLITCH_FRAMEBUFFER_INIT;
+  GlitchFramebuffer rgb565 = GLITCH_FRAMEBUFFER_INIT;
+  GlitchFramebuffer planar = GLITCH_FRAMEBUFFER_INIT;
+  size_t panelBytes = (size_t)dma_display->panelWidthPx() * dma_display->panelHeightPx() * 3;
+  std::string shown;
+  for (int i = 0; i < FIXTURE_COUNT; i++)
+  {
+    const char *file = fixtureFiles[i];
+    bool loaded = loadBMPToFramebuffer(file, &indexed, FB_INDEXED8) && framebufferIsIndexed(indexed.format) &&
+                  loadBMPToFramebuffer(file, &rgb565, FB_RGB565) &&
+                  loadBMPToFramebuffer(file, &planar, FB_RGB888_PLANAR);
+    bool same = false;
+    if (loaded)
+    {
+      dma_display->clearScreen();
+      presentFramebuffer(dma_display, &canvas, &indexed, 0, 0);
+      shown.assign((const char *)dma_display->pixels(), panelBytes);
+      dma_display->clearScreen();
+      presentFramebuffer(dma_display, &canvas, &rgb565, 0, 0);
+      same = memcmp(shown.data(), dma_display->pixels(), panelBytes) == 0;
+    }
+    hostBenchCheck(loaded && same, "indexed %s: %d-bit, %zu bytes (%.1fx under RGB888), presented %s RGB565", file,
+                   loaded ? framebufferBitsPerPixel(indexed.format) : 0, loaded ? framebufferSize(&indexed) : 0,
+                   loaded ? (double)framebufferSize(&planar) / framebufferSize(&indexed) : 0.0,
+                   !loaded ? "(not loaded) vs" : same ? "identical to" : "differently from");
+  }
+  dma_display->clearScreen();
+  freeFramebuffer(&indexed);
+  freeFramebuffer(&rgb565);
+  freeFramebuffer(&planar);
+  hostSetFsRoot(dataDir.c_str());
+}
+
+// Headers with heights at and past the limits: only 1..INT16_MAX rows, either way up, are read
+static void checkBmpHeights()
+{
+  static const int32_t heights[] = {1, -1, INT16_MAX, -INT16_MAX, 0, INT16_MAX + 1, INT16_MIN, INT32_MIN, INT32_MAX};
+  int accepted = 0, rejected = 0;
+  for (int32_t height : heights)
+  {
+    // 1-pixel-wide 24-bit bitmap, pixel data right after the header
+    uint8_t header[BMP_HEADER_SIZE] = {'B', 'M'};
+    header[10] = BMP_HEADER_SIZE;
+    header[14] = 40;
+    header[18] = 1;
+    for (int b = 0; b < 4; b++)
+      header[22 + b] = (uint8_t)((uint32_t)height >> (8 * b));
+    header[28] = 24;
+    BmpMemorySource source = {header, sizeof(header), 0};
+    BmpReader reader;
+    bmpReaderInit(&reader, bmpMemoryRead, &source);
+    BmpStatus status = bmpReadHeader(&reader);
+    bool valid = height != 0 && height >= -INT16_MAX && height <= INT16_MAX;
+    if (valid)
+      accepted += status == BMP_OK && reader.info.height == (height < 0 ? -height : height);
+    else
+      rejected += status == BMP_BAD_HEIGHT;
+  }
+  hostBenchCheck(accepted == 4 && rejected == 5, "BMP heights: %d/4 in range read, %d/5 out of range rejected",
+                 accepted, rejected);
+}
+
+// Same default as the sketch (build flags reach both)
+#ifndef FAST_BOOT
+#define FAST_BOOT 1
+#endif
+
+// Boot phases on each task, in the order they run
+#if FAST_BOOT
+static const char *const bootSetupPhases[] = {"serial", "archive", "display", "wait storage"};
+static const char *const bootStoragePhases[] = {"littlefs", "first image"};
+#else
+static const char *const bootSetupPhases[] = {"serial", "archive", "littlefs", "display"};
+#endif
+
+// On the simulated clock boot takes only the delays setup() waits out: none with
+// FAST_BOOT, 1000 + 200 ms around Serial.begin() without. Nothing before the loop() case
+// moves the clock, and the scheduler starts its first frame at once.
+#define BOOT_FIRST_FRAME_US (FAST_BOOT ? 0u : 1200000u)
+
+// Each phase finished, started after the one before it on the same task (claimed a later
+// slot, no earlier than it ended) and lies within `outer`
+static bool bootPhasesInOrder(const char *const *names, int count, const BootEvent *outer)
+{
+  const BootEvent *previous = nullptr;
+  for (int i = 0; i < count; i++)
+  {
+    const BootEvent *event = bootTraceFind(&bootTrace, names[i]);
+    if (!event || !event->done || event->startUs < outer->startUs || event->endUs > outer->endUs)
+      return false;
+    if (previous && (event < previous || event->startUs < previous->endUs))
+      return false;
+    previous = event;
+  }
+  return true;
+}
+
+// The boot trace on the simulated clock: phases in order without overlapping on their
+// task, the storage task between mapping the archive and the wait for it, and the first
+// frame after setup() at exactly the time its delays add up to
+static void checkBootTrace()
+{
+  const BootEvent *setupPhase = bootTraceFind(&bootTrace, "setup");
+  const BootEvent *firstFrame = bootTraceFind(&bootTrace, "first frame");
+  if (!setupPhase || !firstFrame)
+  {
+    hostBenchCheck(false, "boot trace: setup %s, first frame %s", setupPhase ? "traced" : "missing",
+                   firstFrame ? "shown" : "missing");
+    return;
+  }
+
+  bool ordered = setupPhase == &bootTrace.events[0] && setupPhase->done &&
+                 bootPhasesInOrder(bootSetupPhases, sizeof(bootSetupPhases) / sizeof(bootSetupPhases[0]), setupPhase);
+#if FAST_BOOT
+  const BootEvent *archive = bootTraceFind(&bootTrace, "archive");
+  const BootEvent *waitStorage = bootTraceFind(&bootTrace, "wait storage");
+  BootEvent storageSpan = {"storage", archive ? archive->endUs : 0, waitStorage ? waitStorage->endUs : 0, true};
+  ordered = ordered && bootPhasesInOrder(bootStoragePhases, sizeof(bootStoragePhases) / sizeof(bootStoragePhases[0]),
+                                         &storageSpan);
+#endif
+  uint32_t firstFrameUs = firstFrame->startUs - setupPhase->startUs;
+  hostBenchCheck(ordered && firstFrame->startUs >= setupPhase->endUs && firstFrameUs == BOOT_FIRST_FRAME_US,
+                 "boot trace: %d phases %s, first frame at %u us (expected %u)", bootTrace.count.load() - 1,
+                 ordered ? "in order" : "out of order", firstFrameUs, BOOT_FIRST_FRAME_US);
+}
+
+// The sketch took its content levels from its archive before begin() (every level without
+// one, or with fades) and the panel runs at the depth they need. The bench's archive, when
+// there is one, records the levels of the BMPs it was packed from, and a rotation without
+// fades shows exactly those and black.
+static void checkContentLevels()
+{
+  ColorLevels levels = COLOR_LEVELS_INIT;
+  slideshowContentLevels(&slideshow.config, iconArchive.open ? iconArchive.header->levels : nullptr, &levels);
+  ColorDepthPanel depthPanel = {(uint16_t)canvas.panelWidth, (uint16_t)canvas.panelHeight, canvas.panelCount, 1, true};
+  uint8_t bits = colorDepthChoose(&contentLevels, &depthProfile, &depthPanel).bits;
+  hostBenchCheck(memcmp(&levels, &contentLevels, sizeof(levels)) == 0 && dma_display->getPixelColorDepthBits() == bits,
+                 "colour depth at boot: %s, %d levels -> %d bits, panel at %d",
+                 iconArchive.open ? "from the archive" : "no archive", colorLevelsCount(&contentLevels), bits,
+                 dma_display->getPixelColorDepthBits());
+  if (!benchArchive.open)
+    return;
+
+  SlideshowConfig cuts = slideshow.config;
+  cuts.fadeTime = 0;
+  ColorLevels packed = COLOR_LEVELS_INIT, expected = COLOR_LEVELS_INIT;
+  slideshowContentLevels(&cuts, benchArchive.header->levels, &packed);
+  colorLevelsAdd(&expected, 0);
+  int icons = iconLevels(&expected);
+  hostBenchCheck(memcmp(&packed, &expected, sizeof(packed)) == 0,
+                 "archive levels: %d with black, %d icons use %d with black -> %d bits", colorLevelsCount(&packed),
+                 icons, colorLevelsCount(&expected), colorDepthChoose(&packed, &depthProfile, &depthPanel).bits);
+}
+
+int main(int argc, char **argv)
+{
+  BenchOptions options;
+  if (!hostBenchParseArgs(argc, argv, &options))
+    return 1;
+
+  randomSeed(1);
+  // Boot phases run on the simulated clock: only the delays they wait out take time
+  bootTrace.now = hostClockNow;
+  setup();
+
+  // Same rate, but waiting for a deadline advances virtual time instead of sleeping
+  SchedulerClock clock = {hostClockNow, hostClockWaitUntil, nullptr};
+  frameSchedulerInit(&frameScheduler, 1000000 / frameScheduler.periodUs, &clock);
+
+  hostBenchPrintHeader();
+  hostBenchRun("drawBMP", dma_display, benchDrawBMP, nullptr, &options);
+
+  // "indexed" keeps palettized BMPs indexed, so it runs on the fixtures
+  static const FramebufferFormat formats[] = {FB_RGB888_PLANAR, FB_RGB888_INTERLEAVED, FB_RGB565, FB_INDEXED8};
+  static const char *formatNames[] = {"planar", "interleaved", "rgb565", "indexed"};
+  const int formatCount = sizeof(formats) / sizeof(formats[0]);
+  size_t frameBytes[formatCount];
+  int crossfadeErrors[formatCount];
+  int glitchReplays = 0, glitchFrames = 0;
+  int animMatches = 0;
+  size_t animBytes = 0;
+  double animFps[2] = {}, animFlashPerSecond[2] = {}; // Delta player, BMP sequence
+  int bitplaneMatches = 0, bitplaneCases = 0;
+  bitplaneLayoutInit(&benchLayout, canvas.panelWidth, canvas.panelHeight, canvas.panelCount, PIXEL_COLOR_DEPTH_BITS);
+  allocateBitplaneFrame(&benchPlanes, &benchLayout);
+  static const char *effectNames[GLITCH_EFFECT_COUNT] = {"box", "chroma", "tear", "sort"};
+  char name[64];
+  std::string dataDir = hostFsRoot();
+  for (int f = 0; f < formatCount; f++)
+  {
+    FramebufferFormat format = formats[f];
+    benchFiles = imageFiles;
+    benchFileCount = imageCount();
+    if (framebufferIsIndexed(format))
+    {
+      // The fixtures all differ in size or depth, so the reload case keeps to the first:
+      // only a reload of the same shape can reuse its block
+      hostSetFsRoot(BENCH_FIXTURE_DIR);
+      benchFiles = fixtureFiles;
+      benchFileCount = 1;
+    }
+    frameBytes[f] = 0;
+    crossfadeErrors[f] = -1;
+    if (!loadBMPToFramebuffer(benchFiles[0], &benchFrame, format))
+    {
+      hostSetFsRoot(dataDir.c_str());
+      continue;
+    }
+
+    // Reloading into a frame of the same size and format reuses its block. The heap
+    // allocations the case still reports come from opening the file (the FILE and its
+    // buffer on a host, the LittleFS handle on the board).
+    FramebufferHeapCounts before = framebufferHeapCounts();
+    snprintf(name, sizeof(name), "loadBMPToFramebuffer/%s", formatNames[f]);
+    if (hostBenchRun(name, dma_display, benchLoadBMP, &format, &options))
+      checkNoFramebufferHeap(name, before, false);
+
+    // QOI files from scripts/pack_icons.py --qoi-dir <assets dir>
+    if (!framebufferIsIndexed(format) && fileSize(std::string(options.assetDir) + qoiName(0)))
+    {
+      hostSetFsRoot(options.assetDir);
+      snprintf(name, sizeof(name), "loadQOIToFramebuffer/%s", formatNames[f]);
+      hostBenchRun(name, dma_display, benchLoadQOI, &format, &options);
+      hostSetFsRoot(dataDir.c_str());
+    }
+
+    loadBMPToFramebuffer(benchFiles[0], &benchFrame, format);
+    frameBytes[f] = framebufferSize(&benchFrame);
+    randomSeed(1);
+    snprintf(name, sizeof(name), "presentFramebuffer/%s", formatNames[f]);
+    hostBenchRun(name, dma_display, benchPresent, nullptr, &options);
+    hostBenchCheck(spansMatchFull(&benchFrame), "presentFramebufferSpans/%s identical to presentFramebuffer",
+                   formatNames[f]);
+    // Warm-up: the back buffer is sized once per image, as the sketch does on a load.
+    // From then on a glitched frame must not touch the heap at all.
+    glitchRendererPrepare(&glitchRenderer, &benchFrame);
+    glitchRendererSeed(&glitchRenderer, BENCH_GLITCH_SEED);
+    before = framebufferHeapCounts();
+    snprintf(name, sizeof(name), "drawFramebufferGlitched/%s", formatNames[f]);
+    if (hostBenchRun(name, dma_display, benchGlitched, nullptr, &options))
+      checkNoFramebufferHeap(name, before, true);
+
+    // Box shifts as row spans against the per-pixel loop, timed on the same cases
+    makeShiftCases(benchFrame.width, benchFrame.height);
+    hostBenchCheck(countShiftMatches() == SHIFT_CASES, "glitchShiftBox/%s identical to the per-pixel shift (%d boxes)",
+                   formatNames[f], SHIFT_CASES);
+    snprintf(name, sizeof(name), "glitch/shiftBox/spans/%s", formatNames[f]);
+    hostBenchRun(name, dma_display, benchShiftBox, nullptr, &options);
+    snprintf(name, sizeof(name), "glitch/shiftBox/per-pixel/%s", formatNames[f]);
+    hostBenchRun(name, dma_display, benchShiftBox, (void *)1, &options);
+
+    // Each effect kernel on its own (reset + effect, not presented)
+    for (int e = 0; e < GLITCH_EFFECT_COUNT; e++)
+    {
+      GlitchEffectType type = (GlitchEffectType)e;
+      snprintf(name, sizeof(name), "glitch/%s/%s", effectNames[e], formatNames[f]);
+      hostBenchRun(name, dma_display, benchEffect, &type, &options);
+    }
+    glitchReplays += countGlitchReplays(64);
+    glitchFrames += 64;
+
+    // Encode into bit planes every frame; the encoding must equal what the library's
+    // per-pixel path builds from the same pixels
+    snprintf(name, sizeof(name), "bitplane/encode/%s", formatNames[f]);
+    hostBenchRun(name, dma_display, benchEncode, nullptr, &options);
+    bitplaneMatches += bitplanesMatch(&canvas, &benchFrame);
+    bitplaneCases++;
+
+    // Fixed-point SWAR blend against the scalar float reference (RGB formats only)
+    if (loadBMPToFramebuffer(benchFiles[1 % benchFileCount], &benchOther, format) &&
+        crossfadeCompatible(&benchFrame, &benchOther))
+    {
+      crossfadeErrors[f] = crossfadeMaxError();
+      snprintf(name, sizeof(name), "crossfade/swar/%s", formatNames[f]);
+      hostBenchRun(name, dma_display, benchCrossfade, nullptr, &options);
+      loadBMPToFramebuffer(benchFiles[0], &benchFrame, format);
+      snprintf(name, sizeof(name), "crossfade/float/%s", formatNames[f]);
+      hostBenchRun(name, dma_display, benchCrossfadeFloat, nullptr, &options);
+    }
+    hostSetFsRoot(dataDir.c_str());
+  }
+
+  // Walls of 1, 4 and 16 panels: with dirty tracking the frame cost follows the icon, not the wall
+  loadBMPToFramebuffer(imageFiles[0], &benchFrame, FB_RGB888_PLANAR);
+  benchWall(1, 1, &options);
+  benchWall(2, 2, &options);
+  benchWall(4, 4, &options);
+
+  // A rotated, snaking 2x2 wall and every RGB565 colour across a 4x4 wall
+  VirtualCanvas wall = VIRTUAL_CANVAS_INIT;
+  canvasInitGrid(&wall, 64, 64, 2, 2, canvas.panels[0].rotation, true);
+  bitplaneMatches += bitplanesMatch(&wall, &benchFrame);
+  bitplaneMatches += allColoursMatch(4, 4);
+  bitplaneCases += 2;
+
+  // The same animation as full BMPs and as streamed deltas; both end on the same frame,
+  // so their panel hashes match
+  std::string animDir = std::string(options.assetDir) + "/bench-anim";
+  animBytes = writeAnimationAssets(animDir);
+  if (animBytes)
+  {
+    animMatches = countAnimationMatches(animDir + "/anim.ica");
+    hostSetFsRoot(animDir.c_str());
+    File animFile;
+    BenchResult result;
+    if (hostBenchRun("anim/bmp-sequence", dma_display, benchBMPSequence, nullptr, &options, &result))
+    {
+      animFps[1] = 1e9 / result.nsPerFrame;
+      animFlashPerSecond[1] = result.bytesReadPerFrame * 1000 / ANIM_BENCH_FRAME_MS;
+    }
+    if (openAnimation("/anim.ica", &animFile, &animBench) &&
+        hostBenchRun("anim/delta", dma_display, benchAnimPlay, nullptr, &options, &result))
+    {
+      animFps[0] = 1e9 / result.nsPerFrame;
+      animFlashPerSecond[0] = result.bytesReadPerFrame * 1000 / ANIM_BENCH_FRAME_MS;
+    }
+    animFile.close();
+    hostSetFsRoot(dataDir.c_str());
+  }
+
+  // The icon streamed over a pty as the host sender would send it; the panel ends on the
+  // last glitched frame, presented in place
+  double streamFps = 0, streamBytes = 0;
+  if (makeStreamFrames() && hostStreamStart(&streamLink, streamSource, STREAM_BENCH_FRAMES, streamFrame.width,
+                                            streamFrame.height, options.frames))
+  {
+    BenchResult result;
+    dma_display->clearScreen();
+    if (hostBenchRun("stream/icon", dma_display, benchStream, nullptr, &options, &result))
+    {
+      streamFps = 1e9 / result.nsPerFrame;
+      streamBytes = (double)streamLink.receiver.bytesReceived / streamLink.receiver.packetsReceived;
+    }
+    hostStreamStop(&streamLink);
+  }
+
+  // Pixel conversion kernels against their scalar references (ctx non-null = scalar)
+  for (int i = 0; i < CONVERT_PIXELS * 3; i++)
+    convertIn[0][i] = convertIn[1 + i % 3][i / 3] = (uint8_t)(i * 2654435761u >> 24);
+  rgb565LutInit(&convertLut, 200, 2.2f);
+  static const struct
+  {
+    const char *name;
+    BenchFrameFn fn;
+    bool scalar; // Has a scalar reference case
+  } kernels[] = {{"bgr565", benchConvertBGR, true},
+                 {"rgb565", benchConvertRGB, false},
+                 {"planar565", benchConvertPlanar, true},
+                 {"splitbgr", benchSplitBGR, true}};
+  const int kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+  double pxPerUs[kernelCount][2] = {};
+  for (int k = 0; k < kernelCount; k++)
+  {
+    for (int scalar = 0; scalar <= (int)kernels[k].scalar; scalar++)
+    {
+      BenchResult result;
+      snprintf(name, sizeof(name), "convert/%s/%s", kernels[k].name, scalar ? "scalar" : "swar");
+      if (hostBenchRun(name, dma_display, kernels[k].fn, scalar ? (void *)1 : nullptr, &options, &result))
+        pxPerUs[k][scalar] = CONVERT_PIXELS * 1000.0 / result.nsPerFrame;
+    }
+  }
+
+  // Packed archive written by scripts/pack_icons.py (standalone run writes icons.pak)
+  std::string archivePath = std::string(options.assetDir) + "/icons.pak";
+  if (assetArchiveMap(&benchArchive, archivePath.c_str()))
+    hostBenchRun("assetArchiveLoad", dma_display, benchArchiveLoad, nullptr, &options);
+
+  randomSeed(1);
+  glitchRendererSeed(&glitchRenderer, BENCH_GLITCH_SEED);
+  profilerReset();
+  hostBenchRun("loop", dma_display, benchLoop, nullptr, &options);
+
+  // Per-stage timings of the loop() case, as the sketch reports them over Serial
+  if (options.profile)
+    profilerDumpCsv(printReport, nullptr);
+
+  checkCacheScript();
+  checkCacheRandom();
+  checkIndexedFixtures();
+  checkBmpHeights();
+  checkContentLevels();
+  if (hostBenchSelected(&options, "loop"))
+    checkBootTrace();
+  if (hostBenchSelected(&options, "pipeline/spsc"))
+    checkPipelineStress();
+
+  // Storage: shipped BMPs against their QOI encodings and the packed archive
+  size_t bmpBytes = 0, qoiBytes = 0;
+  for (int i = 0; i < imageCount(); i++)
+  {
+    bmpBytes += fileSize(std::string(hostFsRoot()) + imageFiles[i]);
+    qoiBytes += fileSize(std::string(options.assetDir) + qoiName(i));
+  }
+  printf("\nbmp files: %zu bytes", bmpBytes);
+  if (qoiBytes)
+    printf(", qoi files: %zu bytes (%.1fx smaller, %d/%d decode identical)", qoiBytes, (double)bmpBytes / qoiBytes,
+           countQOIMatches(options.assetDir), imageCount());
+  if (benchArchive.open)
+    printf(", archive: %zu bytes", benchArchive.size);
+  printf("\nframebuffer bytes (%s, indexed %s):", imageFiles[0], fixtureFiles[0]);
+  for (int f = 0; f < formatCount; f++)
+    printf(" %s %zu", formatNames[f], frameBytes[f]);
+  int convertKernels, convertMatches = countConvertMatches(&convertKernels);
+  printf("\nconversion kernels identical to scalar (all 2^24 colours): %d/%d\nconversion px/us:", convertMatches,
+         convertKernels);
+  for (int k = 0; k < kernelCount; k++)
+  {
+    if (!pxPerUs[k][0])
+      continue;
+    printf(" %s %.0f", kernels[k].name, pxPerUs[k][0]);
+    if (pxPerUs[k][1])
+      printf(" (scalar %.0f)", pxPerUs[k][1]);
+  }
+  printf("\nglitch frames replayed bit-exact from their seeds: %d/%d", glitchReplays, glitchFrames);
+  printf("\nbit planes identical to per-pixel panel writes: %d/%d", bitplaneMatches, bitplaneCases);
+  if (animBytes)
+  {
+    size_t bmpSequenceBytes = 0;
+    for (int i = 0; i < ANIM_BENCH_FRAMES; i++)
+    {
+      char path[16];
+      snprintf(path, sizeof(path), "/f%02d.bmp", i);
+      bmpSequenceBytes += fileSize(animDir + path);
+    }
+    printf("\nanimation (%d frames): %zu bytes vs %zu as BMPs (%.1fx smaller), %d/%d frames identical",
+           ANIM_BENCH_FRAMES, animBytes, bmpSequenceBytes, (double)bmpSequenceBytes / animBytes, animMatches,
+           ANIM_BENCH_FRAMES);
+    if (animFps[0] && animFps[1])
+      printf("\nanimation sustained fps: delta %.0f, bmp sequence %.0f; flash bytes/s at %d fps: delta %.0f, bmp "
+           "sequence %.0f",
+           animFps[0], animFps[1], 1000 / ANIM_BENCH_FRAME_MS, animFlashPerSecond[0], animFlashPerSecond[1]);
+  }
+  if (streamFps)
+    printf("\nstream (icon, %d frames looped): %.0f bytes/frame (full frame %zu), %u/%u frames identical, %.0f fps "
+           "over pty; fps at 921600 baud %.1f, 2000000 baud %.1f",
+           STREAM_BENCH_FRAMES, streamBytes, streamMaxPacketSize(streamFrame.width, streamFrame.height), streamMatches,
+           options.frames, streamFps, 92160 / streamBytes, 200000 / streamBytes);
+  // Colour depth: what the icons alone would need, what the sketch runs at and the
+  // library's defaults (8 planes at 10 MHz) for comparison
+  ColorLevels levels = COLOR_LEVELS_INIT;
+  int icons = iconLevels(&levels);
+  ColorDepthPanel depthPanel = {(uint16_t)canvas.panelWidth, (uint16_t)canvas.panelHeight, canvas.panelCount, 1, true};
+  ColorDepthTiming iconDepth = colorDepthChoose(&levels, &depthProfile, &depthPanel);
+  ColorDepthTiming defaultDepth = colorDepthTiming(&depthPanel, 8, HUB75_I2S_CFG::HZ_10M, 60);
+  printf("\ncolour depth: sketch %d bits; %d icons use %d levels -> %d bits at %u MHz, %u Hz, %u DMA bytes "
+         "(8 bits at 10 MHz: %u Hz, %u bytes)",
+         dma_display->getPixelColorDepthBits(), icons, colorLevelsCount(&levels), iconDepth.bits,
+         iconDepth.i2sHz / 1000000, iconDepth.refreshHz, iconDepth.dmaBytes, defaultDepth.refreshHz,
+         defaultDepth.dmaBytes);
+
+  // Storage phases run on their own task, overlapping setup()'s
+  uint8_t bootEvents = bootTrace.count.load();
+  int bootFinished = 0;
+  const BootEvent *firstFrame = bootTraceFind(&bootTrace, "first frame");
+  printf("\nboot (simulated clock):");
+  for (uint8_t i = 0; i < bootEvents; i++)
+  {
+    const BootEvent *event = &bootTrace.events[i];
+    bootFinished += event->done;
+    if (event->done && event != firstFrame)
+      printf(" %s %u us,", event->name, event->endUs - event->startUs);
+  }
+  printf(" %d/%d phases finished, first frame %s", bootFinished, bootEvents, firstFrame ? "shown" : "missing");
+  printf("\ncrossfade max channel error vs float:");
+  for (int f = 0; f < formatCount; f++)
+    if (crossfadeErrors[f] >= 0)
+      printf(" %s %d", formatNames[f], crossfadeErrors[f]);
+  printf("\n");
+
+  freeFramebuffer(&benchFrame);
+  freeFramebuffer(&benchOther);
+  freeFramebuffer(&glitchTarget);
+  freeFramebuffer(&shiftExpected);
+  freeBitplaneFrame(&benchPlanes);
+  freeAnimPlayer(&animBench);
+  freeFramebuffer(&animSequence);
+  freeFramebuffer(&streamFrame);
+  free(streamSource);
+  for (GlitchFramebuffer &frame : animFrames)
+    freeFramebuffer(&frame);
+  return hostBenchFailures() ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+"""Write the palettized BMP fixtures the native bench loads (bench/fixtures).
+
+Each fixture is a shipped icon cropped and reduced to a palette: 1-bit and 4-bit files
+with widths that leave padding in the packed rows, and an 8-bit one whose palette
+(biClrUsed) holds only the colours it uses. The bench presents them through the indexed
+path and through RGB565 and requires the same pixels from both.
+
+Usage:   python scripts/make_bmp_fixtures.py [data_dir] [output_dir]
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from pack_icons import align4, read_bmp  # noqa: E402
+
+# (output name, source icon, width, bits per pixel, palette entries)
+FIXTURES = [
+    ("pal1.bmp", "i0.bmp", 61, 1, 2),
+    ("pal4.bmp", "i10.bmp", 63, 4, 16),
+    ("pal8.bmp", "i11.bmp", 64, 8, 48),
+]
+
+
+def luminance(color):
+    r, g, b = color
+    return r * 77 + g * 150 + b * 29
+
+
+def build_palette(rows, entries):
+    """The most used colours, darkest first (index 0 is the background)."""
+    counts = {}
+    for row in rows:
+        for color in row:
+            counts[color] = counts.get(color, 0) + 1
+    popular = sorted(counts, key=lambda c: (-counts[c], c))[:entries]
+    return sorted(popular, key=lambda c: (luminance(c), c))
+
+
+def nearest(palette, color):
+    return min(range(len(palette)),
+               key=lambda i: sum((a - b) * (a - b) for a, b in zip(palette[i], color)))
+
+
+def write_indexed_bmp(path, width, rows, bits, palette):
+    """Bottom-up, uncompressed, biClrUsed = len(palette)."""
+    height = len(rows)
+    row_size = align4((width * bits + 7) // 8)
+    pixels = bytearray()
+    for row in reversed(rows):
+        packed = bytearray(row_size)
+        for x, index in enumerate(row):
+            bit = x * bits
+            packed[bit >> 3] |= index << (8 - bits - (bit & 7))
+        pixels += packed
+    colors = b"".join(struct.pack("<BBBB", b, g, r, 0) for r, g, b in palette)
+    offset = 14 + 40 + len(colors)
+    with open(path, "wb") as f:
+        f.write(struct.pack("<2sIHHI", b"BM", offset + len(pixels), 0, 0, offset))
+        f.write(struct.pack("<IiiHHIIiiII", 40, width, height, 1, bits, 0, len(pixels), 2835, 2835,
+                            len(palette), 0))
+        f.write(colors)
+        f.write(pixels)
+
+
+def make_fixtures(data_dir, output_dir):
+    os.makedirs(output_dir, exist_ok=True)
+    for name, source, width, bits, entries in FIXTURES:
+        _, _, rows = read_bmp(os.path.join(data_dir, source))
+        rows = [row[:width] for row in rows]
+        palette = build_palette(rows, entries)
+        cache = {}
+        indices = [[cache.setdefault(c, nearest(palette, c)) for c in row] for row in rows]
+        path = os.path.join(output_dir, name)
+        write_indexed_bmp(path, width, indices, bits, palette)
+        print("%s: %dx%d, %d-bit, %d colours, %d bytes" % (path, width, len(rows), bits, len(palette),
+                                                           os.path.getsize(path)))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Write palettized BMP fixtures for the native bench")
+    parser.add_argument("data_dir", nargs="?", default="data")
+    parser.add_argument("output_dir", nargs="?", default="bench/fixtures")
+    args = parser.parse_args()
+    make_fixtures(args.data_dir, args.output_dir)
@@ -0,0 +1,330 @@
+"""Pack data/*.bmp into a single icon archive for the "assets" flash partition.
+
+The archive holds the channel levels its images use (for the firmware's colour depth),
+an index (name, dimensions, offset, CRC32) and each image either
+QOI-compressed (default; decoded straight into the framebuffer) or raw in the firmware's
+framebuffer layout (planar RGB888, top-down, 4-byte aligned rows; loaded with one
+memcpy). Layout must match src/asset_archive.h.
+
+It also builds animations: the BMPs in a folder, in name order, become one .ica file
+holding the first frame whole and every later one as the row spans that changed, raw or
+run-length coded (src/anim_player.h).
+
+Standalone:   python scripts/pack_icons.py [--raw] [data_dir] [output.pak]
+              python scripts/pack_icons.py --qoi-dir OUT [data_dir]
+              (writes OUT/<name>.qoi for each BMP, for loading from LittleFS)
+              python scripts/pack_icons.py --anim FRAMES_DIR data/anim0.ica [--frame-ms N] [--key-interval N]
+PlatformIO:   extra_scripts = pre:scripts/pack_icons.py
+              (packs on every build and adds an "uploadassets" target)
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"ICPK"
+VERSION = 3
+FORMAT_RGB888_PLANAR = 0  # FramebufferFormat::FB_RGB888_PLANAR
+ENCODING_RAW = 0  # AssetEncoding::ASSET_ENCODING_RAW
+ENCODING_QOI = 1  # AssetEncoding::ASSET_ENCODING_QOI
+
+HEADER = struct.Struct("<4sHBBHHIIII8I")  # 60 bytes
+ENTRY = struct.Struct("<24sHHHBBIIII")  # 48 bytes
+NAME_LEN = 24
+
+ANIM_MAGIC = b"ICAN"
+ANIM_VERSION = 1
+ANIM_HEADER = struct.Struct("<4sHHHHHH")  # 16 bytes
+ANIM_FRAME = struct.Struct("<BBHI")  # 8 bytes: type, reserved, span count, data size
+ANIM_SPAN = struct.Struct("<HHH")  # x, y, length (bit 15: run-length coded)
+ANIM_FRAME_KEY = 0
+ANIM_FRAME_DELTA = 1
+ANIM_SPAN_RLE = 0x8000
+ANIM_MERGE_GAP = 3  # Unchanged pixels worth sending to save a span header (6 bytes)
+
+
+def fnv1a(data):
+    h = 0x811C9DC5
+    for b in data:
+        h ^= b
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def align4(n):
+    return (n + 3) & ~3
+
+
+def read_bmp(path):
+    """Return (width, height, rows) with rows top-down as lists of (r, g, b)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:2] != b"BM":
+        raise ValueError("%s: not a BMP" % path)
+    offset = struct.unpack_from("<I", data, 10)[0]
+    width, height = struct.unpack_from("<ii", data, 18)
+    bpp, compression = struct.unpack_from("<HI", data, 28)
+    if bpp != 24 or compression != 0:
+        raise ValueError("%s: only uncompressed 24-bit BMP supported" % path)
+    top_down = height < 0
+    height = abs(height)
+    row_size = align4(width * 3)
+    rows = []
+    for i in range(height):
+        start = offset + i * row_size
+        row = data[start:start + width * 3]
+        rows.append([(row[x * 3 + 2], row[x * 3 + 1], row[x * 3]) for x in range(width)])
+    if not top_down:
+        rows.reverse()
+    return width, height, rows
+
+
+def planar_pixels(width, height, rows):
+    stride = align4(width)
+    out = bytearray(stride * height * 3)
+    plane = stride * height
+    for y, row in enumerate(rows):
+        for x, (r, g, b) in enumerate(row):
+            out[y * stride + x] = r
+            out[plane + y * stride + x] = g
+            out[2 * plane + y * stride + x] = b
+    return stride, bytes(out)
+
+
+def qoi_encode(width, height, rows):
+    """Encode top-down (r, g, b) rows as a QOI image (https://qoiformat.org)."""
+    out = bytearray(b"qoif" + struct.pack(">IIBB", width, height, 3, 0))
+    index = [(0, 0, 0, 0)] * 64
+    prev = (0, 0, 0, 255)
+    run = 0
+    pixels = [(r, g, b, 255) for row in rows for (r, g, b) in row]
+    for i, px in enumerate(pixels):
+        if px == prev:
+            run += 1
+            if run == 62 or i == len(pixels) - 1:
+                out.append(0xC0 | (run - 1))
+                run = 0
+            continue
+        if run:
+            out.append(0xC0 | (run - 1))
+            run = 0
+
+        r, g, b, a = px
+        slot = (r * 3 + g * 5 + b * 7 + a * 11) % 64
+        if index[slot] == px:
+            out.append(slot)
+        else:
+            index[slot] = px
+            dr = (r - prev[0] + 128) % 256 - 128
+            dg = (g - prev[1] + 128) % 256 - 128
+            db = (b - prev[2] + 128) % 256 - 128
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2))
+            elif -32 <= dg <= 31 and -8 <= dr - dg <= 7 and -8 <= db - dg <= 7:
+                out.append(0x80 | (dg + 32))
+                out.append((dr - dg + 8) << 4 | (db - dg + 8))
+            else:
+                out += bytes((0xFE, r, g, b))
+        prev = px
+    out += b"\0" * 7 + b"\1"
+    return bytes(out)
+
+
+def rgb565_rows(rows):
+    return [[(r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3 for (r, g, b) in row] for row in rows]
+
+
+def panel_levels(images):
+    """Bitmap (8 words, bit n % 32 of word n // 32) of the channel levels the images put on
+    the panel: RGB565 with each channel expanded back to 8 bits, as the library's drawPixel
+    does. The firmware sizes the panel's colour depth from it before it starts the display."""
+    words = [0] * 8
+    for _name, _width, _height, rows in images:
+        for row in rows:
+            for r, g, b in row:
+                r5, g6, b5 = r >> 3, g >> 2, b >> 3
+                for level in ((r5 << 3) | (r5 >> 2), (g6 << 2) | (g6 >> 4), (b5 << 3) | (b5 >> 2)):
+                    words[level >> 5] |= 1 << (level & 31)
+    return words
+
+
+def changed_spans(prev, row):
+    """(start, end) of the runs where row differs from prev, merging short gaps."""
+    spans = []
+    x = 0
+    while x < len(row):
+        if row[x] == prev[x]:
+            x += 1
+            continue
+        start = x
+        while x < len(row) and row[x] != prev[x]:
+            x += 1
+        if spans and start - spans[-1][1] <= ANIM_MERGE_GAP:
+            spans[-1] = (spans[-1][0], x)
+        else:
+            spans.append((start, x))
+    return spans
+
+
+def encode_span(x, y, pixels):
+    """One span, run-length coded when that is smaller."""
+    runs = bytearray()
+    i = 0
+    while i < len(pixels):
+        count = 1
+        while i + count < len(pixels) and pixels[i + count] == pixels[i] and count < 256:
+            count += 1
+        runs += struct.pack("<BH", count - 1, pixels[i])
+        i += count
+    raw = struct.pack("<%dH" % len(pixels), *pixels)
+    if len(runs) < len(raw):
+        return ANIM_SPAN.pack(x, y, len(pixels) | ANIM_SPAN_RLE) + runs
+    return ANIM_SPAN.pack(x, y, len(pixels)) + raw
+
+
+def encode_animation(frames_dir, output, frame_ms=100, key_interval=0):
+    frames = [rgb565_rows(rows) for _name, _w, _h, rows in load_images(frames_dir)]
+    if not frames:
+        raise ValueError("%s: no BMP frames" % frames_dir)
+    sizes = {(len(f[0]), len(f)) for f in frames}
+    if len(sizes) != 1:
+        raise ValueError("%s: frames differ in size" % frames_dir)
+    width, height = sizes.pop()
+
+    out = bytearray(ANIM_HEADER.pack(ANIM_MAGIC, ANIM_VERSION, width, height, len(frames), frame_ms, key_interval))
+    prev = None
+    for i, frame in enumerate(frames):
+        key = prev is None or (key_interval and i % key_interval == 0)
+        spans = []
+        for y, row in enumerate(frame):
+            for start, end in [(0, width)] if key else changed_spans(prev[y], row):
+                spans.append(encode_span(start, y, row[start:end]))
+        data = b"".join(spans)
+        out += ANIM_FRAME.pack(ANIM_FRAME_KEY if key else ANIM_FRAME_DELTA, 0, len(spans), len(data)) + data
+        prev = frame
+
+    with open(output, "wb") as f:
+        f.write(out)
+    full = len(frames) * (54 + align4(width * 3) * height)
+    print("Encoded %d frames into %s (%d bytes, %d bytes as 24-bit BMPs)" % (len(frames), output, len(out), full))
+    return len(out)
+
+
+def load_images(data_dir):
+    """(name, width, height, rows) for every BMP in data_dir, in name order."""
+    images = []
+    for filename in sorted(f for f in os.listdir(data_dir) if f.lower().endswith(".bmp")):
+        name = os.path.splitext(filename)[0].encode()
+        if len(name) >= NAME_LEN:
+            raise ValueError("%s: name longer than %d characters" % (filename, NAME_LEN - 1))
+        images.append((name,) + read_bmp(os.path.join(data_dir, filename)))
+    return images
+
+
+def write_qoi_files(data_dir, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+    for name, width, height, rows in load_images(data_dir):
+        with open(os.path.join(out_dir, name.decode() + ".qoi"), "wb") as f:
+            f.write(qoi_encode(width, height, rows))
+
+
+def pack(data_dir, output, compress=True):
+    images = []
+    raw_total = 0
+    sources = load_images(data_dir)
+    for name, width, height, rows in sources:
+        stride, pixels = planar_pixels(width, height, rows)
+        raw_total += len(pixels)
+        if compress:
+            images.append((name, width, height, stride, ENCODING_QOI, qoi_encode(width, height, rows)))
+        else:
+            images.append((name, width, height, stride, ENCODING_RAW, pixels))
+
+    count = len(images)
+    slots = 1
+    while slots < count * 2:
+        slots *= 2
+
+    index_offset = HEADER.size
+    hash_offset = index_offset + ENTRY.size * count
+    data_offset = align4(hash_offset + 2 * slots)
+
+    # Open-addressed name hash table: slot holds entry index + 1, 0 = empty
+    table = [0] * slots
+    for i, (name, *_rest) in enumerate(images):
+        slot = fnv1a(name) & (slots - 1)
+        while table[slot]:
+            slot = (slot + 1) & (slots - 1)
+        table[slot] = i + 1
+
+    entries = bytearray()
+    blob = bytearray()
+    for name, width, height, stride, encoding, data in images:
+        offset = data_offset + len(blob)
+        entries += ENTRY.pack(name, width, height, stride, FORMAT_RGB888_PLANAR, encoding,
+                              offset, len(data), zlib.crc32(data) & 0xFFFFFFFF, fnv1a(name))
+        blob += data
+        blob += b"\0" * (align4(len(blob)) - len(blob))
+
+    total = data_offset + len(blob)
+    header = HEADER.pack(MAGIC, VERSION, FORMAT_RGB888_PLANAR, 0, count, slots,
+                         index_offset, hash_offset, data_offset, total, *panel_levels(sources))
+    archive = header + entries + struct.pack("<%dH" % slots, *table)
+    archive += b"\0" * (data_offset - len(archive)) + blob
+
+    with open(output, "wb") as f:
+        f.write(archive)
+    print("Packed %d icons into %s (%d bytes, %d bytes of pixels uncompressed)" % (count, output, total, raw_total))
+    return total
+
+
+def partition_offset(csv_path, label):
+    """Offset of partition `label` in a PlatformIO partition CSV."""
+    with open(csv_path) as f:
+        for line in f:
+            fields = [x.strip() for x in line.split("#")[0].split(",")]
+            if len(fields) >= 4 and fields[0] == label:
+                return fields[3]
+    raise ValueError("partition %s not found in %s" % (label, csv_path))
+
+
+if "Import" not in globals() and __name__ == "__main__":
+    # Run directly with Python
+    parser = argparse.ArgumentParser(description="Pack BMP icons for the assets partition")
+    parser.add_argument("data_dir", nargs="?", default="data")
+    parser.add_argument("output", nargs="?", default="icons.pak")
+    parser.add_argument("--raw", action="store_true", help="store framebuffer layout instead of QOI")
+    parser.add_argument("--qoi-dir", help="write one .qoi file per BMP here instead of an archive")
+    parser.add_argument("--anim", nargs=2, metavar=("FRAMES_DIR", "OUTPUT"),
+                        help="encode the BMPs in FRAMES_DIR as one animation")
+    parser.add_argument("--frame-ms", type=int, default=100, help="animation frame time")
+    parser.add_argument("--key-interval", type=int, default=0, help="frames between animation keyframes (0 = first only)")
+    args = parser.parse_args()
+    if args.anim:
+        encode_animation(args.anim[0], args.anim[1], args.frame_ms, args.key_interval)
+    elif args.qoi_dir:
+        write_qoi_files(args.data_dir, args.qoi_dir)
+    else:
+        pack(args.data_dir, args.output, compress=not args.raw)
+elif "Import" in globals():
+    # Run by PlatformIO as an extra script (SCons provides Import)
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+
+    project_dir = env.subst("$PROJECT_DIR")  # noqa: F821
+    output = os.path.join(env.subst("$BUILD_DIR"), "icons.pak")  # noqa: F821
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+    pack(os.path.join(project_dir, "data"), output)
+
+    offset = partition_offset(os.path.join(project_dir, "partitions.csv"), "assets")
+    env.AddCustomTarget(  # noqa: F821
+        name="uploadassets",
+        dependencies=None,
+        actions=[
+            '"$PYTHONEXE" "$UPLOADER" --chip esp32 --port "$UPLOAD_PORT" --baud $UPLOAD_SPEED '
+            'write_flash %s "%s"' % (offset, output)
+        ],
+        title="Upload Icon Archive",
+        description="Write the packed icon archive to the assets partition",
+    )
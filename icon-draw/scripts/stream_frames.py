@@ -0,0 +1,149 @@
+"""Stream BMP frames to the panel over Serial, live (shared/FrameStream/frame_stream.h).
+
+Every packet carries the bounding box of what changed since the frame before, raw RGB565
+or run-length coded, whichever is smaller, with a CRC-32. A full frame goes out first and
+then every --key-interval packets, so a board that missed one recovers. The sketch shows
+streamed frames centred on the wall while packets keep coming and goes back to its own
+rotation a couple of seconds after the last one. Frames can be up to the canvas size.
+
+    python scripts/stream_frames.py --port COM5 data/i0.bmp            (one still)
+    python scripts/stream_frames.py --port COM5 --fps 30 --loop FRAMES_DIR
+    python scripts/stream_frames.py --output stream.bin FRAMES_DIR       (bytes to a file)
+
+Sending needs pyserial (pip install pyserial); --output does not.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+from pack_icons import read_bmp, rgb565_rows
+
+SYNC = b"\xA5\x5A"
+STREAM_FULL = 1
+STREAM_RECT = 2
+STREAM_RLE = 0x80
+HEADER = struct.Struct("<BBHHHHI")  # 14 bytes: type, sequence, x, y, w, h, payload length
+
+
+def load_frames(path):
+    """RGB565 frames (flat lists) of one BMP or of every BMP in a folder, in name order."""
+    if os.path.isdir(path):
+        files = [os.path.join(path, n) for n in sorted(os.listdir(path)) if n.lower().endswith(".bmp")]
+    else:
+        files = [path]
+    if not files:
+        raise ValueError("%s: no BMP files" % path)
+    frames = []
+    size = None
+    for name in files:
+        width, height, rows = read_bmp(name)
+        if size and size != (width, height):
+            raise ValueError("%s: %dx%d, expected %dx%d" % (name, width, height, size[0], size[1]))
+        size = (width, height)
+        frames.append([p for row in rgb565_rows(rows) for p in row])
+    return size[0], size[1], frames
+
+
+def changed_rect(frame, previous, width, height):
+    """(x, y, w, h) bounding the pixels that differ; (0, 0, 0, 0) when none do."""
+    if previous is None:
+        return 0, 0, width, height
+    x0, y0, x1, y1 = width, height, 0, 0
+    for y in range(height):
+        row = y * width
+        for x in range(width):
+            if frame[row + x] != previous[row + x]:
+                x0, x1 = min(x0, x), max(x1, x + 1)
+                y0, y1 = min(y0, y), y + 1
+    if x1 == 0:
+        return 0, 0, 0, 0
+    return x0, y0, x1 - x0, y1 - y0
+
+
+def encode_packet(frame, previous, width, height, sequence):
+    """One packet, byte for byte what streamEncode() produces."""
+    x, y, w, h = changed_rect(frame, previous, width, height)
+    pixels = [frame[(y + row) * width + x + col] for row in range(h) for col in range(w)]
+
+    runs = bytearray()
+    i = 0
+    while i < len(pixels):
+        count = 1
+        while i + count < len(pixels) and pixels[i + count] == pixels[i] and count < 256:
+            count += 1
+        runs += struct.pack("<BH", count - 1, pixels[i])
+        i += count
+    raw = struct.pack("<%dH" % len(pixels), *pixels)
+    rle = len(runs) < len(raw)
+    payload = bytes(runs) if rle else raw
+
+    kind = (STREAM_FULL if previous is None else STREAM_RECT) | (STREAM_RLE if rle else 0)
+    body = HEADER.pack(kind, sequence & 0xFF, x, y, w, h, len(payload)) + payload
+    return SYNC + body + struct.pack("<I", zlib.crc32(body))
+
+
+def packets(frames, width, height, loop, key_interval):
+    previous = None
+    sequence = 0
+    while True:
+        for frame in frames:
+            if key_interval and sequence % key_interval == 0:
+                previous = None
+            yield encode_packet(frame, previous, width, height, sequence)
+            previous = frame
+            sequence += 1
+        if not loop:
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream BMP frames to the panel over Serial")
+    parser.add_argument("frames", help="a BMP, or a folder of BMPs played in name order")
+    parser.add_argument("--port", help="serial port of the board")
+    parser.add_argument("--baud", type=int, default=921600, help="must match SERIAL_BAUD in main.cpp")
+    parser.add_argument("--output", help="write the packets to this file instead of a port")
+    parser.add_argument("--fps", type=float, default=0, help="frame rate (0 = as fast as the link takes them)")
+    parser.add_argument("--loop", action="store_true", help="repeat until interrupted")
+    parser.add_argument("--key-interval", type=int, default=60, help="packets between full frames (0 = first only)")
+    args = parser.parse_args()
+    if not args.port and not args.output:
+        parser.error("one of --port or --output is required")
+
+    width, height, frames = load_frames(args.frames)
+    if args.output:
+        out = open(args.output, "wb")
+    else:
+        import serial  # pyserial
+
+        out = serial.Serial(args.port, args.baud)
+
+    sent = 0
+    count = 0
+    start = time.monotonic()
+    try:
+        for packet in packets(frames, width, height, args.loop, args.key_interval):
+            out.write(packet)
+            sent += len(packet)
+            count += 1
+            if args.fps:
+                delay = start + count / args.fps - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if args.port:
+            out.flush()  # Wait for the port to drain so the rate below is what was sent
+        out.close()
+
+    elapsed = time.monotonic() - start
+    print("%d packets, %d bytes (%.0f per frame), %.1f fps" % (count, sent, sent / max(count, 1),
+                                                               count / elapsed if elapsed else 0))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,221 @@
+#include "anim_player.h"
+
+#include <string.h>
+
+#define ANIM_HEADER_SIZE 16
+#define ANIM_FRAME_HEADER_SIZE 8
+
+void animPlayerInit(AnimPlayer *player, BmpReadFn read, AnimSeekFn seek, void *ctx)
+{
+  memset(&player->header, 0, sizeof(player->header));
+  player->read = read;
+  player->seek = seek;
+  player->ctx = ctx;
+  player->changed.count = 0;
+  player->changed.all = false;
+  player->nextFrame = 0;
+  player->bytesRead = 0;
+  player->next = player->chunk;
+  player->limit = player->chunk;
+}
+
+// Pull the next block from the source
+static bool refill(AnimPlayer *player)
+{
+  size_t got = player->read(player->ctx, player->chunk, ANIM_CHUNK_SIZE);
+  player->bytesRead += got;
+  player->next = player->chunk;
+  player->limit = player->chunk + got;
+  return got > 0;
+}
+
+// Copy `length` bytes out of the stream, a chunk at a time
+static bool readBytes(AnimPlayer *player, uint8_t *dst, size_t length)
+{
+  while (length > 0)
+  {
+    if (player->next == player->limit && !refill(player))
+      return false;
+    size_t take = player->limit - player->next;
+    if (take > length)
+      take = length;
+    memcpy(dst, player->next, take);
+    player->next += take;
+    dst += take;
+    length -= take;
+  }
+  return true;
+}
+
+static inline uint16_t le16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+AnimStatus animPlayerOpen(AnimPlayer *player)
+{
+  uint8_t bytes[ANIM_HEADER_SIZE];
+  if (!readBytes(player, bytes, sizeof(bytes)))
+    return ANIM_READ_ERROR;
+
+  AnimHeader &header = player->header;
+  header.magic = le32(bytes);
+  header.version = le16(bytes + 4);
+  header.width = le16(bytes + 6);
+  header.height = le16(bytes + 8);
+  header.frameCount = le16(bytes + 10);
+  header.frameMs = le16(bytes + 12);
+  header.keyInterval = le16(bytes + 14);
+  if (header.magic != ANIM_MAGIC || header.version != ANIM_VERSION)
+    return ANIM_BAD_SIGNATURE;
+  if (header.width == 0 || header.height == 0 || header.width > INT16_MAX || header.height > INT16_MAX ||
+      header.frameCount == 0)
+    return ANIM_BAD_SIZE;
+
+  // Kept across animations of the same size
+  GlitchFramebuffer *fb = &player->frame;
+  if (!fb->allocated || fb->width != header.width || fb->height != header.height)
+  {
+    if (!allocateFramebuffer(fb, header.width, header.height, FB_RGB565))
+      return ANIM_NO_MEMORY;
+  }
+  player->nextFrame = 0;
+  return ANIM_OK;
+}
+
+// Record a changed span, giving up on the list once it is full
+static void noteChanged(AnimSpanList *changed, int16_t x, int16_t y, int16_t width)
+{
+  if (changed->all)
+    return;
+  if (changed->count == ANIM_MAX_SPANS)
+  {
+    changed->all = true;
+    return;
+  }
+  changed->spans[changed->count++] = {x, y, width};
+}
+
+// Decode one span's pixels straight into the frame
+static AnimStatus readSpan(AnimPlayer *player, uint32_t *consumed)
+{
+  uint8_t bytes[6];
+  if (!readBytes(player, bytes, sizeof(bytes)))
+    return ANIM_READ_ERROR;
+  uint16_t x = le16(bytes), y = le16(bytes + 2), length = le16(bytes + 4);
+  bool rle = length & ANIM_SPAN_RLE;
+  length &= ~ANIM_SPAN_RLE;
+
+  GlitchFramebuffer *fb = &player->frame;
+  if (length == 0 || y >= fb->height || x + length > fb->width)
+    return ANIM_BAD_SIZE;
+  uint16_t *row = (uint16_t *)framebufferRow(fb, y) + x;
+  *consumed += sizeof(bytes);
+
+  if (!rle)
+  {
+    // Little-endian RGB565 on a little-endian target: the bytes are the pixels
+    if (!readBytes(player, (uint8_t *)row, length * 2))
+      return ANIM_READ_ERROR;
+    *consumed += length * 2;
+  }
+  else
+  {
+    for (uint16_t done = 0; done < length;)
+    {
+      uint8_t run[3];
+      if (!readBytes(player, run, sizeof(run)))
+        return ANIM_READ_ERROR;
+      uint16_t count = run[0] + 1;
+      uint16_t color = le16(run + 1);
+      if (done + count > length)
+        return ANIM_BAD_SIZE;
+      for (uint16_t i = 0; i < count; i++)
+        row[done + i] = color;
+      done += count;
+      *consumed += sizeof(run);
+    }
+  }
+
+  noteChanged(&player->changed, x, y, length);
+  return ANIM_OK;
+}
+
+AnimStatus animPlayerNextFrame(AnimPlayer *player)
+{
+  if (player->nextFrame >= player->header.frameCount)
+  {
+    AnimStatus status = animPlayerRewind(player);
+    if (status != ANIM_OK)
+      return status;
+  }
+
+  uint8_t bytes[ANIM_FRAME_HEADER_SIZE];
+  if (!readBytes(player, bytes, sizeof(bytes)))
+    return ANIM_READ_ERROR;
+  uint8_t type = bytes[0];
+  uint16_t spanCount = le16(bytes + 2);
+  uint32_t size = le32(bytes + 4);
+
+  player->changed.count = 0;
+  player->changed.all = type == ANIM_FRAME_KEY;
+  uint32_t consumed = 0;
+  for (uint16_t i = 0; i < spanCount; i++)
+  {
+    AnimStatus status = readSpan(player, &consumed);
+    if (status != ANIM_OK)
+      return status;
+  }
+  if (consumed != size)
+    return ANIM_BAD_SIZE;
+
+  player->nextFrame++;
+  return ANIM_OK;
+}
+
+AnimStatus animPlayerRewind(AnimPlayer *player)
+{
+  if (!player->seek(player->ctx, ANIM_HEADER_SIZE))
+    return ANIM_READ_ERROR;
+  player->next = player->chunk;
+  player->limit = player->chunk;
+  player->nextFrame = 0;
+  return ANIM_OK;
+}
+
+void freeAnimPlayer(AnimPlayer *player)
+{
+  freeFramebuffer(&player->frame);
+}
+
+bool animMemorySeek(void *ctx, uint32_t offset)
+{
+  BmpMemorySource *source = (BmpMemorySource *)ctx;
+  if (offset > source->size)
+    return false;
+  source->position = offset;
+  return true;
+}
+
+const char *animStatusString(AnimStatus status)
+{
+  switch (status)
+  {
+  case ANIM_OK:
+    return "OK";
+  case ANIM_READ_ERROR:
+    return "Animation data ended early";
+  case ANIM_BAD_SIGNATURE:
+    return "Not an animation file";
+  case ANIM_BAD_SIZE:
+    return "Animation size or span invalid";
+  case ANIM_NO_MEMORY:
+    return "Animation framebuffer allocation failed";
+  }
+  return "Unknown animation error";
+}
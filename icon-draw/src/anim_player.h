@@ -0,0 +1,125 @@
+#ifndef ANIM_PLAYER_H
+#define ANIM_PLAYER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bmp_reader.h"
+#include "framebuffer.h"
+
+// Streaming player for animations written by scripts/pack_icons.py --anim. Only the
+// first frame (and optional later keyframes) is stored whole; every other frame is the
+// list of row spans that changed since the one before it, so an animation costs flash
+// and decode time in proportion to what moves. All fields little-endian.
+//
+//   AnimHeader
+//   frames, each:
+//     AnimFrameHeader
+//     spans, each:
+//       uint16_t x, y, length     bit 15 of length set: run-length coded
+//       raw:  length RGB565 pixels
+//       runs: (uint8_t count - 1, uint16_t RGB565) until length pixels are covered
+//
+// Frames are applied in place to one RGB565 framebuffer as they stream in, and the
+// spans each one touched are kept so only those need presenting. No Arduino
+// dependencies so it builds on a host.
+
+#define ANIM_MAGIC 0x4E414349 // "ICAN"
+#define ANIM_VERSION 1
+#define ANIM_CHUNK_SIZE 512   // Bytes read from the source per call
+#define ANIM_MAX_SPANS 64     // Changed spans kept per frame; more and the whole frame counts as changed
+#define ANIM_SPAN_RLE 0x8000  // Length flag: span is run-length coded
+
+enum AnimFrameType : uint8_t
+{
+  ANIM_FRAME_KEY,  // Every row in full: playback can start here
+  ANIM_FRAME_DELTA // Only what changed since the previous frame
+};
+
+enum AnimStatus : uint8_t
+{
+  ANIM_OK,
+  ANIM_READ_ERROR,    // Source ended early or a seek failed
+  ANIM_BAD_SIGNATURE, // Not "ICAN" or an unknown version
+  ANIM_BAD_SIZE,      // Zero size, or a span outside the frame
+  ANIM_NO_MEMORY      // Framebuffer allocation failed
+};
+
+struct AnimHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t width;
+  uint16_t height;
+  uint16_t frameCount;
+  uint16_t frameMs;     // Display time of each frame
+  uint16_t keyInterval; // Frames between keyframes (0 = only the first)
+};
+
+struct AnimFrameHeader
+{
+  uint8_t type; // AnimFrameType
+  uint8_t reserved;
+  uint16_t spanCount;
+  uint32_t size; // Bytes of span data that follow
+};
+
+// Part of a row that changed
+struct AnimSpan
+{
+  int16_t x;
+  int16_t y;
+  int16_t width;
+};
+
+// What the last frame changed
+struct AnimSpanList
+{
+  AnimSpan spans[ANIM_MAX_SPANS];
+  uint16_t count;
+  bool all; // Too many spans to list (or a keyframe): treat the whole frame as changed
+};
+
+// Repositions a source at an absolute byte offset. Returns false on failure.
+typedef bool (*AnimSeekFn)(void *ctx, uint32_t offset);
+
+struct AnimPlayer
+{
+  BmpReadFn read;
+  AnimSeekFn seek;
+  void *ctx;
+  AnimHeader header;
+  GlitchFramebuffer frame; // Current picture, RGB565 (uses frame.allocator if set)
+  AnimSpanList changed;    // Spans the last animPlayerNextFrame() wrote
+  uint16_t nextFrame;      // Index of the frame the source is positioned at
+  uint32_t bytesRead;      // From the source since open, for flash bandwidth figures
+  const uint8_t *next;     // Next unread byte of `chunk`
+  const uint8_t *limit;
+  uint8_t chunk[ANIM_CHUNK_SIZE];
+};
+
+// Set up a player over a seekable sequential source. The framebuffer is left alone, so
+// one player (starting zeroed: `AnimPlayer player = {}`) reuses it across animations of
+// the same size; set frame.allocator before the first open to place it elsewhere.
+void animPlayerInit(AnimPlayer *player, BmpReadFn read, AnimSeekFn seek, void *ctx);
+
+// Read and validate the header and allocate the framebuffer (once per size). The first
+// frame is decoded by the first animPlayerNextFrame() call.
+AnimStatus animPlayerOpen(AnimPlayer *player);
+
+// Apply the next frame in place, recording what changed. After the last frame playback
+// wraps to the first, which is always a keyframe.
+AnimStatus animPlayerNextFrame(AnimPlayer *player);
+
+// Back to the first frame (the next animPlayerNextFrame() decodes it)
+AnimStatus animPlayerRewind(AnimPlayer *player);
+
+// Release the framebuffer (the source is the caller's)
+void freeAnimPlayer(AnimPlayer *player);
+
+// Seek over in-memory data (a BmpMemorySource)
+bool animMemorySeek(void *ctx, uint32_t offset);
+
+// Human readable status for logging
+const char *animStatusString(AnimStatus status);
+
+#endif
@@ -0,0 +1,211 @@
+#include "asset_archive.h"
+#include "qoi_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(sizeof(AssetHeader) == 60, "AssetHeader must match scripts/pack_icons.py");
+static_assert(sizeof(AssetEntry) == 48, "AssetEntry must match scripts/pack_icons.py");
+
+#ifdef ARDUINO
+#include <esp_partition.h>
+#include <esp_idf_version.h>
+
+bool assetArchiveMap(AssetArchive *archive, const char *labelOrPath)
+{
+  const esp_partition_t *partition =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, labelOrPath);
+  if (!partition)
+    return false;
+
+  const void *ptr = nullptr;
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_partition_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle) != ESP_OK)
+    return false;
+#else
+  spi_flash_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK)
+    return false;
+#endif
+
+  if (!assetArchiveOpen(archive, (const uint8_t *)ptr, partition->size))
+  {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_partition_munmap(handle);
+#else
+    spi_flash_munmap(handle);
+#endif
+    return false;
+  }
+  archive->mapHandle = handle;
+  return true;
+}
+
+void assetArchiveUnmap(AssetArchive *archive)
+{
+  if (!archive->open)
+    return;
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_partition_munmap(archive->mapHandle);
+#else
+  spi_flash_munmap(archive->mapHandle);
+#endif
+  archive->open = false;
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool assetArchiveMap(AssetArchive *archive, const char *labelOrPath)
+{
+  int fd = open(labelOrPath, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  void *ptr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED)
+    return false;
+
+  if (!assetArchiveOpen(archive, (const uint8_t *)ptr, st.st_size))
+  {
+    munmap(ptr, st.st_size);
+    return false;
+  }
+  archive->mapHandle = (uint32_t)st.st_size;
+  return true;
+}
+
+void assetArchiveUnmap(AssetArchive *archive)
+{
+  if (!archive->open)
+    return;
+  munmap((void *)archive->base, archive->mapHandle);
+  archive->open = false;
+}
+#endif
+
+uint32_t assetNameHash(const char *name)
+{
+  uint32_t h = 0x811C9DC5;
+  while (*name)
+  {
+    h ^= (uint8_t)*name++;
+    h *= 0x01000193;
+  }
+  return h;
+}
+
+uint32_t assetCrc32(const uint8_t *data, size_t length)
+{
+  // Nibble-wise table keeps the code small and flash-friendly
+  static const uint32_t table[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+bool assetArchiveOpen(AssetArchive *archive, const uint8_t *base, size_t size)
+{
+  memset(archive, 0, sizeof(*archive));
+  if (size < sizeof(AssetHeader))
+    return false;
+
+  const AssetHeader *header = (const AssetHeader *)base;
+  if (header->magic != ASSET_MAGIC || header->version != ASSET_VERSION || header->totalSize > size)
+    return false;
+
+  // Hash table size must be a power of two for the probe mask
+  if (header->hashSlots == 0 || (header->hashSlots & (header->hashSlots - 1)) != 0)
+    return false;
+
+  if (header->indexOffset + (size_t)header->count * sizeof(AssetEntry) > header->totalSize ||
+      header->hashOffset + (size_t)header->hashSlots * sizeof(uint16_t) > header->totalSize)
+    return false;
+
+  archive->base = base;
+  archive->size = header->totalSize;
+  archive->header = header;
+  archive->entries = (const AssetEntry *)(base + header->indexOffset);
+  archive->slots = (const uint16_t *)(base + header->hashOffset);
+
+  // Every image must lie inside the archive
+  for (uint16_t i = 0; i < header->count; i++)
+  {
+    const AssetEntry *entry = &archive->entries[i];
+    if ((size_t)entry->offset + entry->size > header->totalSize)
+      return false;
+  }
+
+  archive->open = true;
+  return true;
+}
+
+int assetArchiveFind(const AssetArchive *archive, const char *name)
+{
+  if (!archive->open)
+    return -1;
+
+  uint32_t hash = assetNameHash(name);
+  uint16_t mask = archive->header->hashSlots - 1;
+
+  // Linear probing; the table is at most half full so probes stay short
+  for (uint16_t probe = 0, slot = hash & mask; probe <= mask; probe++, slot = (slot + 1) & mask)
+  {
+    uint16_t value = archive->slots[slot];
+    if (value == 0)
+      return -1;
+
+    const AssetEntry *entry = &archive->entries[value - 1];
+    if (entry->nameHash == hash && strncmp(entry->name, name, ASSET_NAME_LEN) == 0)
+      return value - 1;
+  }
+  return -1;
+}
+
+bool assetArchiveLoad(const AssetArchive *archive, uint16_t index, GlitchFramebuffer *fb, bool verify)
+{
+  if (!archive->open || index >= archive->header->count)
+    return false;
+
+  const AssetEntry *entry = &archive->entries[index];
+  const uint8_t *pixels = archive->base + entry->offset;
+
+  if (verify && assetCrc32(pixels, entry->size) != entry->crc32)
+    return false;
+
+  if (!allocateFramebuffer(fb, entry->width, entry->height, (FramebufferFormat)entry->format))
+    return false;
+
+  if (entry->encoding == ASSET_ENCODING_QOI)
+  {
+    // Decode in place from the mapping, writing pixels straight to their final position
+    QoiReader reader;
+    qoiReaderInitMemory(&reader, pixels, entry->size);
+    if (qoiReadHeader(&reader) == QOI_OK && qoiDecodeToFramebuffer(&reader, fb) == QOI_OK)
+      return true;
+  }
+  else if (entry->encoding == ASSET_ENCODING_RAW && framebufferSize(fb) == entry->size && fb->stride == entry->stride)
+  {
+    // The packer wrote the exact framebuffer layout, so this is a single bulk copy
+    memcpy(fb->data, pixels, entry->size);
+    return true;
+  }
+
+  freeFramebuffer(fb);
+  return false;
+}
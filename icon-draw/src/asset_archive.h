@@ -0,0 +1,108 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "framebuffer.h"
+
+// Packed icon archive written by scripts/pack_icons.py. All fields little-endian.
+//
+//   AssetHeader
+//   AssetEntry[count]          index, in name order
+//   uint16_t[hashSlots]        open-addressed FNV-1a name table: entry index + 1, 0 = empty
+//   image data                 each image QOI-compressed or in framebuffer layout, 4-byte aligned
+//
+// The archive lives in the "assets" flash partition and is read through a memory
+// mapping, so images never go through the filesystem.
+
+#define ASSET_MAGIC 0x4B504349 // "ICPK"
+#define ASSET_VERSION 3
+#define ASSET_NAME_LEN 24
+#define ASSET_PARTITION_LABEL "assets"
+
+// How an entry's bytes are stored
+enum AssetEncoding : uint8_t
+{
+  ASSET_ENCODING_RAW, // Framebuffer layout, loaded with one memcpy
+  ASSET_ENCODING_QOI  // QOI stream, decoded straight into the framebuffer
+};
+
+struct AssetHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint8_t format; // FramebufferFormat of every image
+  uint8_t reserved;
+  uint16_t count;
+  uint16_t hashSlots; // Power of two
+  uint32_t indexOffset;
+  uint32_t hashOffset;
+  uint32_t dataOffset;
+  uint32_t totalSize;
+  // Channel levels the images put on the panel (RGB565 expanded to 8 bits), bit n % 32
+  // of word n / 32 for level n: the colour depth is chosen from these before the display starts
+  uint32_t levels[8];
+};
+
+struct AssetEntry
+{
+  char name[ASSET_NAME_LEN]; // File name without extension, NUL padded
+  uint16_t width;
+  uint16_t height;
+  uint16_t stride; // Bytes per row of one plane
+  uint8_t format;   // FramebufferFormat the image is loaded as
+  uint8_t encoding; // AssetEncoding
+  uint32_t offset;  // From the start of the archive
+  uint32_t size;    // Bytes stored
+  uint32_t crc32;   // Of the stored bytes
+  uint32_t nameHash;
+};
+
+// An opened (mapped) archive
+struct AssetArchive
+{
+  const uint8_t *base;
+  size_t size;
+  const AssetHeader *header;
+  const AssetEntry *entries;
+  const uint16_t *slots;
+  uint32_t mapHandle; // Platform mapping handle (spi_flash_mmap_handle_t or mmap length)
+  bool open;
+};
+
+// Validate an archive already in memory
+bool assetArchiveOpen(AssetArchive *archive, const uint8_t *base, size_t size);
+
+// Map the "assets" flash partition (ESP32) or a file (host) and open it
+bool assetArchiveMap(AssetArchive *archive, const char *labelOrPath);
+
+// Release the mapping
+void assetArchiveUnmap(AssetArchive *archive);
+
+// Number of images
+inline uint16_t assetArchiveCount(const AssetArchive *archive)
+{
+  return archive->open ? archive->header->count : 0;
+}
+
+// Index entry for image `index`
+inline const AssetEntry *assetArchiveEntry(const AssetArchive *archive, uint16_t index)
+{
+  return &archive->entries[index];
+}
+
+// Index of the image called `name` (without extension), or -1. Expected O(1).
+int assetArchiveFind(const AssetArchive *archive, const char *name);
+
+// Load image `index` into a framebuffer with one allocation: a memcpy for raw entries,
+// a single decoding pass over the mapped data for QOI ones. With `verify` the CRC32 of
+// the stored bytes is checked first.
+bool assetArchiveLoad(const AssetArchive *archive, uint16_t index, GlitchFramebuffer *fb, bool verify);
+
+// FNV-1a hash used for names
+uint32_t assetNameHash(const char *name);
+
+// Standard CRC-32 (same as zlib.crc32)
+uint32_t assetCrc32(const uint8_t *data, size_t length);
+
+#endif
@@ -0,0 +1,99 @@
+#include "bitplane_encoder.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// The library's lumConvTab: 8-bit level to 16-bit PWM value through CIE 1931 lightness
+static uint16_t cie1931(uint8_t level)
+{
+  float lightness = level * 100.0f / 255.0f;
+  float luminance = lightness <= 8.0f ? lightness / 903.3f : powf((lightness + 16.0f) / 116.0f, 3.0f);
+  return (uint16_t)lroundf(luminance * 65535.0f);
+}
+
+// One channel value (already expanded to 8 bits) as its planes, a nibble each
+static uint32_t spreadPlanes(uint8_t level, uint8_t depth, bool cie, uint8_t bit)
+{
+  uint16_t value = cie ? cie1931(level) : (uint16_t)(level << 8);
+  uint32_t planes = 0;
+  for (uint8_t p = 0; p < depth; p++)
+  {
+    if (value & (1 << (p + 16 - depth)))
+      planes |= (uint32_t)1 << (p * 4 + bit);
+  }
+  return planes;
+}
+
+bool bitplaneLayoutInit(BitplaneLayout *layout, int16_t panelWidth, int16_t panelHeight, uint8_t chain,
+                        uint8_t depth, bool cie1931, bool swapPairs)
+{
+  if (depth == 0 || depth > BITPLANE_MAX_DEPTH)
+    return false;
+
+  layout->width = panelWidth * chain;
+  layout->rows = panelHeight / 2;
+  layout->depth = depth;
+  layout->swapPairs = swapPairs;
+
+  // RGB565 to 8 bits the way the library's drawPixel expands it
+  for (int i = 0; i < 32; i++)
+  {
+    uint8_t level = (i << 3) | (i >> 2);
+    layout->red[i] = spreadPlanes(level, depth, cie1931, 0);
+    layout->blue[i] = spreadPlanes(level, depth, cie1931, 2);
+  }
+  for (int i = 0; i < 64; i++)
+    layout->green[i] = spreadPlanes((i << 2) | (i >> 4), depth, cie1931, 1);
+  return true;
+}
+
+void bitplaneEncodeRun(const BitplaneLayout *layout, uint16_t *words, const uint16_t *rgb565, int16_t count, int16_t x,
+                       int16_t y, int16_t dx, int16_t dy)
+{
+  const int16_t width = layout->width;
+  const uint8_t depth = layout->depth;
+
+  for (int16_t i = 0; i < count; i++, x += dx, y += dy)
+  {
+    uint16_t color = rgb565[i];
+    uint32_t planes = layout->red[color >> 11] | layout->green[(color >> 5) & 0x3F] | layout->blue[color & 0x1F];
+
+    // The lower half of the panel shares its row pair with the upper half
+    int16_t row = y;
+    uint8_t shift = 0;
+    if (row >= layout->rows)
+    {
+      row -= layout->rows;
+      shift = BITPLANE_RGB2_SHIFT;
+    }
+
+    uint16_t keep = ~(7 << shift);
+    uint16_t *word = words + (size_t)row * depth * width + (layout->swapPairs ? x ^ 1 : x);
+    for (uint8_t p = 0; p < depth; p++, word += width, planes >>= 4)
+      *word = (*word & keep) | ((planes & 7) << shift);
+  }
+}
+
+void bitplaneEncode(const BitplaneLayout *layout, uint16_t *words, const uint16_t *rgb565, int16_t stride)
+{
+  for (int16_t y = 0; y < layout->rows * 2; y++)
+    bitplaneEncodeRun(layout, words, rgb565 + (size_t)y * stride, layout->width, 0, y, 1, 0);
+}
+
+bool allocateBitplaneFrame(BitplaneFrame *frame, const BitplaneLayout *layout)
+{
+  freeBitplaneFrame(frame);
+  size_t count = bitplaneWordCount(layout);
+  frame->words = (uint16_t *)calloc(count, sizeof(uint16_t));
+  if (!frame->words)
+    return false;
+  frame->count = count;
+  return true;
+}
+
+void freeBitplaneFrame(BitplaneFrame *frame)
+{
+  free(frame->words);
+  frame->words = nullptr;
+  frame->count = 0;
+}
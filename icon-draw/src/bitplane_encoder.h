@@ -0,0 +1,74 @@
+#ifndef BITPLANE_ENCODER_H
+#define BITPLANE_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Encodes pixels straight into the HUB75 DMA layout, so a frame can be converted once
+// (at load, or offline) instead of on every drawPixel call.
+//
+// The panel library keeps one 16-bit word per pixel column for every row pair and bit
+// plane: rows y and y + height/2 are clocked out together, the upper one on R1 G1 B1
+// (bits 0-2), the lower on R2 G2 B2 (bits 3-5). Plane p holds bit p + 16 - depth of each
+// channel after the 8-bit value has gone through the library's CIE 1931 luminance table.
+// Words are stored [row][plane][column]; on the ESP32 the I2S FIFO swaps each pair of
+// 16-bit words, so pixel x sits at column x ^ 1. The remaining bits (address, latch,
+// OE) belong to the driver and are never touched. FM6126A panels only differ in the
+// register setup the driver sends at begin(); their data goes out in the same order.
+//
+// Colours come in as RGB565 (what the present path produces), expanded to 8 bits the
+// way the library's drawPixel does. No Arduino dependencies so it builds on a host.
+
+#define BITPLANE_MAX_DEPTH 8   // Planes are packed a nibble each into 32 bits
+#define BITPLANE_RGB2_SHIFT 3  // Lower half of the panel: R2 G2 B2
+#define BITPLANE_RGB_MASK 0x3F // R1 G1 B1 R2 G2 B2
+
+struct BitplaneLayout
+{
+  int16_t width; // Columns per DMA row: panel width x chain length
+  int16_t rows;  // Row pairs: panel height / 2
+  uint8_t depth; // Bit planes per row (the library's PIXEL_COLOR_DEPTH_BITS)
+  bool swapPairs; // ESP32 I2S word order (not on the S3's LCD peripheral)
+  // Each RGB565 channel value with its planes spread one nibble per plane, already in
+  // the channel's bit (R 0, G 1, B 2), so a pixel's planes are red | green | blue
+  uint32_t red[32];
+  uint32_t green[64];
+  uint32_t blue[32];
+};
+
+// Set up the layout for a chain of `chain` panels. `cie1931` must match the library
+// build (false when it is built with NO_CIE1931). Floating point is only used here.
+// Returns false for an unsupported depth.
+bool bitplaneLayoutInit(BitplaneLayout *layout, int16_t panelWidth, int16_t panelHeight, uint8_t chain,
+                        uint8_t depth = BITPLANE_MAX_DEPTH, bool cie1931 = true, bool swapPairs = true);
+
+// Words in a whole encoded chain
+inline size_t bitplaneWordCount(const BitplaneLayout *layout)
+{
+  return (size_t)layout->rows * layout->depth * layout->width;
+}
+
+// Encode `count` RGB565 pixels into `words` (bitplaneWordCount long, [row][plane][column]),
+// the first at chain position (x, y) and each next one (dx, dy) further on. Only the
+// pixels' own bits change. A pure function: same inputs, same words.
+void bitplaneEncodeRun(const BitplaneLayout *layout, uint16_t *words, const uint16_t *rgb565, int16_t count, int16_t x,
+                       int16_t y, int16_t dx, int16_t dy);
+
+// Encode a whole chain-sized RGB565 image (`stride` pixels per row)
+void bitplaneEncode(const BitplaneLayout *layout, uint16_t *words, const uint16_t *rgb565, int16_t stride);
+
+// An encoded chain, e.g. a pre-encoded icon
+struct BitplaneFrame
+{
+  uint16_t *words;
+  size_t count;
+};
+
+#define BITPLANE_FRAME_INIT {nullptr, 0}
+
+// Allocate a black frame for the layout (frees a previous one). Returns false on failure.
+bool allocateBitplaneFrame(BitplaneFrame *frame, const BitplaneLayout *layout);
+
+void freeBitplaneFrame(BitplaneFrame *frame);
+
+#endif
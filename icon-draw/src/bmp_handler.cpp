@@ -1,157 +1,312 @@
 #include "bmp_handler.h"
+#include "bmp_reader.h"
+#include "qoi_reader.h"
+#include "pixel_convert.h"
+#include <frame_profiler.h>
 
 /*--------------------- DEBUG -------------------------*/
 #define Sprintln(a) (Serial.println(a))
 #define Sprint(a) (Serial.print(a))
 
-// BMP decoder function for 24-bit BMP files
-bool drawBMP(MatrixPanel_I2S_DMA *display, const char *filename, int16_t x, int16_t y)
+// Widest row the present stage converts on the stack
+#define PRESENT_MAX_WIDTH 256
+
+// Present one RGB565 row: runs of identical colour go out as a single line fill (a DMA
+// line fill in the panel library), lone pixels as drawPixel. Runs are split where the
+// row crosses from one panel to the next, and only panels in `panels` are written.
+// Returns the number of display calls made.
+uint32_t presentRow565(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const uint16_t *row, int16_t width,
+                       int16_t x, int16_t y, uint32_t panels)
 {
-  File bmpFile = LittleFS.open(filename, "r");
-  if (!bmpFile)
+  uint32_t calls = 0;
+  CanvasRect span = {x, y, width, 1};
+  panels &= canvasPanelsIn(canvas, &span);
+
+  for (uint8_t i = 0; panels; i++, panels >>= 1)
   {
-    Sprintln("Failed to open BMP file");
-    return false;
+    CanvasRect part;
+    if (!(panels & 1) || !canvasIntersect(&span, &canvas->panels[i].area, &part))
+      continue;
+
+    int16_t start = part.x - x;
+    int16_t limit = start + part.w;
+    while (start < limit)
+    {
+      uint16_t color = row[start];
+      int16_t end = start + 1;
+      while (end < limit && row[end] == color)
+        end++;
+
+      CanvasRect run = {(int16_t)(x + start), y, (int16_t)(end - start), 1};
+      CanvasRect out = canvasToChain(canvas, i, &run);
+      canvasFillChainRect(display, &out, color);
+      calls++;
+      start = end;
+    }
   }
 
-  // Read BMP header
-  uint16_t signature = bmpFile.read() | (bmpFile.read() << 8);
-  if (signature != 0x4D42) // "BM" in little-endian
+  return calls;
+}
+
+// Pixels [x0, x0 + width) of row `py` as RGB565, converted into `line` (PRESENT_MAX_WIDTH,
+// word aligned) or, for RGB565 frames, straight from the framebuffer. Returns the span's
+// first pixel. Indexed frames become RGB565 only here, through the palette lookup table.
+static const uint16_t *frameRow565(const GlitchFramebuffer *frame, int16_t py, int16_t x0, int16_t width,
+                                   uint16_t *line)
+{
+  const uint8_t *row = framebufferRow(frame, py);
+  switch (frame->format)
   {
-    Sprintln("Not a valid BMP file");
-    bmpFile.close();
-    return false;
+  case FB_RGB888_PLANAR:
+    row += x0;
+    convertPlanarTo565(line, row, row + frame->planeSize, row + 2 * frame->planeSize, width);
+    return line;
+  case FB_RGB888_INTERLEAVED:
+    convertRGB888To565(line, row + x0 * 3, width);
+    return line;
+  case FB_RGB565:
+    // Already in display format, present straight from the framebuffer
+    return (const uint16_t *)row + x0;
+  case FB_INDEXED8:
+  {
+    const uint16_t *palette = framebufferPalette(frame);
+    for (int16_t px = 0; px < width; px++)
+      line[px] = palette[row[x0 + px]];
+    return line;
   }
+  default:
+  {
+    const uint16_t *palette = framebufferPalette(frame);
+    uint8_t bits = framebufferBitsPerPixel(frame->format);
+    for (int16_t px = 0; px < width; px++)
+      line[px] = palette[framebufferGetIndex(row, x0 + px, bits)];
+    return line;
+  }
+  }
+}
 
-  // Skip file size (4 bytes) and reserved fields (4 bytes)
-  bmpFile.seek(10);
-  uint32_t dataOffset = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
+// Present a whole finished frame in one pass
+uint32_t presentFramebuffer(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const GlitchFramebuffer *frame,
+                            int16_t x, int16_t y, uint32_t panels)
+{
+  if (!frame->allocated || frame->width > PRESENT_MAX_WIDTH)
+    return 0;
 
-  // Read DIB header
-  bmpFile.seek(18);
-  int32_t width = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
-  int32_t height = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
+  alignas(4) uint16_t line[PRESENT_MAX_WIDTH]; // Word-aligned for the conversion kernels
+  uint32_t calls = 0;
+  uint32_t convertTicks = 0;
+  uint32_t presentTicks = 0;
 
-  bmpFile.seek(28);
-  uint16_t bitsPerPixel = bmpFile.read() | (bmpFile.read() << 8);
+  for (int16_t py = 0; py < frame->height; py++)
+  {
+    // Rows that only cross panels left alone are not even converted
+    CanvasRect span = {x, (int16_t)(y + py), frame->width, 1};
+    uint32_t rowPanels = panels & canvasPanelsIn(canvas, &span);
+    if (!rowPanels)
+      continue;
+
+    uint32_t start = PROFILE_NOW();
+    const uint16_t *out = frameRow565(frame, py, 0, frame->width, line);
+    uint32_t converted = PROFILE_NOW();
+    calls += presentRow565(display, canvas, out, frame->width, x, y + py, rowPanels);
+    convertTicks += converted - start;
+    presentTicks += PROFILE_NOW() - converted;
+  }
 
-  Sprint("BMP: ");
-  Sprint(width);
-  Sprint("x");
-  Sprint(height);
-  Sprint(" @ ");
-  Sprint(bitsPerPixel);
-  Sprintln("bpp");
+  // Conversion and display writes alternate per row; record each as one sample per frame
+  PROFILE_RECORD(PROFILE_CONVERT, convertTicks);
+  PROFILE_RECORD(PROFILE_PRESENT, presentTicks);
+  return calls;
+}
 
-  // We only support 24-bit BMP
-  if (bitsPerPixel != 24)
+// Present the changed spans of a frame
+uint32_t presentFramebufferSpans(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas,
+                                 const GlitchFramebuffer *frame, const AnimSpanList *changed, int16_t x, int16_t y,
+                                 uint32_t panels)
+{
+  if (changed->all)
+    return presentFramebuffer(display, canvas, frame, x, y, panels);
+  if (!frame->allocated || frame->width > PRESENT_MAX_WIDTH)
+    return 0;
+
+  alignas(4) uint16_t line[PRESENT_MAX_WIDTH];
+  uint32_t calls = 0;
+  PROFILE_SCOPE(PROFILE_PRESENT);
+  for (uint16_t i = 0; i < changed->count; i++)
   {
-    Sprintln("Only 24-bit BMP supported");
-    bmpFile.close();
-    return false;
+    // Only the span's pixels are converted
+    const AnimSpan &span = changed->spans[i];
+    const uint16_t *out = frameRow565(frame, span.y, span.x, span.width, line);
+    calls += presentRow565(display, canvas, out, span.width, x + span.x, y + span.y, panels);
   }
+  return calls;
+}
 
-  // Calculate row size (must be multiple of 4 bytes)
-  uint32_t rowSize = ((width * 3 + 3) / 4) * 4;
-  uint8_t row[rowSize];
+// Encode a frame into bit planes, row by row: each canvas row is split per panel and
+// handed to the encoder as a run in chain coordinates (a rotated panel's rows run down
+// a column of the chain, so the run steps vertically)
+uint32_t encodeFramebuffer(const BitplaneLayout *layout, uint16_t *words, const VirtualCanvas *canvas,
+                           const GlitchFramebuffer *frame, int16_t x, int16_t y, uint32_t panels)
+{
+  if (!frame->allocated || frame->width > PRESENT_MAX_WIDTH)
+    return 0;
+
+  alignas(4) uint16_t line[PRESENT_MAX_WIDTH];
+  uint32_t encoded = 0;
 
-  // BMP images are stored bottom-to-top
-  for (int16_t row_idx = height - 1; row_idx >= 0; row_idx--)
+  for (int16_t py = 0; py < frame->height; py++)
   {
-    bmpFile.seek(dataOffset + row_idx * rowSize);
-    bmpFile.read(row, rowSize);
+    CanvasRect span = {x, (int16_t)(y + py), frame->width, 1};
+    uint32_t rowPanels = panels & canvasPanelsIn(canvas, &span);
+    if (!rowPanels)
+      continue;
 
-    for (int16_t col = 0; col < width; col++)
+    const uint16_t *out = frameRow565(frame, py, 0, frame->width, line);
+    for (uint8_t i = 0; rowPanels; i++, rowPanels >>= 1)
     {
-      // BMP stores pixels as BGR
-      uint8_t b = row[col * 3];
-      uint8_t g = row[col * 3 + 1];
-      uint8_t r = row[col * 3 + 2];
-
-      // Convert RGB888 to RGB565
-      uint16_t color565 = display->color565(r, g, b);
-      display->drawPixel(x + col, y + (height - 1 - row_idx), color565);
+      CanvasRect part;
+      if (!(rowPanels & 1) || !canvasIntersect(&span, &canvas->panels[i].area, &part))
+        continue;
+
+      // Chain position of the first two pixels gives the direction of the run
+      CanvasRect first = {part.x, part.y, 1, 1};
+      CanvasRect second = {(int16_t)(part.x + 1), part.y, 1, 1};
+      CanvasRect start = canvasToChain(canvas, i, &first);
+      CanvasRect next = part.w > 1 ? canvasToChain(canvas, i, &second) : start;
+      bitplaneEncodeRun(layout, words, out + (part.x - x), part.w, start.x, start.y, next.x - start.x,
+                        next.y - start.y);
+      encoded += part.w;
     }
   }
+  return encoded;
+}
 
-  bmpFile.close();
-  Sprintln("BMP loaded successfully");
-  return true;
+// Read callback for a LittleFS file
+static size_t fileRead(void *ctx, uint8_t *dst, size_t len)
+{
+  return ((File *)ctx)->read(dst, len);
 }
 
-// Draw BMP from embedded PROGMEM array (no LittleFS needed)
-bool drawEmbeddedBMP(MatrixPanel_I2S_DMA *display, const unsigned char *bmp_data, int16_t x, int16_t y)
+// Seek callback for a LittleFS file
+static bool fileSeek(void *ctx, uint32_t offset)
 {
-  // Read BMP header from PROGMEM
-  uint16_t signature = pgm_read_byte(bmp_data) | (pgm_read_byte(bmp_data + 1) << 8);
-  if (signature != 0x4D42) // "BM" in little-endian
-  {
-    Sprintln("Not a valid BMP file");
-    return false;
-  }
+  return ((File *)ctx)->seek(offset);
+}
+
+// Row sink that converts BMP rows to RGB565 and presents them at an offset
+struct PresentRowTarget
+{
+  MatrixPanel_I2S_DMA *display;
+  const VirtualCanvas *canvas;
+  int16_t x;
+  int16_t y;
+  int16_t width;
+};
+
+static void presentBMPRow(void *ctx, int16_t row, const uint8_t *bgr)
+{
+  PresentRowTarget *target = (PresentRowTarget *)ctx;
+  alignas(4) uint16_t line[PRESENT_MAX_WIDTH]; // Word-aligned for the conversion kernels
 
-  // Get data offset
-  uint32_t dataOffset = pgm_read_byte(bmp_data + 10) |
-                        (pgm_read_byte(bmp_data + 11) << 8) |
-                        (pgm_read_byte(bmp_data + 12) << 16) |
-                        (pgm_read_byte(bmp_data + 13) << 24);
+  // BMP stores pixels as BGR; convert the row to RGB565 and present it in runs
+  convertBGR888To565(line, bgr, target->width);
+  presentRow565(target->display, target->canvas, line, target->width, target->x, target->y + row);
+}
 
-  // Get width and height
-  int32_t width = pgm_read_byte(bmp_data + 18) |
-                  (pgm_read_byte(bmp_data + 19) << 8) |
-                  (pgm_read_byte(bmp_data + 20) << 16) |
-                  (pgm_read_byte(bmp_data + 21) << 24);
+// Row sink that stores BMP rows in a framebuffer
+static void storeBMPRow(void *ctx, int16_t row, const uint8_t *bgr)
+{
+  framebufferWriteRowBGR((GlitchFramebuffer *)ctx, row, bgr);
+}
 
-  int32_t height = pgm_read_byte(bmp_data + 22) |
-                   (pgm_read_byte(bmp_data + 23) << 8) |
-                   (pgm_read_byte(bmp_data + 24) << 16) |
-                   (pgm_read_byte(bmp_data + 25) << 24);
+// Row sink that stores packed palette indices in an indexed framebuffer
+static void storeIndexRow(void *ctx, int16_t row, const uint8_t *indices)
+{
+  framebufferWriteRowIndices((GlitchFramebuffer *)ctx, row, indices);
+}
 
-  // Get bits per pixel
-  uint16_t bitsPerPixel = pgm_read_byte(bmp_data + 28) | (pgm_read_byte(bmp_data + 29) << 8);
+// Parse the header and log the image details. Returns false (after logging) on failure.
+static bool readBMPHeader(BmpReader *reader, const char *label)
+{
+  BmpStatus status = bmpReadHeader(reader);
+  if (status != BMP_OK)
+  {
+    Sprintln(bmpStatusString(status));
+    return false;
+  }
 
-  Sprint("Embedded BMP: ");
-  Sprint(width);
+  Sprint(label);
+  Sprint(reader->info.width);
   Sprint("x");
-  Sprint(height);
+  Sprint(reader->info.height);
   Sprint(" @ ");
-  Sprint(bitsPerPixel);
+  Sprint(reader->info.bitsPerPixel);
   Sprintln("bpp");
+  return true;
+}
 
-  // We only support 24-bit BMP
-  if (bitsPerPixel != 24)
+// Stream a parsed BMP straight to the display
+static bool presentBMP(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, BmpReader *reader, int16_t x,
+                       int16_t y)
+{
+  if (reader->info.width > PRESENT_MAX_WIDTH)
   {
-    Sprintln("Only 24-bit BMP supported");
+    Sprintln("BMP too wide");
     return false;
   }
 
-  // Calculate row size (must be multiple of 4 bytes)
-  uint32_t rowSize = ((width * 3 + 3) / 4) * 4;
-
-  // BMP images are stored bottom-to-top
-  for (int16_t row_idx = height - 1; row_idx >= 0; row_idx--)
+  PresentRowTarget target = {display, canvas, x, y, (int16_t)reader->info.width};
+  BmpStatus status = bmpReadRows(reader, presentBMPRow, &target);
+  if (status != BMP_OK)
   {
-    uint32_t rowStart = dataOffset + row_idx * rowSize;
+    Sprintln(bmpStatusString(status));
+    return false;
+  }
+  return true;
+}
 
-    for (int16_t col = 0; col < width; col++)
-    {
-      // BMP stores pixels as BGR
-      uint8_t b = pgm_read_byte(bmp_data + rowStart + col * 3);
-      uint8_t g = pgm_read_byte(bmp_data + rowStart + col * 3 + 1);
-      uint8_t r = pgm_read_byte(bmp_data + rowStart + col * 3 + 2);
-
-      // Convert RGB888 to RGB565
-      uint16_t color565 = display->color565(r, g, b);
-      display->drawPixel(x + col, y + (height - 1 - row_idx), color565);
-    }
+// BMP decoder function for 24-bit and palettized BMP files
+bool drawBMP(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const char *filename, int16_t x, int16_t y)
+{
+  File bmpFile = LittleFS.open(filename, "r");
+  if (!bmpFile)
+  {
+    Sprintln("Failed to open BMP file");
+    return false;
   }
 
+  // One header read, then sequential chunked reads of the pixel data (no seeks)
+  BmpReader reader;
+  bmpReaderInit(&reader, fileRead, &bmpFile);
+  bool ok = readBMPHeader(&reader, "BMP: ") && presentBMP(display, canvas, &reader, x, y);
+
+  bmpFile.close();
+  if (ok)
+    Sprintln("BMP loaded successfully");
+  return ok;
+}
+
+// Draw BMP from embedded PROGMEM array (no LittleFS needed)
+bool drawEmbeddedBMP(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const unsigned char *bmp_data,
+                     int16_t x, int16_t y)
+{
+  // Flash is memory mapped on the ESP32, so the array can be read like RAM. The total
+  // size comes from the BMP file header; some encoders leave it 0, then trust the array.
+  uint32_t fileSize = pgm_read_byte(bmp_data + 2) | (pgm_read_byte(bmp_data + 3) << 8) |
+                      (pgm_read_byte(bmp_data + 4) << 16) | ((uint32_t)pgm_read_byte(bmp_data + 5) << 24);
+  BmpMemorySource source = {bmp_data, fileSize ? fileSize : SIZE_MAX, 0};
+
+  BmpReader reader;
+  bmpReaderInit(&reader, bmpMemoryRead, &source);
+  if (!readBMPHeader(&reader, "Embedded BMP: ") || !presentBMP(display, canvas, &reader, x, y))
+    return false;
+
   Sprintln("Embedded BMP loaded successfully");
   return true;
 }
 
 // Load BMP into framebuffer for glitch effects
-bool loadBMPToFramebuffer(const char *filename, GlitchFramebuffer *fb)
+bool loadBMPToFramebuffer(const char *filename, GlitchFramebuffer *fb, FramebufferFormat format)
 {
   File bmpFile = LittleFS.open(filename, "r");
   if (!bmpFile)
@@ -160,203 +315,142 @@ bool loadBMPToFramebuffer(const char *filename, GlitchFramebuffer *fb)
     return false;
   }
 
-  // Read BMP header
-  uint16_t signature = bmpFile.read() | (bmpFile.read() << 8);
-  if (signature != 0x4D42)
+  BmpReader reader;
+  bmpReaderInit(&reader, fileRead, &bmpFile);
+  if (!readBMPHeader(&reader, "Loading to framebuffer: "))
   {
-    Sprintln("Not a valid BMP file");
     bmpFile.close();
     return false;
   }
 
-  bmpFile.seek(10);
-  uint32_t dataOffset = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
-
-  bmpFile.seek(18);
-  int32_t width = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
-  int32_t height = bmpFile.read() | (bmpFile.read() << 8) | (bmpFile.read() << 16) | (bmpFile.read() << 24);
+  // Palettized files stay indexed when asked for; 24-bit ones cannot
+  bool indexed = framebufferIsIndexed(format) && reader.info.paletteSize > 0;
+  if (indexed)
+    format = framebufferIndexedFormat(reader.info.bitsPerPixel);
+  else if (framebufferIsIndexed(format))
+    format = FB_RGB888_PLANAR;
 
-  bmpFile.seek(28);
-  uint16_t bitsPerPixel = bmpFile.read() | (bmpFile.read() << 8);
-
-  if (bitsPerPixel != 24)
+  // One allocation for the whole image, with room for the file's own colours only
+  if (!allocateFramebuffer(fb, reader.info.width, reader.info.height, format, indexed ? reader.info.paletteSize : 0))
   {
-    Sprintln("Only 24-bit BMP supported");
+    Sprintln("Framebuffer allocation failed");
     bmpFile.close();
     return false;
   }
 
-  Sprint("Loading to framebuffer: ");
-  Sprint(width);
-  Sprint("x");
-  Sprint(height);
-  Sprintln("");
+  // Rows are written straight to their final position as they stream in
+  BmpStatus status;
+  if (indexed)
+  {
+    framebufferSetPaletteBGR(fb, reader.palette[0], reader.info.paletteSize);
+    status = bmpReadIndexRows(&reader, storeIndexRow, fb);
+  }
+  else
+  {
+    status = bmpReadRows(&reader, storeBMPRow, fb);
+  }
+  bmpFile.close();
+  if (status != BMP_OK)
+  {
+    Sprintln(bmpStatusString(status));
+    freeFramebuffer(fb);
+    return false;
+  }
 
-  // Allocate framebuffer memory
-  fb->width = width;
-  fb->height = height;
-  fb->rData = new uint8_t *[height];
-  fb->gData = new uint8_t *[height];
-  fb->bData = new uint8_t *[height];
+  Sprintln("Framebuffer loaded");
+  return true;
+}
 
-  for (int16_t i = 0; i < height; i++)
+// Load a QOI-compressed icon into a framebuffer
+bool loadQOIToFramebuffer(const char *filename, GlitchFramebuffer *fb, FramebufferFormat format)
+{
+  File qoiFile = LittleFS.open(filename, "r");
+  if (!qoiFile)
   {
-    fb->rData[i] = new uint8_t[width];
-    fb->gData[i] = new uint8_t[width];
-    fb->bData[i] = new uint8_t[width];
+    Sprintln("Failed to open QOI file");
+    return false;
   }
 
-  // Read BMP data into separate RGB channels
-  uint32_t rowSize = ((width * 3 + 3) / 4) * 4;
-  uint8_t row[rowSize];
+  // QOI is true colour: an indexed request falls back to planar RGB888
+  if (framebufferIsIndexed(format))
+    format = FB_RGB888_PLANAR;
 
-  for (int16_t row_idx = height - 1; row_idx >= 0; row_idx--)
+  QoiReader reader;
+  qoiReaderInit(&reader, fileRead, &qoiFile);
+  QoiStatus status = qoiReadHeader(&reader);
+  if (status == QOI_OK)
   {
-    bmpFile.seek(dataOffset + row_idx * rowSize);
-    bmpFile.read(row, rowSize);
-
-    for (int16_t col = 0; col < width; col++)
+    // One allocation; pixels are decoded straight into it as the file streams in
+    if (!allocateFramebuffer(fb, reader.info.width, reader.info.height, format))
     {
-      int16_t y_pos = height - 1 - row_idx;
-      fb->bData[y_pos][col] = row[col * 3];
-      fb->gData[y_pos][col] = row[col * 3 + 1];
-      fb->rData[y_pos][col] = row[col * 3 + 2];
+      Sprintln("Framebuffer allocation failed");
+      qoiFile.close();
+      return false;
     }
+    status = qoiDecodeToFramebuffer(&reader, fb);
   }
+  qoiFile.close();
 
-  bmpFile.close();
-  fb->allocated = true;
-  Sprintln("Framebuffer loaded");
+  if (status != QOI_OK)
+  {
+    Sprintln(qoiStatusString(status));
+    freeFramebuffer(fb);
+    return false;
+  }
   return true;
 }
 
-// Free framebuffer memory
-void freeFramebuffer(GlitchFramebuffer *fb)
+// Open an animation for streaming playback
+bool openAnimation(const char *filename, File *file, AnimPlayer *player)
 {
-  if (!fb->allocated)
-    return;
+  *file = LittleFS.open(filename, "r");
+  if (!*file)
+  {
+    Sprintln("Failed to open animation file");
+    return false;
+  }
 
-  for (int16_t i = 0; i < fb->height; i++)
+  animPlayerInit(player, fileRead, fileSeek, file);
+  AnimStatus status = animPlayerOpen(player);
+  if (status != ANIM_OK)
   {
-    delete[] fb->rData[i];
-    delete[] fb->gData[i];
-    delete[] fb->bData[i];
+    Sprintln(animStatusString(status));
+    file->close();
+    return false;
   }
-  delete[] fb->rData;
-  delete[] fb->gData;
-  delete[] fb->bData;
 
-  fb->allocated = false;
-  Sprintln("Framebuffer freed");
+  Sprint("Animation: ");
+  Sprint(player->header.width);
+  Sprint("x");
+  Sprint(player->header.height);
+  Sprint(", ");
+  Sprint(player->header.frameCount);
+  Sprint(" frames @ ");
+  Sprint(player->header.frameMs);
+  Sprintln("ms");
+  return true;
 }
 
 // Draw framebuffer with random glitch effect applied
-void drawFramebufferGlitched(MatrixPanel_I2S_DMA *display, GlitchFramebuffer *fb, int16_t x, int16_t y)
+uint32_t drawFramebufferGlitched(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, GlitchRenderer *renderer,
+                                 const GlitchFramebuffer *fb, int16_t x, int16_t y)
 {
-  if (!fb->allocated)
-    return;
-
-  int16_t width = fb->width;
-  int16_t height = fb->height;
-
-  // Create temporary working copies for this frame's glitch
-  uint8_t **rTemp = new uint8_t *[height];
-  uint8_t **gTemp = new uint8_t *[height];
-  uint8_t **bTemp = new uint8_t *[height];
-
-  for (int16_t i = 0; i < height; i++)
-  {
-    rTemp[i] = new uint8_t[width];
-    gTemp[i] = new uint8_t[width];
-    bTemp[i] = new uint8_t[width];
-
-    // Copy original data
-    memcpy(rTemp[i], fb->rData[i], width);
-    memcpy(gTemp[i], fb->gData[i], width);
-    memcpy(bTemp[i], fb->bData[i], width);
-  }
-
-  // Generate 3 random glitch boxes
-  for (int glitchBox = 0; glitchBox < 4; glitchBox++)
+  // Compose into the renderer's persistent back buffer (no per-frame allocation)
+  const GlitchFramebuffer *frame;
   {
-    // Random box dimensions and position (can go off edge)
-    int16_t boxX = random(-width / 2, width);
-    int16_t boxY = random(-height / 2, height);
-    int16_t boxW = random(width / 4, width);
-    int16_t boxH = random(height / 4, height);
-
-    // 50% chance to shift whole image chunk (all RGB), 50% chance to shift single channel
-    bool shiftAllChannels = random(0, 2) == 0;
-
-    // Random channel to offset (0=R, 1=G, 2=B) - only used if not shifting all
-    int channel = random(0, 3);
-
-    // Random offset amount (10-40 pixels)
-    int16_t offsetX = random(0, 4) * (random(0, 2) == 0 ? 1 : -1);
-    int16_t offsetY = random(0, 4) * (random(0, 2) == 0 ? 1 : -1);
-
-    // Apply offset to the selected channel(s) within the box
-    for (int16_t by = 0; by < boxH; by++)
-    {
-      for (int16_t bx = 0; bx < boxW; bx++)
-      {
-        int16_t srcX = boxX + bx;
-        int16_t srcY = boxY + by;
-        int16_t dstX = srcX + offsetX;
-        int16_t dstY = srcY + offsetY;
-
-        // Wrap coordinates around image boundaries (toroidal wrapping)
-        // Handle negative values properly with modulo
-        srcX = ((srcX % width) + width) % width;
-        srcY = ((srcY % height) + height) % height;
-        dstX = ((dstX % width) + width) % width;
-        dstY = ((dstY % height) + height) % height;
-
-        if (shiftAllChannels)
-        {
-          // Shift entire image chunk (all RGB channels together)
-          rTemp[srcY][srcX] = fb->rData[dstY][dstX];
-          gTemp[srcY][srcX] = fb->gData[dstY][dstX];
-          bTemp[srcY][srcX] = fb->bData[dstY][dstX];
-        }
-        else
-        {
-          // Shift only one color channel (chromatic aberration effect)
-          if (channel == 0) // Red channel
-          {
-            rTemp[srcY][srcX] = fb->rData[dstY][dstX];
-          }
-          else if (channel == 1) // Green channel
-          {
-            gTemp[srcY][srcX] = fb->gData[dstY][dstX];
-          }
-          else // Blue channel
-          {
-            bTemp[srcY][srcX] = fb->bData[dstY][dstX];
-          }
-        }
-      }
-    }
+    PROFILE_SCOPE(PROFILE_GLITCH);
+    frame = glitchRendererCompose(renderer, fb);
   }
+  if (!frame)
+    return 0;
 
-  // Draw the glitched frame to the display
-  for (int16_t py = 0; py < height; py++)
-  {
-    for (int16_t px = 0; px < width; px++)
-    {
-      uint16_t color565 = display->color565(rTemp[py][px], gTemp[py][px], bTemp[py][px]);
-      display->drawPixel(x + px, y + py, color565);
-    }
-  }
+  return presentFramebuffer(display, canvas, frame, x, y);
+}
 
-  // Clean up temporary buffers
-  for (int16_t i = 0; i < height; i++)
-  {
-    delete[] rTemp[i];
-    delete[] gTemp[i];
-    delete[] bTemp[i];
-  }
-  delete[] rTemp;
-  delete[] gTemp;
-  delete[] bTemp;
+// Compose a glitched frame without presenting it
+bool composeFramebufferGlitched(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *fb,
+                                const GlitchEffectChain *chain, uint32_t seed)
+{
+  PROFILE_SCOPE(PROFILE_GLITCH);
+  return glitchCompose(renderer, target, fb, chain, seed);
 }
@@ -4,30 +4,67 @@
 #include <Arduino.h>
 #include <LittleFS.h>
 #include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+#include "framebuffer.h"
+#include "glitch_renderer.h"
+#include "bitplane_encoder.h"
+#include "anim_player.h"
+#include <virtual_canvas.h>
 
-// Structure to hold framebuffer data for glitch effects
-struct GlitchFramebuffer {
-  uint8_t **rData;
-  uint8_t **gData;
-  uint8_t **bData;
-  int16_t width;
-  int16_t height;
-  bool allocated;
-};
+// Everything below draws at canvas coordinates (x, y): the canvas splits it over the
+// chained panels and applies each panel's rotation, so the display itself is not rotated.
 
-// Draw a 24-bit BMP file from LittleFS to the display
-bool drawBMP(MatrixPanel_I2S_DMA *display, const char *filename, int16_t x, int16_t y);
+// Draw a 24-bit or palettized (1/4/8-bit) BMP file from LittleFS to the display
+bool drawBMP(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const char *filename, int16_t x, int16_t y);
 
 // Draw a BMP from embedded PROGMEM array
-bool drawEmbeddedBMP(MatrixPanel_I2S_DMA *display, const unsigned char *bmp_data, int16_t x, int16_t y);
+bool drawEmbeddedBMP(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const unsigned char *bmp_data,
+                     int16_t x, int16_t y);
 
-// Load BMP into framebuffer for glitch effects
-bool loadBMPToFramebuffer(const char *filename, GlitchFramebuffer *fb);
+// Load BMP into framebuffer for glitch effects (one allocation, in the requested layout).
+// With any indexed format requested, a palettized BMP stays indexed at its own depth
+// (1/4/8 bits per pixel) with its palette; a 24-bit BMP falls back to planar RGB888.
+bool loadBMPToFramebuffer(const char *filename, GlitchFramebuffer *fb, FramebufferFormat format = FB_RGB888_PLANAR);
 
-// Free framebuffer memory
-void freeFramebuffer(GlitchFramebuffer *fb);
+// Load a QOI-compressed icon (scripts/pack_icons.py --qoi-dir) into a framebuffer,
+// decoding straight into it as the file streams in. QOI is true colour, so an indexed
+// format request falls back to planar RGB888.
+bool loadQOIToFramebuffer(const char *filename, GlitchFramebuffer *fb, FramebufferFormat format = FB_RGB888_PLANAR);
 
-// Draw framebuffer with random glitch effect applied
-void drawFramebufferGlitched(MatrixPanel_I2S_DMA *display, GlitchFramebuffer *fb, int16_t x, int16_t y);
+// Present a finished frame to the display in one pass, batching runs of identical
+// pixels in each row into single line fills. Only the parts on panels in `panels` (e.g.
+// the canvas's dirty mask) are converted and written. Returns the number of display calls made.
+uint32_t presentFramebuffer(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const GlitchFramebuffer *frame,
+                            int16_t x, int16_t y, uint32_t panels = CANVAS_ALL_PANELS);
+
+// Present only the spans of a frame listed in `changed` (all of it when changed->all),
+// e.g. what the last animation frame touched. The rest of the panel is left as it is.
+// Returns the number of display calls made.
+uint32_t presentFramebufferSpans(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas,
+                                 const GlitchFramebuffer *frame, const AnimSpanList *changed, int16_t x, int16_t y,
+                                 uint32_t panels = CANVAS_ALL_PANELS);
+
+// Encode the same parts of a frame into bit planes (`words`, bitplaneWordCount long) for
+// a chain laid out as `layout`, instead of drawing them: what presentFramebuffer would
+// leave in the display's DMA buffer. Returns pixels encoded.
+uint32_t encodeFramebuffer(const BitplaneLayout *layout, uint16_t *words, const VirtualCanvas *canvas,
+                           const GlitchFramebuffer *frame, int16_t x, int16_t y, uint32_t panels = CANVAS_ALL_PANELS);
+
+// Open an animation (scripts/pack_icons.py --anim) from LittleFS into `file`, which the
+// player streams from until the caller closes it. Allocates the player's framebuffer.
+bool openAnimation(const char *filename, File *file, AnimPlayer *player);
+
+// Present one RGB565 row the same way. Returns the number of display calls made.
+uint32_t presentRow565(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, const uint16_t *row, int16_t width,
+                       int16_t x, int16_t y, uint32_t panels = CANVAS_ALL_PANELS);
+
+// Draw framebuffer with the next frame of the renderer's glitch stream applied, composed in
+// its back buffer. Returns the number of display calls made.
+uint32_t drawFramebufferGlitched(MatrixPanel_I2S_DMA *display, const VirtualCanvas *canvas, GlitchRenderer *renderer,
+                                 const GlitchFramebuffer *fb, int16_t x, int16_t y);
+
+// Compose glitch frame `seed` of fb into target with the renderer's colour lookup, without
+// drawing it (for the render pipeline). Returns false if there is nothing to draw.
+bool composeFramebufferGlitched(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *fb,
+                                const GlitchEffectChain *chain, uint32_t seed);
 
 #endif
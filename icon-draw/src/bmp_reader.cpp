@@ -0,0 +1,213 @@
+#include "bmp_reader.h"
+
+#include <string.h>
+
+// Little-endian field readers
+static inline uint16_t readLE16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t readLE32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t bmpMemoryRead(void *ctx, uint8_t *dst, size_t len)
+{
+  BmpMemorySource *src = (BmpMemorySource *)ctx;
+  size_t available = src->size - src->position;
+  if (len > available)
+    len = available;
+  memcpy(dst, src->data + src->position, len);
+  src->position += len;
+  return len;
+}
+
+void bmpReaderInit(BmpReader *reader, BmpReadFn read, void *ctx)
+{
+  memset(reader, 0, sizeof(*reader));
+  reader->read = read;
+  reader->ctx = ctx;
+}
+
+// Read exactly `len` bytes (the source may return short reads)
+static bool readFully(BmpReader *reader, uint8_t *dst, size_t len)
+{
+  while (len > 0)
+  {
+    size_t got = reader->read(reader->ctx, dst, len);
+    if (got == 0)
+      return false;
+    reader->position += got;
+    dst += got;
+    len -= got;
+  }
+  return true;
+}
+
+BmpStatus bmpReadHeader(BmpReader *reader)
+{
+  uint8_t header[BMP_HEADER_SIZE];
+  if (!readFully(reader, header, sizeof(header)))
+    return BMP_READ_ERROR;
+
+  if (readLE16(header) != 0x4D42) // "BM" in little-endian
+    return BMP_BAD_SIGNATURE;
+
+  BmpInfo &info = reader->info;
+  info.dataOffset = readLE32(header + 10);
+  info.width = (int32_t)readLE32(header + 18);
+  int32_t height = (int32_t)readLE32(header + 22);
+  info.bitsPerPixel = readLE16(header + 28);
+  uint32_t compression = readLE32(header + 30);
+
+  // Negative height marks a top-down bitmap. The magnitude is taken unsigned, so
+  // INT32_MIN cannot overflow, and rows must fit the int16_t indices they are sent with.
+  info.topDown = height < 0;
+  uint32_t rows = height < 0 ? 0u - (uint32_t)height : (uint32_t)height;
+  if (rows == 0 || rows > INT16_MAX)
+    return BMP_BAD_HEIGHT;
+  info.height = (int32_t)rows;
+
+  uint16_t bits = info.bitsPerPixel;
+  if (bits != 1 && bits != 4 && bits != 8 && bits != 24)
+    return BMP_UNSUPPORTED_DEPTH;
+  if (compression != 0)
+    return BMP_UNSUPPORTED_COMPRESSION;
+
+  // Calculate row size (must be multiple of 4 bytes). Palettized rows are expanded to
+  // BGR888 alongside the raw rows in the same chunk, so both must fit.
+  info.rowSize = ((info.width * bits + 31) / 32) * 4;
+  uint32_t expandedSize = bits == 24 ? 0 : info.width * 3;
+  if (info.width <= 0 || info.rowSize + expandedSize > BMP_CHUNK_SIZE)
+    return BMP_TOO_WIDE;
+
+  // The palette follows the info header: clrUsed BGRX entries, or 2^bits when that is 0
+  info.paletteSize = 0;
+  if (bits != 24)
+  {
+    uint32_t headerSize = readLE32(header + 14);
+    uint32_t colorsUsed = readLE32(header + 46);
+    if (colorsUsed == 0)
+      colorsUsed = 1u << bits;
+
+    uint32_t paletteStart = 14 + headerSize;
+    if (headerSize < 40 || colorsUsed > (1u << bits) || paletteStart + colorsUsed * 4 > info.dataOffset)
+      return BMP_BAD_PALETTE;
+    info.paletteSize = colorsUsed;
+
+    uint8_t skip[32];
+    while (reader->position < paletteStart)
+    {
+      size_t len = paletteStart - reader->position;
+      if (!readFully(reader, skip, len < sizeof(skip) ? len : sizeof(skip)))
+        return BMP_READ_ERROR;
+    }
+
+    uint8_t entry[4];
+    for (uint16_t i = 0; i < info.paletteSize; i++)
+    {
+      if (!readFully(reader, entry, sizeof(entry)))
+        return BMP_READ_ERROR;
+      memcpy(reader->palette[i], entry, 3);
+    }
+  }
+
+  // Skip any extra header bytes by reading forward, never seeking
+  uint8_t skip[32];
+  while (reader->position < info.dataOffset)
+  {
+    size_t len = info.dataOffset - reader->position;
+    if (!readFully(reader, skip, len < sizeof(skip) ? len : sizeof(skip)))
+      return BMP_READ_ERROR;
+  }
+
+  return BMP_OK;
+}
+
+// Expand one row of packed indices to BGR888 through the palette
+static void expandRow(const BmpReader *reader, const uint8_t *indices, uint8_t *bgr)
+{
+  uint16_t bits = reader->info.bitsPerPixel;
+  uint8_t mask = (1 << bits) - 1;
+  for (int32_t x = 0; x < reader->info.width; x++, bgr += 3)
+  {
+    uint8_t index = bits == 8 ? indices[x] : (indices[x * bits >> 3] >> (8 - bits - (x * bits & 7))) & mask;
+    memcpy(bgr, reader->palette[index], 3);
+  }
+}
+
+// Stream rows front to back, optionally expanding palettized rows to BGR888
+static BmpStatus readRows(BmpReader *reader, BmpRowFn onRow, void *ctx, bool expand)
+{
+  const BmpInfo &info = reader->info;
+  alignas(4) uint8_t chunk[BMP_CHUNK_SIZE]; // Rows start word-aligned for the conversion kernels
+
+  // An expanded row goes at the front of the chunk, raw rows after it
+  uint32_t expandedSize = expand ? info.width * 3 : 0;
+  uint8_t *raw = chunk + expandedSize;
+  uint32_t rowsPerChunk = (BMP_CHUNK_SIZE - expandedSize) / info.rowSize;
+
+  // Rows arrive in file order; each goes straight to its final row index
+  int32_t stored = 0;
+  while (stored < info.height)
+  {
+    uint32_t rows = info.height - stored;
+    if (rows > rowsPerChunk)
+      rows = rowsPerChunk;
+
+    if (!readFully(reader, raw, rows * info.rowSize))
+      return BMP_READ_ERROR;
+
+    for (uint32_t i = 0; i < rows; i++, stored++)
+    {
+      int16_t y = info.topDown ? stored : info.height - 1 - stored;
+      const uint8_t *row = raw + i * info.rowSize;
+      if (expand)
+      {
+        expandRow(reader, row, chunk);
+        row = chunk;
+      }
+      onRow(ctx, y, row);
+    }
+  }
+
+  return BMP_OK;
+}
+
+BmpStatus bmpReadRows(BmpReader *reader, BmpRowFn onRow, void *ctx)
+{
+  return readRows(reader, onRow, ctx, reader->info.bitsPerPixel != 24);
+}
+
+BmpStatus bmpReadIndexRows(BmpReader *reader, BmpRowFn onRow, void *ctx)
+{
+  if (reader->info.bitsPerPixel == 24)
+    return BMP_UNSUPPORTED_DEPTH;
+  return readRows(reader, onRow, ctx, false);
+}
+
+const char *bmpStatusString(BmpStatus status)
+{
+  switch (status)
+  {
+  case BMP_OK:
+    return "OK";
+  case BMP_READ_ERROR:
+    return "BMP file truncated";
+  case BMP_BAD_SIGNATURE:
+    return "Not a valid BMP file";
+  case BMP_UNSUPPORTED_DEPTH:
+    return "Only 1/4/8/24-bit BMP supported";
+  case BMP_UNSUPPORTED_COMPRESSION:
+    return "Compressed BMP not supported";
+  case BMP_TOO_WIDE:
+    return "BMP too wide";
+  case BMP_BAD_PALETTE:
+    return "BMP palette invalid";
+  case BMP_BAD_HEIGHT:
+    return "BMP height out of range";
+  }
+  return "Unknown BMP error";
+}
@@ -0,0 +1,85 @@
+#ifndef BMP_READER_H
+#define BMP_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Bytes read from the source per call while streaming pixel data (several rows at a time)
+#define BMP_CHUNK_SIZE 2048
+
+// Size of the BITMAPFILEHEADER + BITMAPINFOHEADER read in one go
+#define BMP_HEADER_SIZE 54
+
+// Most palette entries a BMP can have (8 bits per pixel)
+#define BMP_MAX_PALETTE 256
+
+// Sequential byte source: fill up to `len` bytes, return how many were read (0 at end)
+typedef size_t (*BmpReadFn)(void *ctx, uint8_t *dst, size_t len);
+
+// Receives each pixel row in file order, with its final top-down row index. Rows are
+// BGR888 from bmpReadRows, packed palette indices from bmpReadIndexRows.
+typedef void (*BmpRowFn)(void *ctx, int16_t y, const uint8_t *bgr);
+
+enum BmpStatus : uint8_t
+{
+  BMP_OK,
+  BMP_READ_ERROR,        // Source ended early
+  BMP_BAD_SIGNATURE,     // Not "BM"
+  BMP_UNSUPPORTED_DEPTH, // Only 1, 4, 8 and 24-bit are supported
+  BMP_UNSUPPORTED_COMPRESSION,
+  BMP_TOO_WIDE,          // A row (expanded to BGR888) does not fit in BMP_CHUNK_SIZE
+  BMP_BAD_PALETTE,       // Palette missing, too large, or overlapping the pixel data
+  BMP_BAD_HEIGHT         // No rows, or more than an int16_t row index can address
+};
+
+// Parsed header
+struct BmpInfo
+{
+  int32_t width;
+  int32_t height;        // 1..INT16_MAX rows; see topDown
+  bool topDown;          // Negative height in the file: first stored row is the top one
+  uint16_t bitsPerPixel;
+  uint32_t dataOffset;   // File offset of the first pixel row
+  uint32_t rowSize;      // Bytes per stored row including padding to 4 bytes
+  uint16_t paletteSize;  // Palette entries (0 for 24-bit)
+};
+
+// Streaming reader: the header is read with one call, pixel rows are read front to back
+// in BMP_CHUNK_SIZE blocks, so the source never has to seek.
+struct BmpReader
+{
+  BmpReadFn read;
+  void *ctx;
+  uint32_t position; // Bytes consumed from the source so far
+  BmpInfo info;
+  uint8_t palette[BMP_MAX_PALETTE][3]; // BGR888 entries; unused entries are black
+};
+
+// In-memory source for BMPs embedded in flash or loaded into RAM
+struct BmpMemorySource
+{
+  const uint8_t *data;
+  size_t size;
+  size_t position;
+};
+
+size_t bmpMemoryRead(void *ctx, uint8_t *dst, size_t len);
+
+// Set up a reader over a source
+void bmpReaderInit(BmpReader *reader, BmpReadFn read, void *ctx);
+
+// Read and validate the header and palette, then skip forward to the pixel data
+BmpStatus bmpReadHeader(BmpReader *reader);
+
+// Stream every pixel row to `onRow` as BGR888 (call after bmpReadHeader). Palettized
+// rows are expanded through the palette.
+BmpStatus bmpReadRows(BmpReader *reader, BmpRowFn onRow, void *ctx);
+
+// Stream every pixel row of a palettized BMP to `onRow` as stored: packed indices,
+// leftmost pixel in the most significant bits
+BmpStatus bmpReadIndexRows(BmpReader *reader, BmpRowFn onRow, void *ctx);
+
+// Human readable status for logging
+const char *bmpStatusString(BmpStatus status);
+
+#endif
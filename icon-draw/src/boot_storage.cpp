@@ -0,0 +1,64 @@
+#include "boot_storage.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+/*--------------------- DEBUG -------------------------*/
+#define Sprintln(a) (Serial.println(a))
+#define Sprint(a) (Serial.print(a))
+
+void bootStorageMapArchive(BootStorage *storage)
+{
+  uint8_t phase = bootPhaseBegin(storage->trace, "archive");
+  if (assetArchiveMap(storage->archive, ASSET_PARTITION_LABEL))
+  {
+    Sprint("Icon archive mapped: ");
+    Sprint(assetArchiveCount(storage->archive));
+    Sprintln(" images");
+  }
+  else
+  {
+    Sprintln("No icon archive, loading BMPs from LittleFS");
+  }
+  bootPhaseEnd(storage->trace, phase);
+}
+
+bool bootStorageMount(BootStorage *storage)
+{
+  uint8_t phase = bootPhaseBegin(storage->trace, "littlefs");
+  Sprintln("...Mounting LittleFS");
+  // Formatting is slow, but only ever happens on a corrupt or blank filesystem
+  bool mounted = LittleFS.begin(true);
+  if (mounted)
+  {
+    Sprintln("LittleFS Mounted Successfully");
+    for (int i = 0; i < storage->animationFileCount && storage->animationCount < BOOT_STORAGE_MAX_ANIMATIONS; i++)
+    {
+      if (LittleFS.exists(storage->animationFiles[i]))
+        storage->animations[storage->animationCount++] = storage->animationFiles[i];
+    }
+    Sprint("Animations found: ");
+    Sprintln(storage->animationCount);
+  }
+  else
+  {
+    Sprintln("LittleFS Mount Failed");
+  }
+  bootPhaseEnd(storage->trace, phase);
+  return mounted;
+}
+
+void bootStorageTask(void *ctx)
+{
+  BootStorage *storage = (BootStorage *)ctx;
+  storage->mounted = bootStorageMount(storage);
+  if (storage->mounted)
+  {
+    uint8_t phase = bootPhaseBegin(storage->trace, "first image");
+    if (storage->imageCount(storage->ctx) > 0)
+      imageCachePrefetch(storage->cache, 0);
+    bootPhaseEnd(storage->trace, phase);
+  }
+  storage->ready.store(true, std::memory_order_release);
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,46 @@
+#ifndef BOOT_STORAGE_H
+#define BOOT_STORAGE_H
+
+#include <atomic>
+#include <boot_trace.h>
+#include "asset_archive.h"
+#include "image_cache.h"
+
+#define BOOT_STORAGE_MAX_ANIMATIONS 8
+
+// What setup() needs from flash: the icon archive, which sits in its own partition and
+// maps without a filesystem (quick enough to do before the display starts), and LittleFS
+// with the animations on it. Mounting can take a format, so with a fast boot it runs on
+// a task of its own together with decoding the first image. Every step is a boot phase.
+struct BootStorage
+{
+  BootTrace *trace;
+  AssetArchive *archive;
+  const char *const *animationFiles; // Candidates in rotation order (at most BOOT_STORAGE_MAX_ANIMATIONS)
+  int animationFileCount;
+  ImageCache *cache;            // bootStorageTask() decodes the first image into it
+  int (*imageCount)(void *ctx); // Images the cache can decode
+  void *ctx;
+
+  // Animation files that exist on LittleFS
+  const char *animations[BOOT_STORAGE_MAX_ANIMATIONS];
+  int animationCount;
+
+  // Set by bootStorageTask()
+  std::atomic<bool> ready; // Storage and the first image are ready
+  bool mounted;            // LittleFS mounted (read once ready is set)
+};
+
+// Map the icon archive (phase "archive"). Leaves it closed when there is none.
+void bootStorageMapArchive(BootStorage *storage);
+
+// Mount LittleFS and find the animations on it (phase "littlefs"). A partition that will
+// not mount is formatted, so the next boot finds a working one. Returns false if LittleFS
+// still did not mount.
+bool bootStorageMount(BootStorage *storage);
+
+// Task body (pass the BootStorage): mount, then decode the image the rotation opens with
+// (phase "first image", so the first fade-in is a cache hit), then set `ready`
+void bootStorageTask(void *storage);
+
+#endif
@@ -0,0 +1,168 @@
+#include "crossfade.h"
+
+#include <math.h>
+
+// Eased progress and its gamma-corrected form, per curve, as 8.8 weights
+static uint16_t easeTable[FADE_CURVE_COUNT][FADE_STEPS];
+static uint16_t gammaTable[FADE_CURVE_COUNT][FADE_STEPS];
+static bool tablesBuilt = false;
+
+static float ease(FadeCurve curve, float t)
+{
+  switch (curve)
+  {
+  case FADE_EASE_IN:
+    return t * t;
+  case FADE_EASE_OUT:
+    return 1.0f - (1.0f - t) * (1.0f - t);
+  case FADE_SMOOTH:
+    return t * t * (3.0f - 2.0f * t);
+  default:
+    return t;
+  }
+}
+
+// The only floating point: once, on first use
+static void buildTables()
+{
+  for (int c = 0; c < FADE_CURVE_COUNT; c++)
+  {
+    for (int i = 0; i < FADE_STEPS; i++)
+    {
+      float level = ease((FadeCurve)c, (float)i / (FADE_STEPS - 1));
+      easeTable[c][i] = (uint16_t)lroundf(level * FADE_ONE);
+      gammaTable[c][i] = (uint16_t)lroundf(powf(level, 1.0f / FADE_GAMMA) * FADE_ONE);
+    }
+  }
+  tablesBuilt = true;
+}
+
+uint8_t fadeProgress(uint32_t elapsed, uint32_t duration)
+{
+  if (duration == 0 || elapsed >= duration)
+    return FADE_STEPS - 1;
+  return (uint8_t)((uint64_t)elapsed * (FADE_STEPS - 1) / duration);
+}
+
+uint16_t fadeWeight(FadeCurve curve, uint8_t progress)
+{
+  if (!tablesBuilt)
+    buildTables();
+  return gammaTable[curve][progress];
+}
+
+uint16_t crossfadeWeight(FadeCurve curve, uint8_t progress)
+{
+  if (!tablesBuilt)
+    buildTables();
+  return easeTable[curve][progress];
+}
+
+// Four 8-bit channels per word, two at a time in 16-bit lanes with room for the
+// product: (a * wa + b * wb + 0.5) / 256 per byte, where wa + wb = FADE_ONE
+static inline uint32_t blend888(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb)
+{
+  uint32_t lo = (((a & 0x00FF00FF) * wa + (b & 0x00FF00FF) * wb + 0x00800080) >> 8) & 0x00FF00FF;
+  uint32_t hi = (((a >> 8) & 0x00FF00FF) * wa + ((b >> 8) & 0x00FF00FF) * wb + 0x00800080) & 0xFF00FF00;
+  return lo | hi;
+}
+
+static inline uint32_t scale888(uint32_t a, uint32_t w)
+{
+  uint32_t lo = (((a & 0x00FF00FF) * w + 0x00800080) >> 8) & 0x00FF00FF;
+  uint32_t hi = (((a >> 8) & 0x00FF00FF) * w + 0x00800080) & 0xFF00FF00;
+  return lo | hi;
+}
+
+// RGB565: red moves up to bits 16-20 so red and blue share one multiply; green is
+// blended in place (its low bits are the rounding fraction and are masked off)
+static inline uint32_t spread565(uint16_t p)
+{
+  return ((uint32_t)(p & 0xF800) << 5) | (p & 0x001F);
+}
+
+static inline uint16_t blend565(uint16_t a, uint16_t b, uint32_t wa, uint32_t wb)
+{
+  uint32_t rb = ((spread565(a) * wa + spread565(b) * wb + 0x00800080) >> 8) & 0x001F001F;
+  uint32_t g = (((uint32_t)(a & 0x07E0) * wa + (uint32_t)(b & 0x07E0) * wb + 0x1000) >> 8) & 0x07E0;
+  return ((rb >> 5) & 0xF800) | (rb & 0x001F) | g;
+}
+
+static inline uint16_t scale565(uint16_t a, uint32_t w)
+{
+  uint32_t rb = ((spread565(a) * w + 0x00800080) >> 8) & 0x001F001F;
+  uint32_t g = (((uint32_t)(a & 0x07E0) * w + 0x1000) >> 8) & 0x07E0;
+  return ((rb >> 5) & 0xF800) | (rb & 0x001F) | g;
+}
+
+void fadeFramebuffer(GlitchFramebuffer *fb, uint16_t weight)
+{
+  if (!fb->allocated || weight >= FADE_ONE)
+    return;
+
+  switch (fb->format)
+  {
+  case FB_RGB888_PLANAR:
+  case FB_RGB888_INTERLEAVED:
+  {
+    // Channels are independent, so the layout does not matter: every plane is a whole
+    // number of words (rows are 4-byte aligned)
+    uint32_t *words = (uint32_t *)fb->data;
+    size_t count = framebufferSize(fb) / 4;
+    for (size_t i = 0; i < count; i++)
+      words[i] = scale888(words[i], weight);
+    break;
+  }
+  case FB_RGB565:
+  {
+    uint16_t *pixels = (uint16_t *)fb->data;
+    size_t count = fb->planeSize / 2;
+    for (size_t i = 0; i < count; i++)
+      pixels[i] = scale565(pixels[i], weight);
+    break;
+  }
+  default:
+  {
+    // Indexed: every pixel goes through the palette, so only the palette needs scaling
+    uint16_t *palette = framebufferPalette(fb);
+    uint16_t entries = framebufferPaletteEntries(fb);
+    for (uint16_t i = 0; i < entries; i++)
+      palette[i] = scale565(palette[i], weight);
+    break;
+  }
+  }
+}
+
+bool crossfadeCompatible(const GlitchFramebuffer *a, const GlitchFramebuffer *b)
+{
+  return a->allocated && b->allocated && a->width == b->width && a->height == b->height &&
+         a->format == b->format && !framebufferIsIndexed(a->format);
+}
+
+bool crossfadeFramebuffer(GlitchFramebuffer *fb, const GlitchFramebuffer *other, uint16_t weight)
+{
+  if (!crossfadeCompatible(fb, other))
+    return false;
+  if (weight == 0)
+    return true;
+
+  uint32_t wb = weight > FADE_ONE ? FADE_ONE : weight;
+  uint32_t wa = FADE_ONE - wb;
+  if (fb->format == FB_RGB565)
+  {
+    uint16_t *pixels = (uint16_t *)fb->data;
+    const uint16_t *others = (const uint16_t *)other->data;
+    size_t count = fb->planeSize / 2;
+    for (size_t i = 0; i < count; i++)
+      pixels[i] = blend565(pixels[i], others[i], wa, wb);
+  }
+  else
+  {
+    uint32_t *words = (uint32_t *)fb->data;
+    const uint32_t *others = (const uint32_t *)other->data;
+    size_t count = framebufferSize(fb) / 4;
+    for (size_t i = 0; i < count; i++)
+      words[i] = blend888(words[i], others[i], wa, wb);
+  }
+  return true;
+}
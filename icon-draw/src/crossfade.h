@@ -0,0 +1,49 @@
+#ifndef CROSSFADE_H
+#define CROSSFADE_H
+
+#include <stdint.h>
+#include "framebuffer.h"
+
+// Fixed-point fades and crossfades between framebuffers. Weights are 8.8 fixed point
+// (FADE_ONE = 1.0) and come from 256-entry easing/gamma tables built once, so the
+// per-pixel path is integer multiply-adds only: RGB888 pixels are blended four
+// channels per 32-bit word, RGB565 pixels with red and blue in one word.
+//
+// Panel values are gamma encoded, so scaling them by k dims the light by k^FADE_GAMMA.
+// fadeWeight() undoes that (weight = k^(1/FADE_GAMMA)), making fades to and from black
+// follow the easing curve in linear light. Crossfades mix the encoded values directly.
+
+#define FADE_ONE 256     // Weight of 1.0
+#define FADE_STEPS 256   // Progress values (0 = start, FADE_STEPS - 1 = end)
+#define FADE_GAMMA 2.2f  // Panel response the fade weights correct for
+
+enum FadeCurve : uint8_t
+{
+  FADE_LINEAR,
+  FADE_EASE_IN,  // Slow start (quadratic)
+  FADE_EASE_OUT, // Slow end (quadratic)
+  FADE_SMOOTH,   // Slow start and end (smoothstep)
+  FADE_CURVE_COUNT
+};
+
+// Progress through a transition as 0..FADE_STEPS - 1 (clamped at the end)
+uint8_t fadeProgress(uint32_t elapsed, uint32_t duration);
+
+// Weight that shows an image at eased linear-light level `progress` (for fadeFramebuffer)
+uint16_t fadeWeight(FadeCurve curve, uint8_t progress);
+
+// Weight of the second image at `progress` (for crossfadeFramebuffer)
+uint16_t crossfadeWeight(FadeCurve curve, uint8_t progress);
+
+// Scale every pixel towards black in place: weight FADE_ONE leaves the frame as it is,
+// 0 makes it black. Indexed frames scale their palette instead of their pixels.
+void fadeFramebuffer(GlitchFramebuffer *fb, uint16_t weight);
+
+// Whether two frames can be crossfaded (same size and RGB format)
+bool crossfadeCompatible(const GlitchFramebuffer *a, const GlitchFramebuffer *b);
+
+// Blend `other` into `fb` in place: fb = fb * (FADE_ONE - weight) + other * weight.
+// Returns false, leaving fb untouched, when the frames are not crossfadeCompatible().
+bool crossfadeFramebuffer(GlitchFramebuffer *fb, const GlitchFramebuffer *other, uint16_t weight);
+
+#endif
@@ -0,0 +1,103 @@
+#include "frame_pipeline.h"
+
+static_assert((FRAME_QUEUE_CAPACITY & (FRAME_QUEUE_CAPACITY - 1)) == 0, "Queue capacity must be a power of two");
+static_assert(FRAME_QUEUE_CAPACITY >= FRAME_PIPELINE_DEPTH, "Queue must hold every frame");
+
+void frameQueueInit(FrameQueue *queue)
+{
+  queue->head.store(0, std::memory_order_relaxed);
+  queue->tail.store(0, std::memory_order_relaxed);
+}
+
+bool frameQueuePush(FrameQueue *queue, uint8_t item)
+{
+  uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+  if (tail - queue->head.load(std::memory_order_acquire) >= FRAME_QUEUE_CAPACITY)
+    return false;
+
+  queue->items[tail & (FRAME_QUEUE_CAPACITY - 1)] = item;
+  // Publish the item before the new tail becomes visible to the other side
+  queue->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool frameQueuePop(FrameQueue *queue, uint8_t *item)
+{
+  uint32_t head = queue->head.load(std::memory_order_relaxed);
+  if (head == queue->tail.load(std::memory_order_acquire))
+    return false;
+
+  *item = queue->items[head & (FRAME_QUEUE_CAPACITY - 1)];
+  // The slot may be reused by the pusher once the new head is visible
+  queue->head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t frameQueueSize(const FrameQueue *queue)
+{
+  return queue->tail.load(std::memory_order_acquire) - queue->head.load(std::memory_order_acquire);
+}
+
+void framePipelineInit(FramePipeline *pipeline)
+{
+  frameQueueInit(&pipeline->freeFrames);
+  frameQueueInit(&pipeline->readyFrames);
+  for (uint8_t i = 0; i < FRAME_PIPELINE_DEPTH; i++)
+  {
+    PipelineFrame &frame = pipeline->frames[i];
+    frame.fb = GLITCH_FRAMEBUFFER_INIT;
+    frame.sequence = 0;
+    frame.blank = false;
+    frame.composed = false;
+    frame.imageDone = false;
+    frameQueuePush(&pipeline->freeFrames, i);
+  }
+
+  pipeline->nextSequence = 0;
+  pipeline->produced.store(0, std::memory_order_relaxed);
+  pipeline->presented.store(0, std::memory_order_relaxed);
+  pipeline->producerStalls.store(0, std::memory_order_relaxed);
+  pipeline->consumerStarved.store(0, std::memory_order_relaxed);
+}
+
+void freeFramePipeline(FramePipeline *pipeline)
+{
+  for (int i = 0; i < FRAME_PIPELINE_DEPTH; i++)
+    freeFramebuffer(&pipeline->frames[i].fb);
+}
+
+PipelineFrame *framePipelineAcquire(FramePipeline *pipeline)
+{
+  uint8_t index;
+  if (!frameQueuePop(&pipeline->freeFrames, &index))
+  {
+    pipeline->producerStalls.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  return &pipeline->frames[index];
+}
+
+void framePipelineSubmit(FramePipeline *pipeline, PipelineFrame *frame)
+{
+  frame->sequence = pipeline->nextSequence++;
+  // Cannot fail: there are never more frames than queue positions
+  frameQueuePush(&pipeline->readyFrames, (uint8_t)(frame - pipeline->frames));
+  pipeline->produced.fetch_add(1, std::memory_order_relaxed);
+}
+
+PipelineFrame *framePipelineTake(FramePipeline *pipeline)
+{
+  uint8_t index;
+  if (!frameQueuePop(&pipeline->readyFrames, &index))
+  {
+    pipeline->consumerStarved.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  return &pipeline->frames[index];
+}
+
+void framePipelineRelease(FramePipeline *pipeline, PipelineFrame *frame)
+{
+  frameQueuePush(&pipeline->freeFrames, (uint8_t)(frame - pipeline->frames));
+  pipeline->presented.fetch_add(1, std::memory_order_relaxed);
+}
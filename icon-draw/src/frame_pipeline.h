@@ -0,0 +1,78 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "framebuffer.h"
+#include "anim_player.h"
+#include "image_cache.h"
+
+#define FRAME_PIPELINE_DEPTH 3 // Frames in flight between producer and consumer
+#define FRAME_QUEUE_CAPACITY 4 // Power of two, at least FRAME_PIPELINE_DEPTH
+
+// Single-producer/single-consumer ring of frame slot indices. Lock-free: each side
+// only writes its own counter, and the release/acquire pair on it publishes the item.
+struct FrameQueue
+{
+  std::atomic<uint32_t> head; // Next item to pop (written by the consumer of this queue)
+  std::atomic<uint32_t> tail; // Next free position (written by the producer of this queue)
+  uint8_t items[FRAME_QUEUE_CAPACITY];
+};
+
+// One frame in flight. Owned by exactly one side at a time, so it is never written
+// while it is being presented.
+struct PipelineFrame
+{
+  GlitchFramebuffer fb; // Composed pixels; (re)allocated by the producer only on a size change
+  uint32_t sequence;    // Production order, starting at 0
+  bool blank;           // Clear the screen instead of presenting fb
+  bool composed;        // fb holds a valid frame
+  bool imageDone;       // Last frame of an image: report its frame stats
+  ImageCacheStats cacheStats; // With imageDone: the producer's cache telemetry at that point
+  bool partial;         // Only `changed` differs from the frame before (animations)
+  AnimSpanList changed;
+};
+
+// Frame handoff between a producer (decode + compose) and a consumer (present),
+// usually on different cores. Empty frames go producer-ward on `freeFrames`, finished
+// ones consumer-ward on `readyFrames`. Neither side ever blocks inside the pipeline;
+// waiting when there is nothing to do is left to the caller.
+struct FramePipeline
+{
+  PipelineFrame frames[FRAME_PIPELINE_DEPTH];
+  FrameQueue freeFrames;
+  FrameQueue readyFrames;
+  uint32_t nextSequence; // Producer side
+
+  // Back-pressure counters. Each is written by one side only.
+  std::atomic<uint32_t> produced;
+  std::atomic<uint32_t> presented;
+  std::atomic<uint32_t> producerStalls; // Acquire found no free frame (consumer is behind)
+  std::atomic<uint32_t> consumerStarved; // Take found no ready frame (producer is behind)
+};
+
+// Queue primitives (each end used from one thread only)
+void frameQueueInit(FrameQueue *queue);
+bool frameQueuePush(FrameQueue *queue, uint8_t item);
+bool frameQueuePop(FrameQueue *queue, uint8_t *item);
+uint32_t frameQueueSize(const FrameQueue *queue);
+
+// Set up with every frame free. Call before either side starts.
+void framePipelineInit(FramePipeline *pipeline);
+
+// Release every frame's pixels. Call only once both sides have stopped.
+void freeFramePipeline(FramePipeline *pipeline);
+
+// Producer: take a free frame to compose into, or nullptr when all are in flight
+PipelineFrame *framePipelineAcquire(FramePipeline *pipeline);
+
+// Producer: hand a finished frame to the consumer
+void framePipelineSubmit(FramePipeline *pipeline, PipelineFrame *frame);
+
+// Consumer: oldest finished frame, or nullptr when none is ready
+PipelineFrame *framePipelineTake(FramePipeline *pipeline);
+
+// Consumer: give a presented frame back to the producer
+void framePipelineRelease(FramePipeline *pipeline, PipelineFrame *frame);
+
+#endif
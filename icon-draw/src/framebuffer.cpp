@@ -0,0 +1,140 @@
+#include "framebuffer.h"
+#include "pixel_convert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t allocationCount = 0;
+static uint32_t freeCount = 0;
+
+// Allocate a framebuffer with a single allocation
+bool allocateFramebuffer(GlitchFramebuffer *fb, int16_t width, int16_t height, FramebufferFormat format,
+                         uint16_t paletteEntries)
+{
+  uint16_t capacity = framebufferPaletteCapacity(format);
+  if (paletteEntries == 0 || paletteEntries > capacity)
+    paletteEntries = capacity;
+
+  // Same shape as before: keep the block, so reloading an image costs no heap traffic
+  if (fb->allocated && fb->width == width && fb->height == height && fb->format == format &&
+      framebufferPaletteEntries(fb) == paletteEntries)
+  {
+    if (framebufferIsIndexed(format))
+    {
+      memset(framebufferPalette(fb), 0, paletteEntries * sizeof(uint16_t));
+      *framebufferPaletteUsed(fb) = 0;
+    }
+    return true;
+  }
+  freeFramebuffer(fb);
+
+  if (width <= 0 || height <= 0)
+    return false;
+
+  // Keep every row 4-byte aligned so rows can be copied in whole words
+  uint16_t stride = (((width * framebufferBitsPerPixel(format) + 7) / 8 + 3) / 4) * 4;
+  uint32_t planeSize = (uint32_t)stride * height;
+
+  size_t size = (size_t)planeSize * framebufferPlaneCount(format) + framebufferPaletteBytes(format, paletteEntries);
+  const FramebufferAllocator *allocator = fb->allocator;
+  fb->data = (uint8_t *)(allocator ? allocator->alloc(allocator->ctx, size) : malloc(size));
+  if (!fb->data)
+    return false;
+  allocationCount++;
+
+  fb->width = width;
+  fb->height = height;
+  fb->stride = stride;
+  fb->planeSize = planeSize;
+  fb->format = format;
+  fb->allocated = true;
+
+  // An indexed image starts with an empty, all-black palette
+  if (framebufferIsIndexed(format))
+  {
+    memset(fb->data + planeSize, 0, framebufferPaletteBytes(format, paletteEntries));
+    ((uint16_t *)(fb->data + planeSize))[1] = paletteEntries;
+  }
+  return true;
+}
+
+// Free framebuffer memory
+void freeFramebuffer(GlitchFramebuffer *fb)
+{
+  if (!fb->allocated)
+    return;
+
+  const FramebufferAllocator *allocator = fb->allocator;
+  if (allocator)
+    allocator->free(allocator->ctx, fb->data);
+  else
+    free(fb->data);
+  freeCount++;
+  fb->data = nullptr;
+  fb->allocated = false;
+}
+
+uint32_t framebufferAllocationCount()
+{
+  return allocationCount;
+}
+
+uint32_t framebufferFreeCount()
+{
+  return freeCount;
+}
+
+// Store a row of BMP-ordered BGR888 pixels into row `y`
+void framebufferWriteRowBGR(GlitchFramebuffer *fb, int16_t y, const uint8_t *bgr)
+{
+  int16_t width = fb->width;
+  uint8_t *row = framebufferRow(fb, y);
+
+  switch (fb->format)
+  {
+  case FB_RGB888_PLANAR:
+    splitBGR888(row, row + fb->planeSize, row + 2 * fb->planeSize, bgr, width);
+    break;
+  case FB_RGB888_INTERLEAVED:
+    swapBGR888(row, bgr, width);
+    break;
+  case FB_RGB565:
+    convertBGR888To565((uint16_t *)row, bgr, width);
+    break;
+  default:
+    break;
+  }
+}
+
+// Store a row of packed palette indices into row `y`
+void framebufferWriteRowIndices(GlitchFramebuffer *fb, int16_t y, const uint8_t *indices)
+{
+  // Same packing as the source, so the row is one copy
+  uint8_t *row = framebufferRow(fb, y);
+  uint8_t bits = framebufferBitsPerPixel(fb->format);
+  memcpy(row, indices, (fb->width * bits + 7) / 8);
+
+  // A palette smaller than the index range: clamp stray indices (bad files) into it
+  uint16_t entries = framebufferPaletteEntries(fb);
+  if (entries >= framebufferPaletteCapacity(fb->format))
+    return;
+  for (int16_t x = 0; x < fb->width; x++)
+  {
+    if (framebufferGetIndex(row, x, bits) >= entries)
+      framebufferSetIndex(row, x, bits, 0);
+  }
+}
+
+// Fill the palette from BGR888 entries
+void framebufferSetPaletteBGR(GlitchFramebuffer *fb, const uint8_t *bgr, uint16_t count)
+{
+  uint16_t entries = framebufferPaletteEntries(fb);
+  if (count > entries)
+    count = entries;
+
+  uint16_t *palette = framebufferPalette(fb);
+  convertBGR888To565(palette, bgr, count);
+  for (uint16_t i = count; i < entries; i++)
+    palette[i] = 0;
+  *framebufferPaletteUsed(fb) = count;
+}
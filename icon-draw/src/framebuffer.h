@@ -0,0 +1,226 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pixel_convert.h"
+
+// Pixel layouts a framebuffer can hold
+//   FB_RGB888_PLANAR      - three 8-bit planes (R, then G, then B), one after another
+//   FB_RGB888_INTERLEAVED - one plane of packed R,G,B byte triplets
+//   FB_RGB565             - one plane of native-endian 16-bit RGB565 words
+//   FB_INDEXED1/4/8       - one plane of 1, 4 or 8-bit palette indices, packed leftmost
+//                           pixel in the most significant bits (as in BMP files), followed
+//                           by an RGB565 palette sized when allocating (see framebufferPalette)
+enum FramebufferFormat : uint8_t
+{
+  FB_RGB888_PLANAR,
+  FB_RGB888_INTERLEAVED,
+  FB_RGB565,
+  FB_INDEXED1,
+  FB_INDEXED4,
+  FB_INDEXED8
+};
+
+// Optional allocator for framebuffer blocks (e.g. PSRAM, or a budgeted cache pool)
+struct FramebufferAllocator
+{
+  void *(*alloc)(void *ctx, size_t size);
+  void (*free)(void *ctx, void *ptr);
+  void *ctx;
+};
+
+// Image held in ONE contiguous allocation. Rows are `stride` bytes apart and,
+// for the planar layout, planes are `planeSize` bytes apart, so every plane can
+// be walked linearly from `data`. No Arduino dependencies so it builds on a host.
+struct GlitchFramebuffer
+{
+  uint8_t *data;      // Single block: planeCount * planeSize bytes (+ palette when indexed)
+  int16_t width;      // Pixels per row
+  int16_t height;     // Rows
+  uint16_t stride;    // Bytes from one row to the next (4-byte aligned)
+  uint32_t planeSize; // Bytes per plane (stride * height)
+  FramebufferFormat format;
+  bool allocated;
+  const FramebufferAllocator *allocator; // nullptr = malloc/free
+};
+
+// Empty framebuffer initializer
+#define GLITCH_FRAMEBUFFER_INIT {nullptr, 0, 0, 0, 0, FB_RGB888_PLANAR, false, nullptr}
+
+// Allocate a framebuffer with a single allocation through fb->allocator (malloc when
+// unset). Indexed formats get room for `paletteEntries` colours (0 = one per index value);
+// an image only needs its own, while a compose target needs spare entries for colours its
+// channel remaps derive. A block already of this size, format and palette is kept (an
+// indexed one gets an empty palette again); any other previous contents are freed first.
+bool allocateFramebuffer(GlitchFramebuffer *fb, int16_t width, int16_t height, FramebufferFormat format,
+                         uint16_t paletteEntries = 0);
+
+// Free framebuffer memory
+void freeFramebuffer(GlitchFramebuffer *fb);
+
+// Running totals of framebuffer heap allocations/frees since boot. Every framebuffer
+// block goes through allocateFramebuffer(), so a test can sample these around a
+// frame to prove the steady state does no heap activity.
+uint32_t framebufferAllocationCount();
+uint32_t framebufferFreeCount();
+
+// Number of planes for a format (3 for planar RGB888, 1 otherwise)
+inline uint8_t framebufferPlaneCount(FramebufferFormat format)
+{
+  return format == FB_RGB888_PLANAR ? 3 : 1;
+}
+
+// Bits one pixel occupies within a plane
+inline uint8_t framebufferBitsPerPixel(FramebufferFormat format)
+{
+  switch (format)
+  {
+  case FB_RGB888_INTERLEAVED:
+    return 24;
+  case FB_RGB565:
+    return 16;
+  case FB_INDEXED1:
+    return 1;
+  case FB_INDEXED4:
+    return 4;
+  default:
+    return 8;
+  }
+}
+
+inline bool framebufferIsIndexed(FramebufferFormat format)
+{
+  return format >= FB_INDEXED1;
+}
+
+// Indexed format holding `bitsPerPixel`-bit indices (1, 4 or 8)
+inline FramebufferFormat framebufferIndexedFormat(uint16_t bitsPerPixel)
+{
+  return bitsPerPixel == 1 ? FB_INDEXED1 : (bitsPerPixel == 4 ? FB_INDEXED4 : FB_INDEXED8);
+}
+
+// Most palette entries an indexed format can address (one per index value), 0 otherwise
+inline uint16_t framebufferPaletteCapacity(FramebufferFormat format)
+{
+  return framebufferIsIndexed(format) ? 1 << framebufferBitsPerPixel(format) : 0;
+}
+
+// Bytes after the planes holding a palette of `entries` colours: entries in use, entries
+// allocated, RGB565 entries
+inline size_t framebufferPaletteBytes(FramebufferFormat format, uint16_t entries)
+{
+  return framebufferIsIndexed(format) ? 4 + 2 * (size_t)entries : 0;
+}
+
+// Palette entries defined so far. Colours derived while composing are appended after the
+// image's own, so this can grow up to framebufferPaletteEntries().
+inline uint16_t *framebufferPaletteUsed(const GlitchFramebuffer *fb)
+{
+  return (uint16_t *)(fb->data + fb->planeSize);
+}
+
+// Palette entries the block has room for (fixed when it is allocated)
+inline uint16_t framebufferPaletteEntries(const GlitchFramebuffer *fb)
+{
+  return framebufferIsIndexed(fb->format) ? ((const uint16_t *)(fb->data + fb->planeSize))[1] : 0;
+}
+
+// Total bytes of the block (pixels and, for indexed formats, the palette). Copying this
+// many bytes copies a whole image, palette included.
+inline size_t framebufferSize(const GlitchFramebuffer *fb)
+{
+  return (size_t)fb->planeSize * framebufferPlaneCount(fb->format) +
+         framebufferPaletteBytes(fb->format, framebufferPaletteEntries(fb));
+}
+
+// RGB565 palette of an indexed framebuffer: framebufferPaletteEntries() entries. This is
+// the present-time lookup table; entries past the image's own colours start black.
+inline uint16_t *framebufferPalette(const GlitchFramebuffer *fb)
+{
+  return (uint16_t *)(fb->data + fb->planeSize) + 2;
+}
+
+// Start of row `y` in plane `plane` (plane is only meaningful for FB_RGB888_PLANAR)
+inline uint8_t *framebufferRow(const GlitchFramebuffer *fb, int16_t y, uint8_t plane = 0)
+{
+  return fb->data + (size_t)plane * fb->planeSize + (size_t)y * fb->stride;
+}
+
+// Palette index of pixel `x` in an indexed row of `bits`-bit indices
+inline uint8_t framebufferGetIndex(const uint8_t *row, int16_t x, uint8_t bits)
+{
+  if (bits == 8)
+    return row[x];
+  uint8_t shift = 8 - bits - (x * bits & 7);
+  return (row[x * bits >> 3] >> shift) & ((1 << bits) - 1);
+}
+
+// Set the palette index of pixel `x` in an indexed row of `bits`-bit indices
+inline void framebufferSetIndex(uint8_t *row, int16_t x, uint8_t bits, uint8_t index)
+{
+  if (bits == 8)
+  {
+    row[x] = index;
+    return;
+  }
+  uint8_t shift = 8 - bits - (x * bits & 7);
+  uint8_t mask = ((1 << bits) - 1) << shift;
+  uint8_t &byte = row[x * bits >> 3];
+  byte = (byte & ~mask) | ((index << shift) & mask);
+}
+
+// Write one pixel from 8-bit channels (RGB formats; indexed formats take framebufferSetIndex)
+inline void framebufferSetPixel(GlitchFramebuffer *fb, int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b)
+{
+  uint8_t *row = framebufferRow(fb, y);
+  switch (fb->format)
+  {
+  case FB_RGB888_PLANAR:
+    row[x] = r;
+    row[x + fb->planeSize] = g;
+    row[x + 2 * fb->planeSize] = b;
+    break;
+  case FB_RGB888_INTERLEAVED:
+    row[x * 3] = r;
+    row[x * 3 + 1] = g;
+    row[x * 3 + 2] = b;
+    break;
+  case FB_RGB565:
+    ((uint16_t *)row)[x] = rgb565(r, g, b);
+    break;
+  default:
+    break;
+  }
+}
+
+// Read one pixel as RGB565
+inline uint16_t framebufferGetPixel565(const GlitchFramebuffer *fb, int16_t x, int16_t y)
+{
+  const uint8_t *row = framebufferRow(fb, y);
+  switch (fb->format)
+  {
+  case FB_RGB888_PLANAR:
+    return rgb565(row[x], row[x + fb->planeSize], row[x + 2 * fb->planeSize]);
+  case FB_RGB888_INTERLEAVED:
+    return rgb565(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]);
+  case FB_RGB565:
+    return ((const uint16_t *)row)[x];
+  default:
+    return framebufferPalette(fb)[framebufferGetIndex(row, x, framebufferBitsPerPixel(fb->format))];
+  }
+}
+
+// Store a row of BMP-ordered BGR888 pixels into row `y`, converting to the framebuffer format
+// (RGB formats only)
+void framebufferWriteRowBGR(GlitchFramebuffer *fb, int16_t y, const uint8_t *bgr);
+
+// Store a row of packed palette indices (same depth and bit order) into row `y` of an
+// indexed framebuffer. Indices past the palette are stored as 0, so lookups stay inside it.
+void framebufferWriteRowIndices(GlitchFramebuffer *fb, int16_t y, const uint8_t *indices);
+
+// Fill the palette of an indexed framebuffer from `count` BMP-ordered BGR888 entries (at
+// most framebufferPaletteEntries()). The rest of the palette is cleared to black.
+void framebufferSetPaletteBGR(GlitchFramebuffer *fb, const uint8_t *bgr, uint16_t count);
+
+#endif
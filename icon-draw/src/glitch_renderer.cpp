@@ -0,0 +1,640 @@
+#include "glitch_renderer.h"
+
+#include <string.h>
+#include <algorithm>
+
+/*--------------------- PRNG -------------------------*/
+
+void glitchRngSeed(GlitchRng *rng, uint32_t seed)
+{
+  rng->state = seed;
+}
+
+uint32_t glitchRngNext(GlitchRng *rng)
+{
+  uint32_t z = rng->state += 0x6D2B79F5;
+  z = (z ^ (z >> 15)) * (z | 1);
+  z ^= z + (z ^ (z >> 7)) * (z | 61);
+  return z ^ (z >> 14);
+}
+
+int32_t glitchRngRange(GlitchRng *rng, int32_t min, int32_t max)
+{
+  if (max <= min)
+    return min;
+  // Scale the 32-bit value into the range with a multiply instead of a modulo
+  return min + (int32_t)(((uint64_t)glitchRngNext(rng) * (uint32_t)(max - min)) >> 32);
+}
+
+uint32_t glitchFrameSeed(uint32_t streamSeed, uint32_t frame)
+{
+  // Hash rather than step, so frame n is reachable without generating frames 0..n-1
+  uint32_t z = streamSeed + frame * 0x9E3779B9;
+  z = (z ^ (z >> 16)) * 0x85EBCA6B;
+  z = (z ^ (z >> 13)) * 0xC2B2AE35;
+  return z ^ (z >> 16);
+}
+
+/*--------------------- KERNELS -------------------------*/
+
+// Wrap a coordinate into [0, n) (toroidal wrapping, handles negative values)
+static inline int16_t wrapCoord(int16_t v, int16_t n)
+{
+  return ((v % n) + n) % n;
+}
+
+#define REMAP_EMPTY 0xFFFF
+
+// RGB565 bits of each channel
+static const uint16_t channelMask[3] = {0xF800, 0x07E0, 0x001F};
+
+// Channel shift for indexed frames. Shifting one channel combines the channel of one
+// colour with the rest of another, so a pixel whose index differs from the shifted
+// source's is remapped to the palette entry of that mix: an existing entry when the
+// colour is in the palette, else one appended to the frame's palette. Once the palette is
+// full the pixel takes the source index, as a whole-pixel shift would. Entries are found
+// through an open-addressed colour -> index table, built on the frame's first remap in
+// the composing renderer's remapTable (outside the task's stack: the producer's is small).
+struct PaletteRemap
+{
+  uint16_t mask;   // RGB565 bits of the shifted channel
+  bool ready;      // Table built for this frame
+  uint16_t *table; // Palette index per slot (the colour is the palette's), REMAP_EMPTY = empty
+};
+
+static inline void remapInit(PaletteRemap *remap, uint16_t *table)
+{
+  remap->ready = false;
+  remap->table = table;
+}
+
+static inline uint16_t remapSlot(uint16_t color)
+{
+  return (uint16_t)(color * 40503u) >> 7; // Multiplicative hash, top 9 bits
+}
+
+// Add palette entry `index` unless its colour is already present (first entry wins)
+static void remapInsert(PaletteRemap *remap, const uint16_t *palette, uint8_t index)
+{
+  uint16_t color = palette[index];
+  uint16_t slot = remapSlot(color);
+  while (remap->table[slot] != REMAP_EMPTY)
+  {
+    if (palette[remap->table[slot]] == color)
+      return;
+    slot = (slot + 1) & (GLITCH_REMAP_SLOTS - 1);
+  }
+  remap->table[slot] = index;
+}
+
+// Index showing `dstIndex` with the shifted channel taken from `srcIndex` (which differs)
+static uint8_t remapIndex(PaletteRemap *remap, GlitchFramebuffer *dst, uint8_t dstIndex, uint8_t srcIndex)
+{
+  uint16_t *palette = framebufferPalette(dst);
+  uint16_t &used = *framebufferPaletteUsed(dst);
+  if (!remap->ready)
+  {
+    memset(remap->table, 0xFF, GLITCH_REMAP_SLOTS * sizeof(uint16_t));
+    for (uint16_t i = 0; i < used; i++)
+      remapInsert(remap, palette, i);
+    remap->ready = true;
+  }
+
+  uint16_t mixed = (palette[dstIndex] & ~remap->mask) | (palette[srcIndex] & remap->mask);
+  uint16_t slot = remapSlot(mixed);
+  while (remap->table[slot] != REMAP_EMPTY)
+  {
+    if (palette[remap->table[slot]] == mixed)
+      return remap->table[slot];
+    slot = (slot + 1) & (GLITCH_REMAP_SLOTS - 1);
+  }
+
+  if (used >= framebufferPaletteEntries(dst))
+    return srcIndex;
+  palette[used] = mixed;
+  remap->table[slot] = used;
+  return used++;
+}
+
+// Move (remap == nullptr) or channel-remap `count` indices of BITS bits each from `s`
+// into the 8-bit indices at `d`
+template <uint8_t BITS>
+static void copyIndices(GlitchFramebuffer *dst, uint8_t *d, const uint8_t *s, int16_t sx, int16_t count,
+                        PaletteRemap *remap)
+{
+  const uint8_t perByte = 8 / BITS;
+  int16_t i = 0;
+
+  // Moves starting on a byte boundary (e.g. the per-frame reset) unpack whole bytes
+  if (!remap && BITS < 8 && (sx * BITS & 7) == 0)
+  {
+    const uint8_t *packed = s + (sx * BITS >> 3);
+    for (; i + perByte <= count; i += perByte, packed++)
+    {
+      uint8_t byte = *packed;
+      for (uint8_t k = 0; k < perByte; k++)
+        d[i + k] = (byte >> (8 - BITS * (k + 1))) & ((1 << BITS) - 1);
+    }
+  }
+
+  for (; i < count; i++)
+  {
+    uint8_t index = framebufferGetIndex(s, sx + i, BITS);
+    if (!remap)
+      d[i] = index;
+    else if (d[i] != index)
+      d[i] = remapIndex(remap, dst, d[i], index);
+  }
+}
+
+// Copy `count` pixels of channel `channel` (0=R, 1=G, 2=B, -1 = all) from (sx, sy) in src to
+// (dx, dy) in dst, a frame in layout F. Neither span may wrap. The layout is a template
+// argument and the channel choice is made once per span, so the copies below are straight
+// memcpy()s or branch-free strided loops. Indexed frames (always composed at 8 bits, see
+// composeFormat) move whole indices, or remap them through `remap` for a single channel.
+template <FramebufferFormat F>
+static void copySpan(GlitchFramebuffer *dst, int16_t dx, int16_t dy,
+                     const GlitchFramebuffer *src, int16_t sx, int16_t sy, int16_t count, int channel,
+                     PaletteRemap *remap)
+{
+  uint8_t *d = framebufferRow(dst, dy);
+  const uint8_t *s = framebufferRow(src, sy);
+
+  switch (F)
+  {
+  case FB_RGB888_PLANAR:
+    if (channel < 0)
+    {
+      for (uint8_t c = 0; c < 3; c++)
+        memcpy(d + c * dst->planeSize + dx, s + c * src->planeSize + sx, count);
+    }
+    else
+    {
+      memcpy(d + channel * dst->planeSize + dx, s + channel * src->planeSize + sx, count);
+    }
+    break;
+  case FB_RGB888_INTERLEAVED:
+    if (channel < 0)
+    {
+      memcpy(d + dx * 3, s + sx * 3, count * 3);
+    }
+    else
+    {
+      d += dx * 3 + channel;
+      s += sx * 3 + channel;
+      for (int16_t i = 0; i < count; i++, d += 3, s += 3)
+        *d = *s;
+    }
+    break;
+  case FB_RGB565:
+    if (channel < 0)
+    {
+      memcpy(d + dx * 2, s + sx * 2, count * 2);
+    }
+    else
+    {
+      uint16_t mask = channelMask[channel];
+      uint16_t *d16 = (uint16_t *)d + dx;
+      const uint16_t *s16 = (const uint16_t *)s + sx;
+      for (int16_t i = 0; i < count; i++)
+        d16[i] = (d16[i] & ~mask) | (s16[i] & mask);
+    }
+    break;
+  default:
+  {
+    // Indexed: the target holds 8-bit indices, the source may be packed
+    PaletteRemap *channelRemap = channel < 0 ? nullptr : remap;
+    if (src->format == FB_INDEXED4)
+      copyIndices<4>(dst, d + dx, s, sx, count, channelRemap);
+    else if (src->format == FB_INDEXED1)
+      copyIndices<1>(dst, d + dx, s, sx, count, channelRemap);
+    else if (channelRemap)
+      copyIndices<8>(dst, d + dx, s, sx, count, channelRemap);
+    else
+      memcpy(d + dx, s + sx, count);
+    break;
+  }
+  }
+}
+
+// Overwrite the box (boxX, boxY, boxW, boxH) of dst with the same channel(s) of src read
+// (offsetX, offsetY) away, wrapping at the image edges. The wrapped box is split into at
+// most four rectangles that do not cross an edge; each row of each rectangle is copied
+// as one span, or two when the offset source crosses an edge. Boxes must be no larger
+// than the image, as the random ranges in applyEffect() guarantee.
+template <FramebufferFormat F>
+static void shiftBox(GlitchFramebuffer *dst, const GlitchFramebuffer *src,
+                     int16_t boxX, int16_t boxY, int16_t boxW, int16_t boxH,
+                     int16_t offsetX, int16_t offsetY, int channel, PaletteRemap *remap)
+{
+  int16_t width = src->width;
+  int16_t height = src->height;
+
+  boxX = wrapCoord(boxX, width);
+  boxY = wrapCoord(boxY, height);
+
+  // Column and row ranges of the box that stay inside the image
+  int16_t colStart[2] = {boxX, 0};
+  int16_t colCount[2] = {(int16_t)(boxW < width - boxX ? boxW : width - boxX), 0};
+  colCount[1] = boxW - colCount[0];
+
+  int16_t rowStart[2] = {boxY, 0};
+  int16_t rowCount[2] = {(int16_t)(boxH < height - boxY ? boxH : height - boxY), 0};
+  rowCount[1] = boxH - rowCount[0];
+
+  if (channel >= 0)
+    remap->mask = channelMask[channel];
+
+  for (uint8_t ry = 0; ry < 2; ry++)
+  {
+    for (int16_t dy = rowStart[ry]; dy < rowStart[ry] + rowCount[ry]; dy++)
+    {
+      int16_t sy = wrapCoord(dy + offsetY, height);
+
+      for (uint8_t rx = 0; rx < 2; rx++)
+      {
+        if (colCount[rx] == 0)
+          continue;
+
+        int16_t dx = colStart[rx];
+        int16_t sx = wrapCoord(dx + offsetX, width);
+
+        // The source span can itself cross the right edge
+        int16_t first = colCount[rx] < width - sx ? colCount[rx] : width - sx;
+        copySpan<F>(dst, dx, dy, src, sx, sy, first, channel, remap);
+        if (first < colCount[rx])
+          copySpan<F>(dst, dx + first, dy, src, 0, sy, colCount[rx] - first, channel, remap);
+      }
+    }
+  }
+}
+
+// Rotate rows [y, y + rows) of a frame in layout F left by `offset` pixels (right when
+// negative), in place. Each plane's row turns as one run of bytes.
+template <FramebufferFormat F>
+static void tearRows(GlitchFramebuffer *fb, int16_t y, int16_t rows, int16_t offset)
+{
+  const uint8_t bytes = framebufferBitsPerPixel(F) / 8;
+  size_t rowBytes = (size_t)fb->width * bytes;
+  size_t shift = (size_t)wrapCoord(offset, fb->width) * bytes;
+  if (shift == 0)
+    return;
+
+  for (int16_t row = y; row < y + rows; row++)
+  {
+    for (uint8_t plane = 0; plane < framebufferPlaneCount(F); plane++)
+    {
+      uint8_t *data = framebufferRow(fb, row, plane);
+      std::rotate(data, data + shift, data + rowBytes);
+    }
+  }
+}
+
+// Rough brightness (0-255) for pixel sorting
+static inline uint8_t sortKey(uint8_t r, uint8_t g, uint8_t b)
+{
+  return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// A pixel of each composed layout as one value, and its sort key. RGB values are packed
+// red-first like RGB565, so equal keys tie-break the same way in every RGB layout.
+template <FramebufferFormat F>
+struct SortPixel;
+
+template <>
+struct SortPixel<FB_RGB888_PLANAR>
+{
+  static uint32_t load(const GlitchFramebuffer *fb, const uint8_t *row, int16_t x)
+  {
+    return ((uint32_t)row[x] << 16) | (row[x + fb->planeSize] << 8) | row[x + 2 * fb->planeSize];
+  }
+  static void store(const GlitchFramebuffer *fb, uint8_t *row, int16_t x, uint32_t value)
+  {
+    row[x] = value >> 16;
+    row[x + fb->planeSize] = value >> 8;
+    row[x + 2 * fb->planeSize] = value;
+  }
+  static uint8_t key(const GlitchFramebuffer *, uint32_t value)
+  {
+    return sortKey(value >> 16, value >> 8, value);
+  }
+};
+
+template <>
+struct SortPixel<FB_RGB888_INTERLEAVED>
+{
+  static uint32_t load(const GlitchFramebuffer *, const uint8_t *row, int16_t x)
+  {
+    return ((uint32_t)row[x * 3] << 16) | (row[x * 3 + 1] << 8) | row[x * 3 + 2];
+  }
+  static void store(const GlitchFramebuffer *, uint8_t *row, int16_t x, uint32_t value)
+  {
+    row[x * 3] = value >> 16;
+    row[x * 3 + 1] = value >> 8;
+    row[x * 3 + 2] = value;
+  }
+  static uint8_t key(const GlitchFramebuffer *, uint32_t value)
+  {
+    return sortKey(value >> 16, value >> 8, value);
+  }
+};
+
+template <>
+struct SortPixel<FB_RGB565>
+{
+  static uint32_t load(const GlitchFramebuffer *, const uint8_t *row, int16_t x)
+  {
+    return ((const uint16_t *)row)[x];
+  }
+  static void store(const GlitchFramebuffer *, uint8_t *row, int16_t x, uint32_t value)
+  {
+    ((uint16_t *)row)[x] = value;
+  }
+  static uint8_t key(const GlitchFramebuffer *, uint32_t value)
+  {
+    return sortKey((value >> 8) & 0xF8, (value >> 3) & 0xFC, (value << 3) & 0xF8);
+  }
+};
+
+template <>
+struct SortPixel<FB_INDEXED8>
+{
+  static uint32_t load(const GlitchFramebuffer *, const uint8_t *row, int16_t x)
+  {
+    return row[x];
+  }
+  static void store(const GlitchFramebuffer *, uint8_t *row, int16_t x, uint32_t value)
+  {
+    row[x] = value;
+  }
+  static uint8_t key(const GlitchFramebuffer *fb, uint32_t value)
+  {
+    uint16_t color = framebufferPalette(fb)[value];
+    return sortKey((color >> 8) & 0xF8, (color >> 3) & 0xFC, (color << 3) & 0xF8);
+  }
+};
+
+// Longest run a pixel sort reorders
+#define GLITCH_SORT_MAX 128
+
+// Sort the `count` pixels from column x in rows [y, y + rows) by brightness, in place.
+// Pixels are sorted as key << 24 | value, so equal keys order by value and the result
+// does not depend on the sort algorithm.
+template <FramebufferFormat F>
+static void sortRuns(GlitchFramebuffer *fb, int16_t y, int16_t rows, int16_t x, int16_t count, bool descending)
+{
+  uint32_t keyed[GLITCH_SORT_MAX];
+  if (count > GLITCH_SORT_MAX)
+    count = GLITCH_SORT_MAX;
+
+  for (int16_t row = y; row < y + rows; row++)
+  {
+    uint8_t *data = framebufferRow(fb, row);
+    for (int16_t i = 0; i < count; i++)
+    {
+      uint32_t value = SortPixel<F>::load(fb, data, x + i);
+      keyed[i] = ((uint32_t)SortPixel<F>::key(fb, value) << 24) | value;
+    }
+
+    std::sort(keyed, keyed + count);
+    for (int16_t i = 0; i < count; i++)
+      SortPixel<F>::store(fb, data, x + i, keyed[descending ? count - 1 - i : i] & 0xFFFFFF);
+  }
+}
+
+// Random sign for an offset
+static inline int16_t randomSign(GlitchRng *rng)
+{
+  return glitchRngRange(rng, 0, 2) == 0 ? 1 : -1;
+}
+
+// Draw one effect's parameters and apply it
+template <FramebufferFormat F>
+static void applyEffect(GlitchEffectType type, GlitchFramebuffer *target, const GlitchFramebuffer *source,
+                        GlitchRng *rng, PaletteRemap *remap)
+{
+  int16_t width = source->width;
+  int16_t height = source->height;
+
+  switch (type)
+  {
+  case GLITCH_BOX_SHIFT:
+  {
+    // Random box dimensions and position (can go off edge)
+    int16_t boxX = glitchRngRange(rng, -width / 2, width);
+    int16_t boxY = glitchRngRange(rng, -height / 2, height);
+    int16_t boxW = glitchRngRange(rng, width / 4, width);
+    int16_t boxH = glitchRngRange(rng, height / 4, height);
+
+    // 50% chance to shift whole image chunk (all RGB), 50% chance to shift single channel
+    bool shiftAllChannels = glitchRngRange(rng, 0, 2) == 0;
+
+    // Random channel to offset (0=R, 1=G, 2=B) - only used if not shifting all
+    int channel = glitchRngRange(rng, 0, 3);
+
+    // Random offset amount (0-3 pixels either way). Magnitude is drawn before sign so
+    // the sequence does not depend on the compiler's operand evaluation order
+    int16_t offsetX = glitchRngRange(rng, 0, 4);
+    offsetX *= randomSign(rng);
+    int16_t offsetY = glitchRngRange(rng, 0, 4);
+    offsetY *= randomSign(rng);
+
+    // Shift entire image chunk (all channels), or a single colour channel (chromatic aberration effect)
+    shiftBox<F>(target, source, boxX, boxY, boxW, boxH, offsetX, offsetY, shiftAllChannels ? -1 : channel, remap);
+    break;
+  }
+  case GLITCH_CHROMA_SPLIT:
+  {
+    int channel = glitchRngRange(rng, 0, 3);
+    int16_t offsetX = glitchRngRange(rng, 1, 4);
+    offsetX *= randomSign(rng);
+    int16_t offsetY = glitchRngRange(rng, 0, 2);
+    offsetY *= randomSign(rng);
+    shiftBox<F>(target, source, 0, 0, width, height, offsetX, offsetY, channel, remap);
+    break;
+  }
+  case GLITCH_SCANLINE_TEAR:
+  {
+    int16_t rows = glitchRngRange(rng, 1, height / 8 + 1);
+    int16_t y = glitchRngRange(rng, 0, height - rows + 1);
+    int16_t offset = glitchRngRange(rng, 1, width / 8 + 1);
+    offset *= randomSign(rng);
+    tearRows<F>(target, y, rows, offset);
+    break;
+  }
+  case GLITCH_PIXEL_SORT:
+  {
+    int16_t rows = glitchRngRange(rng, 1, height / 8 + 1);
+    int16_t y = glitchRngRange(rng, 0, height - rows + 1);
+    int16_t count = glitchRngRange(rng, width / 8, width / 2 + 1);
+    int16_t x = glitchRngRange(rng, 0, width - count + 1);
+    bool descending = glitchRngRange(rng, 0, 2) == 0;
+    sortRuns<F>(target, y, rows, x, count, descending);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+// Run every stage of the chain on a frame in layout F
+template <FramebufferFormat F>
+static void applyChain(GlitchFramebuffer *target, const GlitchFramebuffer *source, const GlitchEffectChain *chain,
+                       GlitchRng *rng, uint16_t *remapTable)
+{
+  // Channel remaps of indexed frames (lookup table built on first use)
+  PaletteRemap remap;
+  remapInit(&remap, remapTable);
+
+  for (uint8_t e = 0; e < chain->count; e++)
+  {
+    const GlitchEffect &effect = chain->effects[e];
+    for (uint8_t i = 0; i < effect.repeat; i++)
+    {
+      // Effects that always run draw nothing for the roll
+      if (effect.chance < GLITCH_ALWAYS && glitchRngRange(rng, 0, GLITCH_ALWAYS) >= effect.chance)
+        continue;
+      applyEffect<F>(effect.type, target, source, rng, &remap);
+    }
+  }
+}
+
+static const GlitchEffect classicEffects[] = {{GLITCH_BOX_SHIFT, 4, GLITCH_ALWAYS}};
+const GlitchEffectChain GLITCH_CHAIN_CLASSIC = {classicEffects, 1};
+
+// Format a source is composed in. Packed 1/4-bit sources are composed at 8 bits: index
+// moves become byte copies. The target always gets the full 256-entry palette (however
+// few colours the source stores), which has room for every colour channel shifts mix.
+static FramebufferFormat composeFormat(FramebufferFormat format)
+{
+  return framebufferIsIndexed(format) ? FB_INDEXED8 : format;
+}
+
+// Match a target framebuffer to the source size/format (allocates only on a mismatch)
+static bool matchSource(GlitchFramebuffer *target, const GlitchFramebuffer *source)
+{
+  FramebufferFormat format = composeFormat(source->format);
+  if (target->allocated && target->width == source->width && target->height == source->height &&
+      target->format == format && framebufferPaletteEntries(target) == framebufferPaletteCapacity(format))
+    return true;
+
+  return allocateFramebuffer(target, source->width, source->height, format);
+}
+
+// Reset the target to the unglitched source
+static void resetFromSource(GlitchFramebuffer *target, const GlitchFramebuffer *source)
+{
+  // Same layout: one block, one copy (palette included, so colours derived by the
+  // previous frame's channel remaps are dropped)
+  if (target->format == source->format && framebufferSize(target) == framebufferSize(source))
+  {
+    memcpy(target->data, source->data, framebufferSize(source));
+    return;
+  }
+
+  // Indices into a bigger palette: copy 8-bit rows as they are, widen packed ones to
+  // bytes, then take the image's own colours over
+  if (target->format == source->format)
+  {
+    memcpy(target->data, source->data, source->planeSize);
+  }
+  else
+  {
+    for (int16_t y = 0; y < source->height; y++)
+      copySpan<FB_INDEXED8>(target, 0, y, source, 0, y, source->width, -1, nullptr);
+  }
+
+  uint16_t used = *framebufferPaletteUsed(source);
+  uint16_t *palette = framebufferPalette(target);
+  memcpy(palette, framebufferPalette(source), used * sizeof(uint16_t));
+  memset(palette + used, 0, (framebufferPaletteEntries(target) - used) * sizeof(uint16_t));
+  *framebufferPaletteUsed(target) = used;
+}
+
+// Match the back buffer to the source size/format
+bool glitchRendererPrepare(GlitchRenderer *renderer, const GlitchFramebuffer *source)
+{
+  return matchSource(&renderer->back, source);
+}
+
+// Compose one glitched frame of source into target
+bool glitchCompose(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *source,
+                   const GlitchEffectChain *chain, uint32_t seed)
+{
+  if (!source || !source->allocated || !matchSource(target, source))
+    return false;
+
+  // Reset the working copy from the original
+  resetFromSource(target, source);
+
+  GlitchRng rng;
+  glitchRngSeed(&rng, seed);
+
+  // One dispatch on the layout per frame; everything below it is specialised
+  const GlitchEffectChain *effects = chain ? chain : &GLITCH_CHAIN_CLASSIC;
+  switch (target->format)
+  {
+  case FB_RGB888_PLANAR:
+    applyChain<FB_RGB888_PLANAR>(target, source, effects, &rng, renderer->remapTable);
+    break;
+  case FB_RGB888_INTERLEAVED:
+    applyChain<FB_RGB888_INTERLEAVED>(target, source, effects, &rng, renderer->remapTable);
+    break;
+  case FB_RGB565:
+    applyChain<FB_RGB565>(target, source, effects, &rng, renderer->remapTable);
+    break;
+  default:
+    applyChain<FB_INDEXED8>(target, source, effects, &rng, renderer->remapTable);
+    break;
+  }
+
+  return true;
+}
+
+void glitchShiftBox(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *source,
+                    int16_t boxX, int16_t boxY, int16_t boxW, int16_t boxH, int16_t offsetX, int16_t offsetY,
+                    int channel)
+{
+  PaletteRemap remap;
+  remapInit(&remap, renderer->remapTable);
+  switch (target->format)
+  {
+  case FB_RGB888_PLANAR:
+    shiftBox<FB_RGB888_PLANAR>(target, source, boxX, boxY, boxW, boxH, offsetX, offsetY, channel, &remap);
+    break;
+  case FB_RGB888_INTERLEAVED:
+    shiftBox<FB_RGB888_INTERLEAVED>(target, source, boxX, boxY, boxW, boxH, offsetX, offsetY, channel, &remap);
+    break;
+  case FB_RGB565:
+    shiftBox<FB_RGB565>(target, source, boxX, boxY, boxW, boxH, offsetX, offsetY, channel, &remap);
+    break;
+  default:
+    shiftBox<FB_INDEXED8>(target, source, boxX, boxY, boxW, boxH, offsetX, offsetY, channel, &remap);
+    break;
+  }
+}
+
+void glitchRendererSeed(GlitchRenderer *renderer, uint32_t seed)
+{
+  renderer->seed = seed;
+  renderer->frame = 0;
+}
+
+uint32_t glitchRendererNextSeed(GlitchRenderer *renderer)
+{
+  renderer->lastSeed = glitchFrameSeed(renderer->seed, renderer->frame++);
+  return renderer->lastSeed;
+}
+
+// Compose the next frame of the renderer's stream into its back buffer
+const GlitchFramebuffer *glitchRendererCompose(GlitchRenderer *renderer, const GlitchFramebuffer *source)
+{
+  uint32_t seed = glitchRendererNextSeed(renderer);
+  return glitchCompose(renderer, &renderer->back, source, renderer->chain, seed) ? &renderer->back : nullptr;
+}
+
+// Release the back buffer
+void freeGlitchRenderer(GlitchRenderer *renderer)
+{
+  freeFramebuffer(&renderer->back);
+}
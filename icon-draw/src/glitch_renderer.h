@@ -0,0 +1,116 @@
+#ifndef GLITCH_RENDERER_H
+#define GLITCH_RENDERER_H
+
+#include "framebuffer.h"
+
+// Fast seeded PRNG (mulberry32). Every glitch parameter is drawn from one of these, so
+// a frame is a pure function of its source image, effect chain and seed: any frame can
+// be replayed bit-exactly, on the device or a host.
+struct GlitchRng
+{
+  uint32_t state;
+};
+
+void glitchRngSeed(GlitchRng *rng, uint32_t seed);
+uint32_t glitchRngNext(GlitchRng *rng);
+
+// Uniform value in [min, max), like Arduino random(min, max)
+int32_t glitchRngRange(GlitchRng *rng, int32_t min, int32_t max);
+
+// Seed of frame `frame` of the stream started by `streamSeed`
+uint32_t glitchFrameSeed(uint32_t streamSeed, uint32_t frame);
+
+// Effects a frame is built from. Box shifts and chroma splits copy from the unglitched
+// source (a later one overwrites an earlier one where they overlap); scanline tears and
+// pixel sorts rework the frame composed so far.
+enum GlitchEffectType : uint8_t
+{
+  GLITCH_BOX_SHIFT,     // Random box moved 0-3 pixels: all channels, or one (chromatic aberration)
+  GLITCH_CHROMA_SPLIT,  // One channel of the whole frame offset 1-3 pixels
+  GLITCH_SCANLINE_TEAR, // Band of rows rotated sideways
+  GLITCH_PIXEL_SORT,    // Runs of pixels in a band of rows sorted by brightness
+  GLITCH_EFFECT_COUNT
+};
+
+#define GLITCH_ALWAYS 256 // GlitchEffect::chance of an effect that always runs
+
+// One stage of the per-frame pipeline: `repeat` attempts, each run with probability
+// chance / 256
+struct GlitchEffect
+{
+  GlitchEffectType type;
+  uint8_t repeat;
+  uint16_t chance;
+};
+
+// Stages applied in order to every frame
+struct GlitchEffectChain
+{
+  const GlitchEffect *effects;
+  uint8_t count;
+};
+
+// Four box shifts per frame: the original glitch
+extern const GlitchEffectChain GLITCH_CHAIN_CLASSIC;
+
+// Slots in the colour lookup of an indexed frame's channel remaps (twice the largest palette)
+#define GLITCH_REMAP_SLOTS 512
+
+// Glitch compositor that owns its back buffer. The back buffer is allocated on the
+// first frame and only reallocated when the source size or format changes, so a
+// steady stream of frames does no heap activity.
+//
+// Each effect kernel is specialised at compile time for the frame's pixel layout, and
+// the layout is dispatched once per frame, so no effect branches on the format per pixel.
+//
+// Indexed sources (any depth) are composed into an FB_INDEXED8 frame: box shifts move
+// indices, and single-channel shifts are palette remaps that add the mixed colours to
+// the frame's own palette (see glitch_renderer.cpp). The colour lookup those remaps
+// build is the renderer's too, so each renderer composes one frame at a time and tasks
+// composing at once each need their own.
+struct GlitchRenderer
+{
+  GlitchFramebuffer back;         // Composed frame, valid after glitchRendererCompose()
+  const GlitchEffectChain *chain; // nullptr = GLITCH_CHAIN_CLASSIC
+  uint32_t seed;                  // Stream seed: frame n uses glitchFrameSeed(seed, n)
+  uint32_t frame;                 // Frames drawn from the stream so far
+  uint32_t lastSeed;              // Seed of the latest frame, to replay it
+  uint16_t remapTable[GLITCH_REMAP_SLOTS]; // Colour lookup of the frame being composed
+};
+
+// Empty renderer initializer
+#define GLITCH_RENDERER_INIT {GLITCH_FRAMEBUFFER_INIT, nullptr, 0, 0, 0, {0}}
+
+// Match the back buffer to the source size/format (allocates only on a mismatch)
+bool glitchRendererPrepare(GlitchRenderer *renderer, const GlitchFramebuffer *source);
+
+// Restart the renderer's seed stream
+void glitchRendererSeed(GlitchRenderer *renderer, uint32_t seed);
+
+// Seed of the next frame of the renderer's stream (for composing elsewhere)
+uint32_t glitchRendererNextSeed(GlitchRenderer *renderer);
+
+// Reset the back buffer from the source with one bulk copy, then apply the next frame
+// of the renderer's effect chain. Returns the composed frame, or nullptr if nothing to draw.
+const GlitchFramebuffer *glitchRendererCompose(GlitchRenderer *renderer, const GlitchFramebuffer *source);
+
+// Compose frame `seed` of an effect chain into any framebuffer (e.g. a pipeline slot),
+// using the renderer's colour lookup. `target` is reallocated only when it does not match
+// the source. The same source, chain and seed always give the same pixels. Returns false
+// if there is nothing to draw.
+bool glitchCompose(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *source,
+                   const GlitchEffectChain *chain, uint32_t seed);
+
+// One box shift with explicit parameters, the kernel behind GLITCH_BOX_SHIFT: the box
+// (boxX, boxY, boxW, boxH) of `target`, wrapping at the edges, takes channel `channel`
+// (0=R, 1=G, 2=B, -1 = all) of `source` read (offsetX, offsetY) away. `target` must have
+// been composed from `source` (glitchCompose with an empty chain resets it). Boxes are at
+// most the image size; coordinates and offsets may be any value.
+void glitchShiftBox(GlitchRenderer *renderer, GlitchFramebuffer *target, const GlitchFramebuffer *source,
+                    int16_t boxX, int16_t boxY, int16_t boxW, int16_t boxH, int16_t offsetX, int16_t offsetY,
+                    int channel);
+
+// Release the back buffer
+void freeGlitchRenderer(GlitchRenderer *renderer);
+
+#endif
@@ -0,0 +1,202 @@
+#include "image_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void *mallocAlloc(void *, size_t size)
+{
+  return malloc(size);
+}
+
+static void mallocFree(void *, void *ptr)
+{
+  free(ptr);
+}
+
+// Evict the least recently used image that is not pinned. Returns false if none.
+static bool evictOne(ImageCache *cache)
+{
+  int victim = -1;
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    ImageCacheSlot &slot = cache->slots[i];
+    if (slot.index < 0 || i == cache->currentSlot || i == cache->fillSlot)
+      continue;
+    if (victim < 0 || slot.lastUse < cache->slots[victim].lastUse)
+      victim = i;
+  }
+  if (victim < 0)
+    return false;
+
+  freeFramebuffer(&cache->slots[victim].fb);
+  cache->slots[victim].index = -1;
+  cache->evictions++;
+  return true;
+}
+
+// Budgeted allocation: make room by evicting, then take the bytes from the backing allocator
+static void *budgetAlloc(void *ctx, size_t size)
+{
+  ImageCache *cache = (ImageCache *)ctx;
+  if (size > cache->budget)
+    return nullptr;
+
+  while (cache->used + size > cache->budget)
+  {
+    if (!evictOne(cache))
+      return nullptr;
+  }
+
+  // The backing heap can still be too fragmented or full; keep evicting until it fits
+  for (;;)
+  {
+    void *ptr = cache->backing.alloc(cache->backing.ctx, size);
+    if (ptr)
+    {
+      cache->used += size;
+      return ptr;
+    }
+    if (!evictOne(cache))
+      return nullptr;
+  }
+}
+
+static void budgetFree(void *ctx, void *ptr)
+{
+  ImageCache *cache = (ImageCache *)ctx;
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    const GlitchFramebuffer &fb = cache->slots[i].fb;
+    if (fb.allocated && fb.data == ptr)
+    {
+      cache->used -= framebufferSize(&fb);
+      break;
+    }
+  }
+  cache->backing.free(cache->backing.ctx, ptr);
+}
+
+void imageCacheInit(ImageCache *cache, size_t budget, const FramebufferAllocator *backing,
+                    ImageDecodeFn decode, void *decodeCtx, ImageCacheClockFn clock)
+{
+  memset(cache, 0, sizeof(*cache));
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    cache->slots[i].fb = GLITCH_FRAMEBUFFER_INIT;
+    cache->slots[i].index = -1;
+  }
+
+  cache->allocator = {budgetAlloc, budgetFree, cache};
+  if (backing)
+    cache->backing = *backing;
+  else
+    cache->backing = {mallocAlloc, mallocFree, nullptr};
+
+  cache->budget = budget;
+  cache->currentSlot = -1;
+  cache->fillSlot = -1;
+  cache->decode = decode;
+  cache->decodeCtx = decodeCtx;
+  cache->clock = clock;
+}
+
+static int findSlot(const ImageCache *cache, int index)
+{
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    if (cache->slots[i].index == index)
+      return i;
+  }
+  return -1;
+}
+
+bool imageCacheContains(const ImageCache *cache, int index)
+{
+  return findSlot(cache, index) >= 0;
+}
+
+ImageCacheStats imageCacheStats(const ImageCache *cache, int index)
+{
+  ImageCacheStats stats;
+  stats.hits = cache->hits;
+  stats.misses = cache->misses;
+  stats.prefetches = cache->prefetches;
+  stats.evictions = cache->evictions;
+  stats.decodeUs = index >= 0 && index < IMAGE_CACHE_MAX_IMAGES ? cache->decodeUs[index] : 0;
+  return stats;
+}
+
+// Decode image `index` into a free (or freed) slot. Returns the slot or -1.
+static int decodeIntoSlot(ImageCache *cache, int index)
+{
+  int target = findSlot(cache, -1);
+  if (target < 0)
+  {
+    if (!evictOne(cache))
+      return -1;
+    target = findSlot(cache, -1);
+  }
+
+  ImageCacheSlot &slot = cache->slots[target];
+  slot.fb = GLITCH_FRAMEBUFFER_INIT;
+  slot.fb.allocator = &cache->allocator;
+
+  cache->fillSlot = target;
+  uint32_t start = cache->clock ? cache->clock() : 0;
+  bool ok = cache->decode(cache->decodeCtx, index, &slot.fb);
+  if (cache->clock && index >= 0 && index < IMAGE_CACHE_MAX_IMAGES)
+    cache->decodeUs[index] = cache->clock() - start;
+  cache->fillSlot = -1;
+
+  if (!ok || !slot.fb.allocated)
+  {
+    freeFramebuffer(&slot.fb);
+    cache->decodeFailures++;
+    return -1;
+  }
+
+  slot.index = index;
+  slot.lastUse = ++cache->useCounter;
+  return target;
+}
+
+const GlitchFramebuffer *imageCacheGet(ImageCache *cache, int index)
+{
+  int found = findSlot(cache, index);
+  if (found >= 0)
+  {
+    cache->hits++;
+  }
+  else
+  {
+    // The caller is moving on from the previous image, so it may be evicted to make room
+    cache->misses++;
+    cache->currentSlot = -1;
+    found = decodeIntoSlot(cache, index);
+    if (found < 0)
+      return nullptr;
+  }
+
+  cache->slots[found].lastUse = ++cache->useCounter;
+  cache->currentSlot = found;
+  return &cache->slots[found].fb;
+}
+
+bool imageCachePrefetch(ImageCache *cache, int index)
+{
+  if (findSlot(cache, index) >= 0)
+    return true;
+
+  cache->prefetches++;
+  return decodeIntoSlot(cache, index) >= 0;
+}
+
+void imageCacheClear(ImageCache *cache)
+{
+  for (int i = 0; i < IMAGE_CACHE_SLOTS; i++)
+  {
+    freeFramebuffer(&cache->slots[i].fb);
+    cache->slots[i].index = -1;
+  }
+  cache->currentSlot = -1;
+}
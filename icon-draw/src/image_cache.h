@@ -0,0 +1,84 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "framebuffer.h"
+
+#define IMAGE_CACHE_SLOTS 16      // Decoded images held at most
+#define IMAGE_CACHE_MAX_IMAGES 64 // Image indices tracked for decode-time telemetry
+
+// Decode image `index` into `fb` (allocating through allocateFramebuffer)
+typedef bool (*ImageDecodeFn)(void *ctx, int index, GlitchFramebuffer *fb);
+
+// Microsecond clock for decode timing
+typedef uint32_t (*ImageCacheClockFn)();
+
+struct ImageCacheSlot
+{
+  GlitchFramebuffer fb;
+  int index;        // Image held, -1 = empty
+  uint32_t lastUse; // LRU stamp
+};
+
+// Cache of decoded images with a byte budget and LRU eviction. Pixel blocks come from
+// `backing` (PSRAM on the ESP32); when an allocation would exceed the budget, or the
+// backing allocator fails, least recently used images are evicted first. The image last
+// returned by imageCacheGet() is not evicted by prefetches, so callers can keep drawing
+// from it while the next one decodes.
+struct ImageCache
+{
+  ImageCacheSlot slots[IMAGE_CACHE_SLOTS];
+  FramebufferAllocator allocator; // Budgeted allocator handed to the decoder
+  FramebufferAllocator backing;   // Where the bytes really come from
+  size_t budget;
+  size_t used;
+  int currentSlot; // Slot last returned by imageCacheGet (pinned)
+  int fillSlot;    // Slot being decoded into (pinned)
+  uint32_t useCounter;
+
+  ImageDecodeFn decode;
+  void *decodeCtx;
+  ImageCacheClockFn clock;
+
+  // Telemetry
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t prefetches;
+  uint32_t evictions;
+  uint32_t decodeFailures;
+  uint32_t decodeUs[IMAGE_CACHE_MAX_IMAGES]; // Last decode time per image index
+};
+
+// Telemetry copied out by the side that owns the cache, for another core to print
+struct ImageCacheStats
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t prefetches;
+  uint32_t evictions;
+  uint32_t decodeUs; // Of the image asked about
+};
+
+// Set up an empty cache. `backing` may be nullptr for malloc/free; `clock` may be nullptr
+// to skip decode timing.
+void imageCacheInit(ImageCache *cache, size_t budget, const FramebufferAllocator *backing,
+                    ImageDecodeFn decode, void *decodeCtx, ImageCacheClockFn clock);
+
+// Return image `index`, decoding it on a miss. The result stays valid until a later
+// imageCacheGet() for a different image lets it be evicted. nullptr if decoding failed.
+const GlitchFramebuffer *imageCacheGet(ImageCache *cache, int index);
+
+// Decode image `index` ahead of time if it is not cached (counts neither hit nor miss)
+bool imageCachePrefetch(ImageCache *cache, int index);
+
+// Whether image `index` is currently cached
+bool imageCacheContains(const ImageCache *cache, int index);
+
+// Counters since init, and the last decode time of image `index`
+ImageCacheStats imageCacheStats(const ImageCache *cache, int index);
+
+// Drop every cached image
+void imageCacheClear(ImageCache *cache);
+
+#endif
@@ -2,6 +2,18 @@
 #include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
 #include <LittleFS.h>
 #include "bmp_handler.h"
+#include "asset_archive.h"
+#include "image_cache.h"
+#include "frame_pipeline.h"
+#include "crossfade.h"
+#include "slideshow.h"
+#include "boot_storage.h"
+#include <esp_heap_caps.h>
+#include <frame_scheduler.h>
+#include <frame_profiler.h>
+#include <frame_stream.h>
+#include <boot_trace.h>
+#include <color_depth.h>
 // #include "ota_handler.h"  // Disabled for now
 
 /*--------------------- DEBUG  -------------------------*/
@@ -31,7 +43,91 @@
 #define PANEL_RES_Y 64 // Number of pixels tall of each INDIVIDUAL panel module.
 #define PANEL_CHAIN 1  // Total number of panels chained one to another
 
+// How the chained panels form the wall (see virtual_canvas.h)
+#define PANEL_COLUMNS PANEL_CHAIN // Panels across; PANEL_CHAIN / PANEL_COLUMNS rows
+#define PANEL_SERPENTINE false    // true if odd rows are cabled right to left, mounted upside down
+#define PANEL_ROTATION 3          // Quarter turns of each panel's content: 3 = 90 degrees counter-clockwise
+
+#define PANEL_BRIGHTNESS 255 // 0-255; fades are done in the pixels
+
+// Colour depth and clock (see color_depth.h). The content is the levels the icons use
+// (recorded in the icon archive, see contentLevelsFrom), so the controller picks the fewest
+// planes that keep them apart and the slowest clock that still refreshes this fast. The
+// ceiling is also the safe default, used when there is no archive to read the levels from.
+#define MIN_REFRESH_HZ 60
+ColorDepthProfile depthProfile = {COLOR_DEPTH_MIN_BITS, 8, MIN_REFRESH_HZ, HUB75_I2S_CFG::HZ_10M};
+
+/*--------------------- TRANSITIONS -------------------------*/
+#ifndef CROSSFADE_TRANSITIONS
+#define CROSSFADE_TRANSITIONS 1 // 1 = crossfade straight into the next image; 0 = fade through black
+#endif
+
+// Timing constants (in milliseconds)
+const unsigned long SHOWING_TIME = 100; // Hold image for 2 seconds
+const unsigned long FADE_TIME = 10;     // Fade to black for 0.5 seconds
+
+/*--------------------- GLITCH -------------------------*/
+// Effects applied to every frame, in order (see glitch_renderer.h). Chances are out of 256.
+const GlitchEffect iconEffects[] = {
+    {GLITCH_CHROMA_SPLIT, 1, 32},         // 1 frame in 8
+    {GLITCH_BOX_SHIFT, 4, GLITCH_ALWAYS}, // The original four boxes
+    {GLITCH_SCANLINE_TEAR, 1, 24},
+    {GLITCH_PIXEL_SORT, 1, 16}};
+const GlitchEffectChain iconGlitchChain = {iconEffects, sizeof(iconEffects) / sizeof(iconEffects[0])};
+
+/*--------------------- ANIMATIONS -------------------------*/
+// Animations from scripts/pack_icons.py --anim, shown in the rotation alongside the
+// images when they are on LittleFS. They play without glitches, and once one is up each
+// frame only presents the spans that changed.
+const char *animationFiles[] = {"/anim0.ica"};
+const int numAnimations = sizeof(animationFiles) / sizeof(animationFiles[0]);
+
+/*--------------------- BOOT -------------------------*/
+// 1 = mount LittleFS, map the archive and decode the first image on PRODUCER_CORE while
+// this core starts the display, with no fixed delays; 0 = the original one-step-at-a-time
+// boot. Either way the boot phases are traced and printed with the first frame.
+#ifndef FAST_BOOT
+#define FAST_BOOT 1
+#endif
+
+/*--------------------- SERIAL -------------------------*/
+#define SERIAL_BAUD 921600 // Debug output and streamed frames share the port
+
+// Frames streamed from a host (scripts/stream_frames.py, see frame_stream.h) take over
+// the panel while they keep coming; the rotation resumes STREAM_TIMEOUT_MS after the last.
+#ifndef SERIAL_STREAM
+#define SERIAL_STREAM 1
+#endif
+#define STREAM_RX_BUFFER 8192  // UART driver ring buffer: absorbs input while both packet buffers are busy
+#define STREAM_READ_CHUNK 256  // Bytes taken from the driver per read in the receive callback
+#define STREAM_TIMEOUT_MS 2000
+
+/*--------------------- IMAGE CACHE -------------------------*/
+#define IMAGE_CACHE_BUDGET_PSRAM (1024 * 1024) // Decoded images kept in PSRAM (~12KB each)
+#define IMAGE_CACHE_BUDGET_INTERNAL (48 * 1024) // Budget when no PSRAM is found
+
+/*--------------------- FRAME PACING -------------------------*/
+#define TARGET_FPS 60 // Frames start on fixed 1/60 s deadlines
+
+/*--------------------- RENDER PIPELINE -------------------------*/
+#ifndef PIPELINED_RENDER
+#define PIPELINED_RENDER 1       // 1 = decode/compose on PRODUCER_CORE, present in loop(); 0 = all in loop()
+#endif
+#define PRODUCER_CORE 0          // loop() runs on core 1
+#define PRODUCER_STACK_SIZE 8192 // BMP decoding keeps a 2KB chunk on the stack
+
 MatrixPanel_I2S_DMA *dma_display = nullptr;
+FrameScheduler frameScheduler;
+
+// The wall as one drawing surface, with a dirty bit per panel. Icons are centred on it.
+VirtualCanvas canvas = VIRTUAL_CANVAS_INIT;
+
+// Canvas area the last presented frame covers (empty after a blank frame)
+CanvasRect shownRect = {0, 0, 0, 0};
+
+// Packed icons mapped from the "assets" partition (see scripts/pack_icons.py).
+// When it is missing the BMPs in imageFiles[] are decoded from LittleFS instead.
+AssetArchive iconArchive = {};
 
 /*
 //Another way of creating config structure
@@ -51,8 +147,201 @@ HUB75_I2S_CFG mxconfig(
 // mxconfig.clkphase = false; // Change this if you have issues with ghosting.
 // mxconfig.driver = HUB75_I2S_CFG::FM6126A; // Change this according to your pane.
 
+// Array of image filenames in alphabetical order (.bmp, or .qoi from pack_icons.py --qoi-dir)
+const char *imageFiles[] = {
+    "/i0.bmp",
+    "/i01.bmp",
+    "/i10.bmp",
+    "/i10a.bmp",
+    "/i11.bmp",
+    "/i12.bmp",
+    "/i13.bmp",
+    "/i14.bmp",
+    "/i15.bmp",
+    "/i16.bmp",
+    "/i2.bmp",
+    "/i3.bmp",
+    "/i4.bmp",
+    "/i5.bmp",
+    "/i9.bmp",
+    "/i9b.bmp"};
+const int numImages = 16;
+
+// Number of images available
+int imageCount()
+{
+  return iconArchive.open ? assetArchiveCount(&iconArchive) : numImages;
+}
+
+// Streaming player for the animation on screen, and the file it reads from
+AnimPlayer animPlayer = {};
+File animFile;
+int openAnimationIndex = -1;
+
+// Load image `index` into the framebuffer, from the archive when present.
+// Used as the image cache's decoder.
+bool loadImage(void *, int index, GlitchFramebuffer *fb)
+{
+  PROFILE_SCOPE(PROFILE_LOAD);
+  if (!iconArchive.open)
+  {
+    const char *filename = imageFiles[index];
+    Sprint("Loading image: ");
+    Sprintln(filename);
+    // .qoi files (scripts/pack_icons.py --qoi-dir) are a fraction of the BMP size
+    size_t length = strlen(filename);
+    if (length > 4 && strcmp(filename + length - 4, ".qoi") == 0)
+      return loadQOIToFramebuffer(filename, fb);
+    // Palettized BMPs stay indexed (1 byte per pixel or less); 24-bit ones load as planar
+    return loadBMPToFramebuffer(filename, fb, FB_INDEXED8);
+  }
+
+  Sprint("Loading packed image: ");
+  Sprintln(assetArchiveEntry(&iconArchive, index)->name);
+  if (!assetArchiveLoad(&iconArchive, index, fb, true))
+  {
+    Sprintln("Packed image failed checksum");
+    return false;
+  }
+  return true;
+}
+
+// Cached pixel blocks go to PSRAM when the board has it
+void *cacheAlloc(void *, size_t size)
+{
+  return psramFound() ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : malloc(size);
+}
+
+void cacheFree(void *, void *ptr)
+{
+  heap_caps_free(ptr);
+}
+
+uint32_t cacheClock()
+{
+  return micros();
+}
+
+const FramebufferAllocator cacheBacking = {cacheAlloc, cacheFree, nullptr};
+
+// Decoded images, LRU-evicted within a byte budget; the next image is decoded ahead
+ImageCache imageCache;
+
+// Images and animations to pick from (the slideshow's media hooks)
+int mediaImageCount(void *)
+{
+  return imageCount();
+}
+
+// When each step of setup() ran, up to the first frame ('t' over Serial prints it again)
+BootTrace bootTrace = {};
+
+// The archive, LittleFS and the animations found on it; they follow the images in the rotation
+BootStorage bootStorage = {&bootTrace, &iconArchive, animationFiles, numAnimations, &imageCache, mediaImageCount,
+                           nullptr, {}, 0, {false}, false};
+
+int mediaCount(void *)
+{
+  return imageCount() + bootStorage.animationCount;
+}
+
+// Decode the first frame of animation `index` (a mediaCount() index), opening its file
+// unless it is the one already open. Returns its frame, or nullptr on failure.
+const GlitchFramebuffer *startAnimation(void *, int index)
+{
+  PROFILE_SCOPE(PROFILE_LOAD);
+  if (index != openAnimationIndex)
+  {
+    if (openAnimationIndex >= 0)
+      animFile.close();
+    openAnimationIndex = -1;
+    if (!openAnimation(bootStorage.animations[index - imageCount()], &animFile, &animPlayer))
+      return nullptr;
+    openAnimationIndex = index;
+  }
+  else if (animPlayerRewind(&animPlayer) != ANIM_OK)
+  {
+    return nullptr;
+  }
+
+  AnimStatus status = animPlayerNextFrame(&animPlayer);
+  if (status != ANIM_OK)
+  {
+    Sprintln(animStatusString(status));
+    return nullptr;
+  }
+  return &animPlayer.frame;
+}
+
+// Glitch compositor; keeps its back buffer across images and frames. Also the seed stream
+// every frame's glitch is drawn from (in pipelined mode only that is used).
+GlitchRenderer glitchRenderer = GLITCH_RENDERER_INIT;
+
+// Frames in flight between the producer task and loop() (pipelined mode)
+FramePipeline framePipeline;
+
+// The rotation: stepped and composed in loop(), or by the producer task when pipelined
+Slideshow slideshow;
+const SlideshowConfig slideshowConfig = {
+    {mediaImageCount, mediaCount, startAnimation, nullptr}, &imageCache, &animPlayer, &glitchRenderer,
+    &framePipeline, SHOWING_TIME, FADE_TIME, CROSSFADE_TRANSITIONS};
+
+#if SERIAL_STREAM
+// Packets from the host: parsed and CRC-checked by the UART event task, applied and
+// presented by loop() while the next one arrives
+StreamReceiver streamReceiver;
+bool streamEnabled = false; // Receive buffers allocated and the callback installed
+
+// Picture the host is driving (RGB565), sized by its last full frame
+GlitchFramebuffer streamFrame = GLITCH_FRAMEBUFFER_INIT;
+bool streamLive = false; // A host is driving the panel: the rotation waits
+unsigned long lastPacketTime = 0;
+
+// Command bytes that arrived between packets, from the UART event task to loop()
+#define COMMAND_QUEUE_SIZE 16 // Power of two
+uint8_t commandQueue[COMMAND_QUEUE_SIZE];
+std::atomic<uint32_t> commandHead(0); // Written by loop()
+std::atomic<uint32_t> commandTail(0); // Written by the UART event task
+
+void queueCommand(void *, uint8_t byte)
+{
+  uint32_t tail = commandTail.load(std::memory_order_relaxed);
+  if (tail - commandHead.load(std::memory_order_acquire) == COMMAND_QUEUE_SIZE)
+    return; // Full: commands are single keypresses, so dropping one is harmless
+  commandQueue[tail % COMMAND_QUEUE_SIZE] = byte;
+  commandTail.store(tail + 1, std::memory_order_release);
+}
+
+// Serial.onReceive() callback, run by the UART driver's event task whenever its queue
+// reports data. Everything buffered is parsed here; if both packet buffers are still
+// waiting for loop() the rest stays in hand until one is released.
+void serialReceive()
+{
+  uint8_t chunk[STREAM_READ_CHUNK];
+  size_t length;
+  while ((length = Serial.read(chunk, sizeof(chunk))) > 0)
+  {
+    size_t done = streamReceive(&streamReceiver, chunk, length);
+    while (done < length)
+    {
+      vTaskDelay(1);
+      done += streamReceive(&streamReceiver, chunk + done, length - done);
+    }
+  }
+}
+#endif
+
+// Channel levels the panel will show, for the colour depth: the rotation's over the levels
+// scripts/pack_icons.py recorded for the archive's icons (see slideshowContentLevels).
+// BMPs on LittleFS could only be scanned once it is mounted, which can take a format, so
+// without an archive every level counts and the panel runs at the profile's ceiling.
+// Animations stream from LittleFS after the display is up, so they are shown at the
+// icons' depth.
+ColorLevels contentLevels = COLOR_LEVELS_INIT;
+
 void setup()
 {
+  uint8_t setupPhase = bootPhaseBegin(&bootTrace, "setup");
 
   // Module configuration
   HUB75_I2S_CFG mxconfig(
@@ -65,18 +354,36 @@ void setup()
   mxconfig.clkphase = false;
 
   // put your setup code here, to run once:
+  uint8_t phase = bootPhaseBegin(&bootTrace, "serial");
+#if !FAST_BOOT
   delay(1000);
-  Serial.begin(115200);
+#endif
+#if SERIAL_STREAM
+  Serial.setRxBufferSize(STREAM_RX_BUFFER); // Only takes effect before begin()
+#endif
+  Serial.begin(SERIAL_BAUD); // The UART is ready as soon as begin() returns
+#if !FAST_BOOT
   delay(200);
+#endif
+  bootPhaseEnd(&bootTrace, phase);
 
-  /************** LITTLEFS **************/
-  Sprintln("...Mounting LittleFS");
-  if (!LittleFS.begin(true))
-  {
-    Sprintln("LittleFS Mount Failed");
+  // The first image is decoded into the cache during boot
+  animPlayer.frame.allocator = &cacheBacking; // Animation frames go to PSRAM too
+  imageCacheInit(&imageCache, psramFound() ? IMAGE_CACHE_BUDGET_PSRAM : IMAGE_CACHE_BUDGET_INTERNAL,
+                 &cacheBacking, loadImage, nullptr, cacheClock);
+  slideshowInit(&slideshow, &slideshowConfig);
+
+  // The depth has to be set before begin(), and it comes from the archive
+  bootStorageMapArchive(&bootStorage);
+  slideshowContentLevels(&slideshowConfig, iconArchive.open ? iconArchive.header->levels : nullptr, &contentLevels);
+
+#if FAST_BOOT
+  // Storage, then the image the rotation opens with, on PRODUCER_CORE while the display starts
+  xTaskCreatePinnedToCore(bootStorageTask, "storage", PRODUCER_STACK_SIZE, &bootStorage, 1, nullptr, PRODUCER_CORE);
+#else
+  if (!bootStorageMount(&bootStorage))
     return;
-  }
-  Sprintln("LittleFS Mounted Successfully");
+#endif
 
   // /************** WIFI & OTA **************/
   // if (setupWiFi())
@@ -85,144 +392,366 @@ void setup()
   // }
 
   /************** SHOWING **************/
+  ColorDepthPanel depthPanel = {PANEL_RES_X, PANEL_RES_Y, PANEL_CHAIN, 1, true};
+  ColorDepthTiming depth = colorDepthChoose(&contentLevels, &depthProfile, &depthPanel);
+  mxconfig.i2sspeed = (HUB75_I2S_CFG::clk_speed)depth.i2sHz;
+  mxconfig.min_refresh_rate = MIN_REFRESH_HZ;
+
+  phase = bootPhaseBegin(&bootTrace, "display");
   Sprintln("...Starting Display");
   dma_display = new MatrixPanel_I2S_DMA(mxconfig);
-  dma_display->begin();
-  dma_display->setBrightness8(128); // 0-255
+  dma_display->setPixelColorDepthBits(depth.bits); // Before begin(), which sizes the DMA buffers
+  dma_display->begin(); // Also sends the FM6126A its configuration; the panel is ready when it returns
+  dma_display->setBrightness8(PANEL_BRIGHTNESS);
   dma_display->clearScreen();
-  dma_display->setRotation(3); // 90 degrees counter-clockwise
+  bootPhaseEnd(&bootTrace, phase);
+
+  Sprint("Colour depth: ");
+  Sprint(colorLevelsCount(&contentLevels));
+  Sprint(" levels -> ");
+  Sprint(depth.bits);
+  Sprint(" bits, I2S ");
+  Sprint(depth.i2sHz / 1000000);
+  Sprint(" MHz, refresh ");
+  Sprint(depth.refreshHz);
+  Sprint(" Hz, DMA ");
+  Sprint(depth.dmaBytes);
+  Sprintln(" bytes");
+
+  // Rotation is per panel on the canvas; the display itself stays unrotated
+  canvasInitGrid(&canvas, PANEL_RES_X, PANEL_RES_Y, PANEL_COLUMNS, PANEL_CHAIN / PANEL_COLUMNS, PANEL_ROTATION,
+                 PANEL_SERPENTINE);
+  canvasClearDirty(&canvas); // Just cleared
+
+#if SERIAL_STREAM
+  // Streamed frames can be up to the size of the canvas
+  streamEnabled = streamReceiverInit(&streamReceiver, (uint32_t)canvas.width * canvas.height * 2, queueCommand, nullptr);
+  if (streamEnabled)
+    Serial.onReceive(serialReceive);
+  else
+    Sprintln("Stream buffer allocation failed");
+#endif
+
+  frameSchedulerInit(&frameScheduler, TARGET_FPS);
+
+  // A fresh glitch stream each boot; any frame of it can be replayed from this seed
+  glitchRenderer.chain = &iconGlitchChain;
+  glitchRendererSeed(&glitchRenderer, (uint32_t)random(INT32_MAX));
+  Sprint("Glitch seed: ");
+  SprintlnDEC(glitchRenderer.seed, HEX);
+
+#if FAST_BOOT
+  // Ready when the storage task is: nothing touches the cache or the files before that
+  phase = bootPhaseBegin(&bootTrace, "wait storage");
+  while (!bootStorage.ready.load(std::memory_order_acquire))
+    vTaskDelay(1);
+  bootPhaseEnd(&bootTrace, phase);
+  if (!bootStorage.mounted)
+    return;
+#endif
+
+#if PIPELINED_RENDER
+  // Decode and compose on the other core; loop() keeps presenting on this one
+  framePipelineInit(&framePipeline);
+  xTaskCreatePinnedToCore(slideshowProducerTask, "producer", PRODUCER_STACK_SIZE, &slideshow, 1, nullptr,
+                          PRODUCER_CORE);
+#endif
+  bootPhaseEnd(&bootTrace, setupPhase);
 }
 
-// Enum for animation state machine
-enum AnimState
+// Cache activity since boot, and the decode time of the image that just finished.
+// Printed by whoever presents, from a copy taken where the cache lives.
+void printCacheStats(const ImageCacheStats *stats)
 {
-  FADE_IN,
-  SHOWING,
-  FADE_OUT,
-  BLACK
-};
+  Sprint("Cache hits: ");
+  Sprint(stats->hits);
+  Sprint(" misses: ");
+  Sprint(stats->misses);
+  Sprint(" prefetches: ");
+  Sprint(stats->prefetches);
+  Sprint(" evictions: ");
+  Sprint(stats->evictions);
+  Sprint(" decode us: ");
+  Sprintln(stats->decodeUs);
+}
 
-// Array of BMP filenames in alphabetical order
-const char *imageFiles[] = {
-    "/i0.bmp",
-    "/i01.bmp",
-    "/i10.bmp",
-    "/i10a.bmp",
-    "/i11.bmp",
-    "/i12.bmp",
-    "/i13.bmp",
-    "/i14.bmp",
-    "/i15.bmp",
-    "/i16.bmp",
-    "/i2.bmp",
-    "/i3.bmp",
-    "/i4.bmp",
-    "/i5.bmp",
-    "/i9.bmp",
-    "/i9b.bmp"};
-const int numImages = 16;
+// Profiler reports and the boot trace go straight out of the serial port
+void serialWrite(void *, const uint8_t *data, size_t length)
+{
+  Serial.write(data, length);
+}
 
-// Framebuffer for glitch effects
-GlitchFramebuffer framebuffer = {nullptr, nullptr, nullptr, 0, 0, false};
+// The first frame reached the panel: close the boot trace and print it
+void noteFirstFrame()
+{
+  static bool shown = false;
+  if (shown)
+    return;
+  shown = true;
+  bootTraceMark(&bootTrace, "first frame");
+  bootTracePrint(&bootTrace, serialWrite, nullptr);
+}
 
-void loop()
+// Black out what the last frame covered (the gap between images). Only its panels are
+// touched, so on a wall this costs the size of the icon, not of the wall.
+void clearShownFrame()
 {
-  // // Handle OTA updates
-  // handleOTA();
+  canvasMarkDirty(&canvas, &shownRect);
+  canvasFillRect(&canvas, dma_display, &shownRect, 0, canvas.dirty);
+  canvasClearDirty(&canvas);
+  shownRect = {0, 0, 0, 0};
+}
 
-  // State machine for fading between images
-  static int currentImage = 0;
-  static unsigned long lastTransitionTime = 0;
-  static AnimState state = FADE_IN;
-  static bool imageLoaded = false;
+// Present a frame centred on the canvas. Its area is marked dirty and only the panels
+// under it are written; if the last frame covered a different area that is cleared first.
+void presentFrame(const GlitchFramebuffer *fb)
+{
+  CanvasRect rect = {(int16_t)((canvas.width - fb->width) / 2), (int16_t)((canvas.height - fb->height) / 2),
+                     fb->width, fb->height};
+  if (rect.x != shownRect.x || rect.y != shownRect.y || rect.w != shownRect.w || rect.h != shownRect.h)
+    clearShownFrame();
 
-  // Timing constants (in milliseconds)
-  const unsigned long SHOWING_TIME = 100; // Hold image for 2 seconds
-  const unsigned long FADE_TIME = 10;     // Fade to black for 0.5 seconds
+  canvasMarkDirty(&canvas, &rect);
+  presentFramebuffer(dma_display, &canvas, fb, rect.x, rect.y, canvas.dirty);
+  canvasClearDirty(&canvas);
+  shownRect = rect;
+  noteFirstFrame();
+}
 
-  unsigned long currentTime = millis();
-  unsigned long elapsedTime = currentTime - lastTransitionTime;
+// Present only what changed in a frame already on screen at the same place; anything
+// else is presented whole
+void presentFrameChanges(const GlitchFramebuffer *fb, const AnimSpanList *changed)
+{
+  CanvasRect rect = {(int16_t)((canvas.width - fb->width) / 2), (int16_t)((canvas.height - fb->height) / 2),
+                     fb->width, fb->height};
+  if (rect.x != shownRect.x || rect.y != shownRect.y || rect.w != shownRect.w || rect.h != shownRect.h)
+  {
+    presentFrame(fb);
+    return;
+  }
+  presentFramebufferSpans(dma_display, &canvas, fb, changed, rect.x, rect.y);
+}
 
-  switch (state)
+#if SERIAL_STREAM
+// Apply a packet to the streamed frame. A full frame (re)sizes it and starts live mode;
+// rectangles arriving before one are dropped. Returns false if nothing was applied.
+bool applyStreamPacket(const StreamPacket *packet)
+{
+  if (packet->type == STREAM_FULL &&
+      (!streamFrame.allocated || streamFrame.width != packet->w || streamFrame.height != packet->h))
   {
-  case FADE_IN:
-    if (!imageLoaded)
-    {
-      // Load the current image into framebuffer
-      Sprint("Loading image: ");
-      Sprintln(imageFiles[currentImage]);
+    if (packet->w > canvas.width || packet->h > canvas.height ||
+        !allocateFramebuffer(&streamFrame, packet->w, packet->h, FB_RGB565))
+      return false;
+  }
+  if (packet->type == STREAM_RECT && !streamLive)
+    return false;
+  return streamApply(packet, (uint16_t *)streamFrame.data, streamFrame.stride / 2, streamFrame.width,
+                     streamFrame.height);
+}
 
-      loadBMPToFramebuffer(imageFiles[currentImage], &framebuffer);
-      imageLoaded = true;
-      lastTransitionTime = currentTime;
-    }
+// Present what an applied packet changed: a full frame like any other frame, a
+// rectangle only as its rows, on top of the frame already shown
+void presentStreamPacket(const StreamPacket *packet)
+{
+  if (packet->type == STREAM_FULL)
+  {
+    presentFrame(&streamFrame);
+    return;
+  }
+  for (uint16_t row = 0; row < packet->h; row++)
+  {
+    const uint16_t *pixels = (const uint16_t *)framebufferRow(&streamFrame, packet->y + row) + packet->x;
+    presentRow565(dma_display, &canvas, pixels, packet->w, shownRect.x + packet->x, shownRect.y + packet->y + row);
+  }
+}
 
-    // Draw glitched frame (new glitch every frame during fade in)
-    drawFramebufferGlitched(dma_display, &framebuffer, 0, 0);
+// Packet counts since boot, printed when a stream ends
+void printStreamStats()
+{
+  Sprint("Stream packets: ");
+  Sprint(streamReceiver.packetsReceived);
+  Sprint(" bytes: ");
+  Sprint(streamReceiver.bytesReceived);
+  Sprint(" crc errors: ");
+  Sprint(streamReceiver.crcErrors);
+  Sprint(" bad: ");
+  Sprint(streamReceiver.badPackets);
+  Sprint(" lost: ");
+  Sprint(streamReceiver.sequenceGaps);
+  Sprint(" receive stalls: ");
+  Sprintln(streamReceiver.stalls);
+}
+#endif
 
-    // Fade in from black (0 -> 255) with easing
-    if (elapsedTime < FADE_TIME)
-    {
-      float progress = (float)elapsedTime / FADE_TIME;
-      // Ease-in: slower start, faster end
-      progress = progress * progress;
-      uint8_t brightness = (uint8_t)(progress * 255);
-      dma_display->setBrightness8(brightness);
-    }
-    else
-    {
-      dma_display->setBrightness8(255);
-      state = SHOWING;
-      lastTransitionTime = currentTime;
-    }
-    break;
+// Present every packet a host has streamed since the last frame. Returns true while a
+// host is driving the panel, which pauses the rotation.
+bool presentStream()
+{
+#if SERIAL_STREAM
+  if (!streamEnabled)
+    return false;
+
+  const StreamPacket *packet;
+  while ((packet = streamTake(&streamReceiver)))
+  {
+    StreamPacket applied = *packet;
+    bool ok = applyStreamPacket(packet);
+    // The receiver can fill this buffer again while the frame is being presented
+    streamRelease(&streamReceiver);
+    if (!ok)
+      continue;
+
+    if (!streamLive)
+      Sprintln("Stream started");
+    streamLive = true;
+    lastPacketTime = millis();
+    presentStreamPacket(&applied);
+  }
+
+  if (streamLive && millis() - lastPacketTime > STREAM_TIMEOUT_MS)
+  {
+    streamLive = false;
+    clearShownFrame();
+    printStreamStats();
+  }
+  return streamLive;
+#else
+  return false;
+#endif
+}
 
-  case SHOWING:
-    // Draw glitched frame every frame (animated glitch effect!)
-    drawFramebufferGlitched(dma_display, &framebuffer, 0, 0);
+// One command byte: 't' boot trace, the rest go to the profiler
+void handleCommand(uint8_t command)
+{
+  if (command == 't')
+    bootTracePrint(&bootTrace, serialWrite, nullptr);
+  else
+    profilerHandleCommand(command, serialWrite, nullptr);
+}
 
-    // Hold at full brightness
-    if (elapsedTime >= SHOWING_TIME)
+// Serial commands: 'p' profiler report as CSV, 'b' binary report, 'r' reset, 't' boot
+// trace. With streaming on they come through the receive callback, from between packets.
+void handleSerialCommands()
+{
+#if SERIAL_STREAM
+  if (streamEnabled)
+  {
+    uint32_t head = commandHead.load(std::memory_order_relaxed);
+    for (; head != commandTail.load(std::memory_order_acquire); head++)
     {
-      state = FADE_OUT;
-      lastTransitionTime = currentTime;
+      handleCommand(commandQueue[head % COMMAND_QUEUE_SIZE]);
+      commandHead.store(head + 1, std::memory_order_release);
     }
-    break;
+    return;
+  }
+#endif
+  while (Serial.available())
+    handleCommand(Serial.read());
+}
+
+// Frame timing for the image that just finished
+void printFrameStats()
+{
+  Sprint("Frames: ");
+  Sprint(frameScheduler.stats.frames);
+  Sprint(" dropped: ");
+  Sprint(frameScheduler.stats.droppedFrames);
+  Sprint(" avg us: ");
+  Sprint(frameSchedulerAverageFrameUs(&frameScheduler));
+  Sprint(" max us: ");
+  Sprint(frameScheduler.stats.maxFrameUs);
+  Sprint(" jitter avg/max us: ");
+  Sprint(frameSchedulerAverageJitterUs(&frameScheduler));
+  Sprint("/");
+  Sprintln(frameScheduler.stats.maxJitterUs);
+  frameSchedulerResetStats(&frameScheduler);
 
-  case FADE_OUT:
-    // Draw glitched frame (new glitch every frame during fade out)
-    drawFramebufferGlitched(dma_display, &framebuffer, 0, 0);
+#if PIPELINED_RENDER
+  Sprint("Pipeline produced: ");
+  Sprint(framePipeline.produced.load());
+  Sprint(" presented: ");
+  Sprint(framePipeline.presented.load());
+  Sprint(" producer stalls: ");
+  Sprint(framePipeline.producerStalls.load());
+  Sprint(" consumer starved: ");
+  Sprintln(framePipeline.consumerStarved.load());
+#endif
+}
+
+#if PIPELINED_RENDER
+// Consumer: only presents finished frames. If the producer is late the previous frame
+// simply stays on the panel.
+void loop()
+{
+  // Wait for this frame's absolute deadline (drops slots if the last frame overran)
+  frameSchedulerBeginFrame(&frameScheduler);
 
-    // Fade out to black (255 -> 0) with easing
-    if (elapsedTime < FADE_TIME)
+  {
+    PROFILE_SCOPE(PROFILE_FRAME);
+    // While a host is driving the panel no frames are taken, so the producer stalls
+    PipelineFrame *frame = presentStream() ? nullptr : framePipelineTake(&framePipeline);
+    if (frame)
     {
-      float progress = (float)elapsedTime / FADE_TIME;
-      // Ease-out: faster start, slower end
-      progress = 1.0 - ((1.0 - progress) * (1.0 - progress));
-      uint8_t brightness = (uint8_t)((1.0 - progress) * 255);
-      dma_display->setBrightness8(brightness);
+      if (frame->imageDone)
+      {
+        printCacheStats(&frame->cacheStats);
+        printFrameStats();
+      }
+      if (frame->blank)
+        clearShownFrame();
+      else if (frame->composed && frame->partial)
+        presentFrameChanges(&frame->fb, &frame->changed);
+      else if (frame->composed)
+        presentFrame(&frame->fb);
+      framePipelineRelease(&framePipeline, frame);
     }
-    else
+  }
+
+  frameSchedulerEndFrame(&frameScheduler);
+  PROFILE_FRAME_END();
+  handleSerialCommands();
+}
+#else
+void loop()
+{
+  // // Handle OTA updates
+  // handleOTA();
+
+  // Wait for this frame's absolute deadline (drops slots if the last frame overran)
+  frameSchedulerBeginFrame(&frameScheduler);
+
+  {
+    PROFILE_SCOPE(PROFILE_FRAME);
+    // While a host is driving the panel the rotation waits
+    if (!presentStream())
     {
-      dma_display->setBrightness8(0);
-      state = BLACK;
-      lastTransitionTime = currentTime;
+      SlideshowFrame slide;
+      slideshowStep(&slideshow, &slide);
+      if (slide.imageDone)
+      {
+        printCacheStats(&slide.cacheStats);
+        printFrameStats();
+      }
+      if (slide.blank)
+      {
+        clearShownFrame();
+      }
+      else if (slide.changed)
+      {
+        // Animation frame applied in place: push only what it changed
+        presentFrameChanges(slide.source, slide.changed);
+      }
+      else if (slideshowCompose(&slideshow, &glitchRenderer.back, &slide))
+      {
+        // Draw glitched frame (new glitch every frame)
+        presentFrame(&glitchRenderer.back);
+      }
     }
-    break;
-
-  case BLACK:
-    // Free the current framebuffer
-    freeFramebuffer(&framebuffer);
-
-    // Stay black briefly, then switch to random image
-    dma_display->clearScreen();
-    currentImage = random(0, numImages); // Pick random image
-    imageLoaded = false;
-    state = FADE_IN;
-    lastTransitionTime = currentTime;
-    break;
   }
 
-  // Short delay - 60 FPS (1000ms / 60 = ~16.67ms)
-  delay(16);
+  frameSchedulerEndFrame(&frameScheduler);
+  PROFILE_FRAME_END();
+  handleSerialCommands();
 }
+#endif
@@ -0,0 +1,168 @@
+#include "pixel_convert.h"
+
+#include <math.h>
+
+// The word layouts below assume little-endian byte order (ESP32 and x86/ARM hosts)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Pixel kernels assume a little-endian target");
+
+static inline bool aligned4(const void *p)
+{
+  return ((uintptr_t)p & 3) == 0;
+}
+
+// Four BGR888 pixels in three words (b0 g0 r0 b1 | g1 r1 b2 g2 | r2 b3 g3 r3) to two
+// words of RGB565: each field is shifted from its byte straight into place
+static inline void packBGR4(uint32_t *out, uint32_t w0, uint32_t w1, uint32_t w2)
+{
+  uint32_t p0 = ((w0 >> 8) & 0xF800) | ((w0 >> 5) & 0x07E0) | ((w0 >> 3) & 0x001F);
+  uint32_t p1 = (w1 & 0xF800) | ((w1 << 3) & 0x07E0) | (w0 >> 27);
+  uint32_t p2 = ((w2 << 8) & 0xF800) | ((w1 >> 21) & 0x07E0) | ((w1 >> 19) & 0x001F);
+  uint32_t p3 = ((w2 >> 16) & 0xF800) | ((w2 >> 13) & 0x07E0) | ((w2 >> 11) & 0x001F);
+  out[0] = p0 | (p1 << 16);
+  out[1] = p2 | (p3 << 16);
+}
+
+// Same for RGB888 (r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3)
+static inline void packRGB4(uint32_t *out, uint32_t w0, uint32_t w1, uint32_t w2)
+{
+  uint32_t p0 = ((w0 << 8) & 0xF800) | ((w0 >> 5) & 0x07E0) | ((w0 >> 19) & 0x001F);
+  uint32_t p1 = ((w0 >> 16) & 0xF800) | ((w1 << 3) & 0x07E0) | ((w1 >> 11) & 0x001F);
+  uint32_t p2 = ((w1 >> 8) & 0xF800) | ((w1 >> 21) & 0x07E0) | ((w2 >> 3) & 0x001F);
+  uint32_t p3 = (w2 & 0xF800) | ((w2 >> 13) & 0x07E0) | (w2 >> 27);
+  out[0] = p0 | (p1 << 16);
+  out[1] = p2 | (p3 << 16);
+}
+
+void convertBGR888To565(uint16_t *out, const uint8_t *bgr, int16_t width)
+{
+  int16_t x = 0;
+  if (aligned4(out) && aligned4(bgr))
+  {
+    const uint32_t *in = (const uint32_t *)bgr;
+    for (; x + 4 <= width; x += 4, in += 3)
+      packBGR4((uint32_t *)(out + x), in[0], in[1], in[2]);
+  }
+  for (bgr += x * 3; x < width; x++, bgr += 3)
+    out[x] = rgb565(bgr[2], bgr[1], bgr[0]);
+}
+
+void convertRGB888To565(uint16_t *out, const uint8_t *rgb, int16_t width)
+{
+  int16_t x = 0;
+  if (aligned4(out) && aligned4(rgb))
+  {
+    const uint32_t *in = (const uint32_t *)rgb;
+    for (; x + 4 <= width; x += 4, in += 3)
+      packRGB4((uint32_t *)(out + x), in[0], in[1], in[2]);
+  }
+  for (rgb += x * 3; x < width; x++, rgb += 3)
+    out[x] = rgb565(rgb[0], rgb[1], rgb[2]);
+}
+
+void convertPlanarTo565(uint16_t *out, const uint8_t *r, const uint8_t *g, const uint8_t *b, int16_t width)
+{
+  int16_t x = 0;
+  if (aligned4(out) && aligned4(r) && aligned4(g) && aligned4(b))
+  {
+    for (; x + 4 <= width; x += 4)
+    {
+      uint32_t R = *(const uint32_t *)(r + x);
+      uint32_t G = *(const uint32_t *)(g + x);
+      uint32_t B = *(const uint32_t *)(b + x);
+      // Pixels 0 and 2 from the low byte of each half-word, 1 and 3 from the high byte
+      uint32_t even = ((R & 0x00F800F8) << 8) | ((G & 0x00FC00FC) << 3) | ((B >> 3) & 0x001F001F);
+      uint32_t odd = (R & 0xF800F800) | ((G >> 5) & 0x07E007E0) | ((B >> 11) & 0x001F001F);
+      uint32_t *dst = (uint32_t *)(out + x);
+      dst[0] = (even & 0xFFFF) | (odd << 16);
+      dst[1] = (even >> 16) | (odd & 0xFFFF0000);
+    }
+  }
+  for (; x < width; x++)
+    out[x] = rgb565(r[x], g[x], b[x]);
+}
+
+void swapBGR888(uint8_t *rgb, const uint8_t *bgr, int16_t width)
+{
+  int16_t x = 0;
+  if (aligned4(rgb) && aligned4(bgr))
+  {
+    const uint32_t *in = (const uint32_t *)bgr;
+    uint32_t *dst = (uint32_t *)rgb;
+    for (; x + 4 <= width; x += 4, in += 3, dst += 3)
+    {
+      uint32_t w0 = in[0], w1 = in[1], w2 = in[2];
+      dst[0] = ((w0 >> 16) & 0xFF) | (w0 & 0xFF00) | ((w0 & 0xFF) << 16) | ((w1 & 0xFF00) << 16);
+      dst[1] = (w1 & 0xFF) | ((w0 >> 24) << 8) | ((w2 & 0xFF) << 16) | (w1 & 0xFF000000);
+      dst[2] = ((w1 >> 16) & 0xFF) | ((w2 >> 24) << 8) | (w2 & 0xFF0000) | ((w2 & 0xFF00) << 16);
+    }
+  }
+  for (bgr += x * 3, rgb += x * 3; x < width; x++, bgr += 3, rgb += 3)
+  {
+    rgb[0] = bgr[2];
+    rgb[1] = bgr[1];
+    rgb[2] = bgr[0];
+  }
+}
+
+void splitBGR888(uint8_t *r, uint8_t *g, uint8_t *b, const uint8_t *bgr, int16_t width)
+{
+  int16_t x = 0;
+  if (aligned4(r) && aligned4(g) && aligned4(b) && aligned4(bgr))
+  {
+    const uint32_t *in = (const uint32_t *)bgr;
+    for (; x + 4 <= width; x += 4, in += 3)
+    {
+      uint32_t w0 = in[0], w1 = in[1], w2 = in[2];
+      *(uint32_t *)(r + x) = ((w0 >> 16) & 0xFF) | (w1 & 0xFF00) | ((w2 & 0xFF) << 16) | (w2 & 0xFF000000);
+      *(uint32_t *)(g + x) = ((w0 >> 8) & 0xFF) | ((w1 & 0xFF) << 8) | ((w1 >> 24) << 16) | ((w2 & 0xFF0000) << 8);
+      *(uint32_t *)(b + x) = (w0 & 0xFF) | ((w0 >> 24) << 8) | (w1 & 0xFF0000) | ((w2 & 0xFF00) << 16);
+    }
+  }
+  for (bgr += x * 3; x < width; x++, bgr += 3)
+  {
+    b[x] = bgr[0];
+    g[x] = bgr[1];
+    r[x] = bgr[2];
+  }
+}
+
+void rgb565LutInit(Rgb565Lut *lut, uint8_t brightness, float gamma)
+{
+  for (int i = 0; i < 256; i++)
+  {
+    uint8_t level = (uint8_t)lroundf(powf(i / 255.0f, gamma) * brightness);
+    lut->r[i] = (level & 0xF8) << 8;
+    lut->g[i] = (level & 0xFC) << 3;
+    lut->b[i] = level >> 3;
+  }
+}
+
+void convertBGR888To565Lut(uint16_t *out, const uint8_t *bgr, int16_t width, const Rgb565Lut *lut)
+{
+  int16_t x = 0;
+  if (aligned4(out) && aligned4(bgr))
+  {
+    // Three word loads per four pixels instead of twelve byte loads
+    const uint32_t *in = (const uint32_t *)bgr;
+    for (; x + 4 <= width; x += 4, in += 3)
+    {
+      uint32_t w0 = in[0], w1 = in[1], w2 = in[2];
+      uint32_t *dst = (uint32_t *)(out + x);
+      dst[0] = (lut->r[(w0 >> 16) & 0xFF] | lut->g[(w0 >> 8) & 0xFF] | lut->b[w0 & 0xFF]) |
+               (uint32_t)(lut->r[(w1 >> 8) & 0xFF] | lut->g[w1 & 0xFF] | lut->b[w0 >> 24]) << 16;
+      dst[1] = (lut->r[w2 & 0xFF] | lut->g[w1 >> 24] | lut->b[(w1 >> 16) & 0xFF]) |
+               (uint32_t)(lut->r[w2 >> 24] | lut->g[(w2 >> 16) & 0xFF] | lut->b[(w2 >> 8) & 0xFF]) << 16;
+    }
+  }
+  for (bgr += x * 3; x < width; x++, bgr += 3)
+    out[x] = lut->r[bgr[2]] | lut->g[bgr[1]] | lut->b[bgr[0]];
+}
+
+void convertPlanarTo565Lut(uint16_t *out, const uint8_t *r, const uint8_t *g, const uint8_t *b, int16_t width,
+                           const Rgb565Lut *lut)
+{
+  // Scalar only: the three table loads per pixel dominate, and unpacking plane words
+  // to index them costs more than the byte loads it saves
+  for (int16_t x = 0; x < width; x++)
+    out[x] = lut->r[r[x]] | lut->g[g[x]] | lut->b[b[x]];
+}
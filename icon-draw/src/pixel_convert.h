@@ -0,0 +1,55 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <stdint.h>
+
+// Bulk row conversions between the 24-bit layouts and RGB565. Each kernel works on
+// packed 32-bit words, four pixels per step: 12 bytes of BGR888 (or three 4-byte plane
+// words) in, two words of RGB565 out, using shifts and masks only. Rows whose pointers
+// are not all 4-byte aligned, and the last width % 4 pixels, take the scalar path, so
+// any row converts; aligned rows (framebuffer rows, the BMP reader's chunk) are fastest.
+//
+// Results are identical to the scalar ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3).
+// No Arduino dependencies so it builds on a host.
+
+// One RGB888 pixel as RGB565
+inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b)
+{
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// BMP-ordered BGR888 triplets -> RGB565
+void convertBGR888To565(uint16_t *out, const uint8_t *bgr, int16_t width);
+
+// RGB888 triplets (FB_RGB888_INTERLEAVED rows) -> RGB565
+void convertRGB888To565(uint16_t *out, const uint8_t *rgb, int16_t width);
+
+// Separate R, G and B planes (FB_RGB888_PLANAR rows) -> RGB565
+void convertPlanarTo565(uint16_t *out, const uint8_t *r, const uint8_t *g, const uint8_t *b, int16_t width);
+
+// BGR888 triplets -> RGB888 triplets (channel swap)
+void swapBGR888(uint8_t *rgb, const uint8_t *bgr, int16_t width);
+
+// BGR888 triplets -> separate R, G and B planes
+void splitBGR888(uint8_t *r, uint8_t *g, uint8_t *b, const uint8_t *bgr, int16_t width);
+
+// Per-channel lookup straight to RGB565 bits, for converting with a brightness and
+// gamma curve applied. Each table holds the channel's bits already in place, so a
+// pixel is r[R] | g[G] | b[B].
+struct Rgb565Lut
+{
+  uint16_t r[256];
+  uint16_t g[256];
+  uint16_t b[256];
+};
+
+// Fill the tables for out = (in / 255) ^ gamma * brightness / 255. Gamma 1 and
+// brightness 255 give the plain conversion. Floating point is only used here.
+void rgb565LutInit(Rgb565Lut *lut, uint8_t brightness, float gamma);
+
+// The BGR888 and planar conversions through a lookup table (the planar one a pixel at a time)
+void convertBGR888To565Lut(uint16_t *out, const uint8_t *bgr, int16_t width, const Rgb565Lut *lut);
+void convertPlanarTo565Lut(uint16_t *out, const uint8_t *r, const uint8_t *g, const uint8_t *b, int16_t width,
+                           const Rgb565Lut *lut);
+
+#endif
@@ -0,0 +1,190 @@
+#include "qoi_reader.h"
+
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00 // 00xxxxxx
+#define QOI_OP_DIFF 0x40  // 01xxxxxx
+#define QOI_OP_LUMA 0x80  // 10xxxxxx
+#define QOI_OP_RUN 0xC0   // 11xxxxxx
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+
+void qoiReaderInit(QoiReader *reader, BmpReadFn read, void *ctx)
+{
+  memset(&reader->info, 0, sizeof(reader->info));
+  reader->read = read;
+  reader->ctx = ctx;
+  reader->next = reader->chunk;
+  reader->limit = reader->chunk;
+}
+
+void qoiReaderInitMemory(QoiReader *reader, const uint8_t *data, size_t size)
+{
+  memset(&reader->info, 0, sizeof(reader->info));
+  reader->read = nullptr;
+  reader->ctx = nullptr;
+  reader->next = data;
+  reader->limit = data + size;
+}
+
+// Pull the next block from a streamed source
+static bool refill(QoiReader *reader)
+{
+  if (!reader->read)
+    return false;
+
+  size_t got = reader->read(reader->ctx, reader->chunk, QOI_CHUNK_SIZE);
+  reader->next = reader->chunk;
+  reader->limit = reader->chunk + got;
+  return got > 0;
+}
+
+// Next input byte, or -1 at the end of the source
+static inline int nextByte(QoiReader *reader)
+{
+  if (reader->next == reader->limit && !refill(reader))
+    return -1;
+  return *reader->next++;
+}
+
+QoiStatus qoiReadHeader(QoiReader *reader)
+{
+  uint8_t header[QOI_HEADER_SIZE];
+  for (int i = 0; i < QOI_HEADER_SIZE; i++)
+  {
+    int value = nextByte(reader);
+    if (value < 0)
+      return QOI_READ_ERROR;
+    header[i] = (uint8_t)value;
+  }
+
+  if (memcmp(header, "qoif", 4) != 0)
+    return QOI_BAD_SIGNATURE;
+
+  QoiInfo &info = reader->info;
+  info.width = ((uint32_t)header[4] << 24) | ((uint32_t)header[5] << 16) | (header[6] << 8) | header[7];
+  info.height = ((uint32_t)header[8] << 24) | ((uint32_t)header[9] << 16) | (header[10] << 8) | header[11];
+  info.channels = header[12];
+  info.colorspace = header[13];
+
+  if (info.width == 0 || info.height == 0 || info.width > INT16_MAX || info.height > INT16_MAX)
+    return QOI_BAD_SIZE;
+  return QOI_OK;
+}
+
+QoiStatus qoiDecodeToFramebuffer(QoiReader *reader, GlitchFramebuffer *fb)
+{
+  if (!fb->allocated || (uint32_t)fb->width != reader->info.width || (uint32_t)fb->height != reader->info.height ||
+      framebufferIsIndexed(fb->format))
+    return QOI_BAD_SIZE;
+
+  // Colour cache indexed by hash, packed as r | g << 8 | b << 16 | a << 24
+  uint32_t index[64];
+  memset(index, 0, sizeof(index));
+  uint8_t r = 0, g = 0, b = 0, a = 255;
+  uint32_t run = 0;
+
+  for (int16_t y = 0; y < fb->height; y++)
+  {
+    uint8_t *row = framebufferRow(fb, y);
+    for (int16_t x = 0; x < fb->width; x++)
+    {
+      if (run > 0)
+      {
+        run--;
+      }
+      else
+      {
+        int op = nextByte(reader);
+        if (op < 0)
+          return QOI_READ_ERROR;
+
+        if (op == QOI_OP_RGB || op == QOI_OP_RGBA)
+        {
+          int cr = nextByte(reader), cg = nextByte(reader), cb = nextByte(reader);
+          int ca = op == QOI_OP_RGBA ? nextByte(reader) : a;
+          if (cr < 0 || cg < 0 || cb < 0 || ca < 0)
+            return QOI_READ_ERROR;
+          r = cr;
+          g = cg;
+          b = cb;
+          a = ca;
+        }
+        else
+        {
+          switch (op & 0xC0)
+          {
+          case QOI_OP_INDEX:
+          {
+            uint32_t packed = index[op];
+            r = packed;
+            g = packed >> 8;
+            b = packed >> 16;
+            a = packed >> 24;
+            break;
+          }
+          case QOI_OP_DIFF:
+            r += ((op >> 4) & 0x03) - 2;
+            g += ((op >> 2) & 0x03) - 2;
+            b += (op & 0x03) - 2;
+            break;
+          case QOI_OP_LUMA:
+          {
+            int second = nextByte(reader);
+            if (second < 0)
+              return QOI_READ_ERROR;
+            int dg = (op & 0x3F) - 32;
+            r += dg - 8 + ((second >> 4) & 0x0F);
+            g += dg;
+            b += dg - 8 + (second & 0x0F);
+            break;
+          }
+          case QOI_OP_RUN:
+            run = op & 0x3F; // This pixel plus `run` more
+            break;
+          }
+        }
+
+        index[(r * 3 + g * 5 + b * 7 + a * 11) & 63] = r | (g << 8) | (b << 16) | ((uint32_t)a << 24);
+      }
+
+      // Store straight into the framebuffer in its own layout
+      switch (fb->format)
+      {
+      case FB_RGB888_PLANAR:
+        row[x] = r;
+        row[x + fb->planeSize] = g;
+        row[x + 2 * fb->planeSize] = b;
+        break;
+      case FB_RGB888_INTERLEAVED:
+        row[x * 3] = r;
+        row[x * 3 + 1] = g;
+        row[x * 3 + 2] = b;
+        break;
+      case FB_RGB565:
+        ((uint16_t *)row)[x] = rgb565(r, g, b);
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  return QOI_OK;
+}
+
+const char *qoiStatusString(QoiStatus status)
+{
+  switch (status)
+  {
+  case QOI_OK:
+    return "OK";
+  case QOI_READ_ERROR:
+    return "QOI data ended early";
+  case QOI_BAD_SIGNATURE:
+    return "Not a QOI file";
+  case QOI_BAD_SIZE:
+    return "QOI size invalid or mismatched";
+  }
+  return "Unknown QOI error";
+}
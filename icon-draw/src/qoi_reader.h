@@ -0,0 +1,63 @@
+#ifndef QOI_READER_H
+#define QOI_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bmp_reader.h"
+#include "framebuffer.h"
+
+// Streaming decoder for QOI ("Quite OK Image") files, the compressed icon format written
+// by scripts/pack_icons.py. Flat icons shrink to a fraction of their 24-bit BMP size
+// (runs, a 64-entry colour cache and small deltas) and decode in a single pass.
+
+// Bytes read from a streamed source per call
+#define QOI_CHUNK_SIZE 256
+
+// "qoif", width, height (big-endian), channels, colorspace
+#define QOI_HEADER_SIZE 14
+
+enum QoiStatus : uint8_t
+{
+  QOI_OK,
+  QOI_READ_ERROR,    // Source ended early
+  QOI_BAD_SIGNATURE, // Not "qoif"
+  QOI_BAD_SIZE       // Zero size, or does not match the framebuffer (or it is indexed)
+};
+
+struct QoiInfo
+{
+  uint32_t width;
+  uint32_t height;
+  uint8_t channels;   // 3 = RGB, 4 = RGBA (alpha is ignored)
+  uint8_t colorspace; // 0 = sRGB
+};
+
+// Decoder input. Streamed sources are read in QOI_CHUNK_SIZE blocks; in-memory data
+// (e.g. the mapped icon archive) is decoded in place without copying.
+struct QoiReader
+{
+  BmpReadFn read; // nullptr for in-memory data
+  void *ctx;
+  const uint8_t *next;  // Next unread byte
+  const uint8_t *limit; // End of the bytes available in `next`
+  QoiInfo info;
+  uint8_t chunk[QOI_CHUNK_SIZE];
+};
+
+// Set up a reader over a sequential source
+void qoiReaderInit(QoiReader *reader, BmpReadFn read, void *ctx);
+
+// Set up a reader over data already in memory
+void qoiReaderInitMemory(QoiReader *reader, const uint8_t *data, size_t size);
+
+// Read and validate the header
+QoiStatus qoiReadHeader(QoiReader *reader);
+
+// Decode every pixel straight into `fb`, which must already be allocated at the image
+// size (any RGB framebuffer format). Call after qoiReadHeader.
+QoiStatus qoiDecodeToFramebuffer(QoiReader *reader, GlitchFramebuffer *fb);
+
+// Human readable status for logging
+const char *qoiStatusString(QoiStatus status);
+
+#endif
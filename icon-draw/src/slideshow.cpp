@@ -0,0 +1,241 @@
+#include "slideshow.h"
+
+#include <Arduino.h>
+#include <frame_profiler.h>
+#include "bmp_handler.h"
+#include "crossfade.h"
+
+static bool isAnimation(const Slideshow *show, int index)
+{
+  return index >= show->config.media.imageCount(show->config.media.ctx);
+}
+
+void slideshowInit(Slideshow *show, const SlideshowConfig *config)
+{
+  static const GlitchFramebuffer empty = GLITCH_FRAMEBUFFER_INIT;
+  show->config = *config;
+  show->incoming = empty;
+  show->state = FADE_IN;
+  show->currentImage = 0;
+  show->nextImage = -1;
+  show->lastTransitionTime = 0;
+  show->imageLoaded = false;
+  show->current = nullptr;
+  show->next = nullptr;
+  show->animationShown = false;
+  show->lastAnimationFrame = 0;
+}
+
+static const AnimSpanList noChanges = {};
+
+void slideshowStep(Slideshow *show, SlideshowFrame *frame)
+{
+  const SlideshowConfig &config = show->config;
+
+  unsigned long currentTime = millis();
+  unsigned long elapsedTime = currentTime - show->lastTransitionTime;
+  uint8_t progress = fadeProgress(elapsedTime, config.fadeTime);
+
+  frame->next = nullptr;
+  frame->mix = 0;
+  frame->fade = FADE_ONE;
+  frame->blank = false;
+  frame->imageDone = false;
+  frame->changed = nullptr;
+
+  switch (show->state)
+  {
+  case FADE_IN:
+    if (!show->imageLoaded)
+    {
+      // Take the current image from the cache; when it was prefetched this only swaps a pointer
+      show->current = isAnimation(show, show->currentImage)
+                          ? config.media.startAnimation(config.media.ctx, show->currentImage)
+                          : imageCacheGet(config.cache, show->currentImage);
+      show->animationShown = false;
+      show->imageLoaded = true;
+      show->lastTransitionTime = currentTime;
+      elapsedTime = 0;
+      progress = 0;
+    }
+
+    // Fade in from black with easing (slower start, faster end)
+    frame->fade = fadeWeight(FADE_EASE_IN, progress);
+    if (elapsedTime >= config.fadeTime)
+    {
+      show->state = SHOWING;
+      show->lastTransitionTime = currentTime;
+    }
+    break;
+
+  case SHOWING:
+    // Pick the next image now and decode it while this one is on screen
+    if (show->nextImage < 0)
+    {
+      show->nextImage = random(0, config.media.mediaCount(config.media.ctx));
+      if (!isAnimation(show, show->nextImage))
+        imageCachePrefetch(config.cache, show->nextImage);
+    }
+
+    // An animation is presented whole once, then only the spans each new frame changes
+    // (nothing at all while a frame is held)
+    if (show->current && show->current == &config.player->frame)
+    {
+      frame->changed = &noChanges;
+      if (!show->animationShown)
+      {
+        frame->changed = nullptr;
+        show->animationShown = true;
+        show->lastAnimationFrame = currentTime;
+      }
+      else if (currentTime - show->lastAnimationFrame >= config.player->header.frameMs)
+      {
+        PROFILE_SCOPE(PROFILE_LOAD);
+        if (animPlayerNextFrame(config.player) == ANIM_OK)
+          frame->changed = &config.player->changed;
+        show->lastAnimationFrame = currentTime;
+      }
+    }
+
+    // Hold at full brightness (an animation for at least one pass)
+    if (elapsedTime >= config.showingTime &&
+        (!isAnimation(show, show->currentImage) ||
+         elapsedTime >= (unsigned long)config.player->header.frameMs * config.player->header.frameCount))
+    {
+      // Crossfade only into an image that is already decoded: taking it is then a cache
+      // hit, so nothing decodes (and nothing is evicted) until the crossfade is over.
+      // Animations always come in through black.
+      if (config.crossfade && !isAnimation(show, show->nextImage) && imageCacheContains(config.cache, show->nextImage))
+      {
+        show->next = imageCacheGet(config.cache, show->nextImage);
+        show->state = CROSSFADE;
+      }
+      else
+      {
+        show->state = FADE_OUT;
+      }
+      show->lastTransitionTime = currentTime;
+    }
+    break;
+
+  case FADE_OUT:
+    // Fade out to black with easing (faster start, slower end)
+    frame->fade = fadeWeight(FADE_EASE_IN, FADE_STEPS - 1 - progress);
+    if (elapsedTime >= config.fadeTime)
+    {
+      show->state = BLACK;
+      show->lastTransitionTime = currentTime;
+    }
+    break;
+
+  case BLACK:
+    // The image stays cached; it is only evicted when the budget needs the space
+    show->current = nullptr;
+    frame->blank = true;
+    frame->imageDone = true;
+    frame->cacheStats = imageCacheStats(config.cache, show->currentImage);
+
+    // Stay black briefly, then switch to the random image picked while showing
+    show->currentImage = show->nextImage >= 0 ? show->nextImage : random(0, config.media.mediaCount(config.media.ctx));
+    show->nextImage = -1;
+    show->imageLoaded = false;
+    show->state = FADE_IN;
+    show->lastTransitionTime = currentTime;
+    break;
+
+  case CROSSFADE:
+    if (show->current && show->next && crossfadeCompatible(show->current, show->next))
+    {
+      frame->next = show->next;
+      frame->mix = crossfadeWeight(FADE_SMOOTH, progress);
+    }
+    else if (progress < FADE_STEPS / 2)
+    {
+      // Different sizes or formats (e.g. indexed icons) cannot be mixed per pixel: fade
+      // the old image out over the first half and the new one in over the second
+      frame->fade = fadeWeight(FADE_EASE_IN, FADE_STEPS - 1 - progress * 2);
+    }
+    else
+    {
+      show->current = show->next;
+      frame->fade = fadeWeight(FADE_EASE_IN, (progress - FADE_STEPS / 2) * 2 + 1);
+    }
+
+    if (elapsedTime >= config.fadeTime)
+    {
+      frame->imageDone = true;
+      frame->cacheStats = imageCacheStats(config.cache, show->currentImage);
+
+      show->current = show->next;
+      show->next = nullptr;
+      show->currentImage = show->nextImage;
+      show->nextImage = -1;
+      show->state = SHOWING;
+      show->lastTransitionTime = currentTime;
+    }
+    break;
+  }
+
+  // A new glitch every frame while an image is up
+  frame->source = show->current;
+  frame->glitch = show->current != &config.player->frame;
+  frame->seed = glitchRendererNextSeed(config.renderer);
+}
+
+bool slideshowCompose(Slideshow *show, GlitchFramebuffer *target, const SlideshowFrame *frame)
+{
+  static const GlitchEffectChain noGlitch = {nullptr, 0};
+  GlitchRenderer *renderer = show->config.renderer;
+  if (!composeFramebufferGlitched(renderer, target, frame->source, frame->glitch ? renderer->chain : &noGlitch,
+                                  frame->seed))
+    return false;
+  // The incoming image gets a glitch of its own
+  bool mixed = frame->next && composeFramebufferGlitched(renderer, &show->incoming, frame->next, renderer->chain,
+                                                         glitchFrameSeed(frame->seed, 1));
+
+  PROFILE_SCOPE(PROFILE_BLEND);
+  if (mixed)
+    crossfadeFramebuffer(target, &show->incoming, frame->mix);
+  fadeFramebuffer(target, frame->fade);
+  return true;
+}
+
+void slideshowContentLevels(const SlideshowConfig *config, const uint32_t *imageLevels, ColorLevels *levels)
+{
+  colorLevelsAdd(levels, 0);
+  if (config->fadeTime > 0 || !imageLevels)
+  {
+    colorLevelsAddAll(levels);
+    return;
+  }
+  for (int i = 0; i < 8; i++)
+    levels->used[i] |= imageLevels[i];
+}
+
+void slideshowProducerTask(void *ctx)
+{
+  Slideshow *show = (Slideshow *)ctx;
+  FramePipeline *pipeline = show->config.pipeline;
+  for (;;)
+  {
+    PipelineFrame *frame = framePipelineAcquire(pipeline);
+    if (!frame)
+    {
+      vTaskDelay(1);
+      continue;
+    }
+
+    SlideshowFrame slide;
+    slideshowStep(show, &slide);
+    frame->blank = slide.blank;
+    frame->imageDone = slide.imageDone;
+    frame->cacheStats = slide.cacheStats;
+    frame->composed = !slide.blank && slideshowCompose(show, &frame->fb, &slide);
+    // The consumer presents every frame in order, so the panel already shows the one
+    // before: an animation frame only needs its changed spans
+    frame->partial = slide.changed != nullptr;
+    if (frame->partial)
+      frame->changed = *slide.changed;
+    framePipelineSubmit(pipeline, frame);
+  }
+}
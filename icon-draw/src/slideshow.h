@@ -0,0 +1,101 @@
+#ifndef SLIDESHOW_H
+#define SLIDESHOW_H
+
+#include <stdint.h>
+#include <color_depth.h>
+#include "anim_player.h"
+#include "frame_pipeline.h"
+#include "glitch_renderer.h"
+#include "image_cache.h"
+
+// The rotation: each picture fades in from black, holds, then crossfades into the next
+// one or fades out through black. Images come decoded from the image cache (the next one
+// is prefetched while the current one shows); animations play through an AnimPlayer.
+enum SlideshowState
+{
+  FADE_IN,
+  SHOWING,
+  FADE_OUT,
+  BLACK,
+  CROSSFADE
+};
+
+// Where the pictures come from. Indices below imageCount() are images (cache indices),
+// the rest up to mediaCount() are animations.
+struct SlideshowMedia
+{
+  int (*imageCount)(void *ctx);
+  int (*mediaCount)(void *ctx);
+  const GlitchFramebuffer *(*startAnimation)(void *ctx, int index); // Its first frame, or nullptr
+  void *ctx;
+};
+
+struct SlideshowConfig
+{
+  SlideshowMedia media;
+  ImageCache *cache;
+  AnimPlayer *player;         // Its frame is the source while an animation shows
+  GlitchRenderer *renderer;   // Seeds every frame's glitch and composes it
+  FramePipeline *pipeline;    // Where slideshowProducerTask() submits frames
+  unsigned long showingTime;  // Hold at full brightness (ms)
+  unsigned long fadeTime;     // Each fade and crossfade (ms)
+  bool crossfade;             // Crossfade straight into the next image; false = fade through black
+};
+
+// What one frame of the rotation shows
+struct SlideshowFrame
+{
+  const GlitchFramebuffer *source; // Image to glitch
+  const GlitchFramebuffer *next;   // Image crossfading in over source, or nullptr
+  uint16_t mix;                    // Weight of next (FADE_ONE = only next)
+  uint16_t fade;                   // Weight of the result against black (FADE_ONE = full)
+  uint32_t seed;                   // Glitch frame (glitchCompose() replays it exactly)
+  bool glitch;                     // Glitch source (animations are shown as they are)
+  const AnimSpanList *changed;     // Only these spans of source changed since the last frame and
+                                   // it needs no composing (nullptr = compose and present it all)
+  bool blank;                      // Black gap between images: clear the screen instead of drawing
+  bool imageDone;                  // An image just finished: report its frame stats
+  ImageCacheStats cacheStats;      // With imageDone: cache activity so far and that image's decode time
+};
+
+struct Slideshow
+{
+  SlideshowConfig config;
+  GlitchFramebuffer incoming; // Glitched incoming image during a crossfade (only touched by whichever side composes)
+
+  SlideshowState state;
+  int currentImage;
+  int nextImage; // Picked while the current one shows, -1 = not yet
+  unsigned long lastTransitionTime;
+  bool imageLoaded;
+  const GlitchFramebuffer *current; // On screen (owned by the image cache or the player)
+  const GlitchFramebuffer *next;    // Crossfading in
+  bool animationShown;              // Current animation has been presented whole
+  unsigned long lastAnimationFrame; // When its current frame came up
+};
+
+// Start the rotation at the first picture, fading in
+void slideshowInit(Slideshow *show, const SlideshowConfig *config);
+
+// Advance the rotation by one frame. Runs wherever frames are composed (loop() when
+// single-core, the producer task when pipelined).
+void slideshowStep(Slideshow *show, SlideshowFrame *frame);
+
+// Glitch the frame's image(s) into `target`, then apply its crossfade and fade.
+// Returns false if there is nothing to draw.
+bool slideshowCompose(Slideshow *show, GlitchFramebuffer *target, const SlideshowFrame *frame);
+
+// Channel levels the rotation puts on the panel, for the colour depth, given those its
+// images use (`imageLevels`: bit n % 32 of word n / 32, as in AssetHeader; nullptr =
+// unknown). Black for the blanks and fade ends, plus the images' own. Fades and
+// crossfades scale and mix them by the weights slideshowStep() takes from fadeProgress(),
+// which follows elapsed time rather than frames (the producer runs ahead of the
+// deadlines), so with a fade time any step can come up and every level counts.
+void slideshowContentLevels(const SlideshowConfig *config, const uint32_t *imageLevels, ColorLevels *levels);
+
+// Producer task body (pipelined mode; pass the Slideshow): steps and composes every free
+// frame of the pipeline ahead of the display. Stalls when every frame is in flight,
+// which paces it to the consumer.
+void slideshowProducerTask(void *show);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal Arduino core for native builds. Only what the sketches use is provided.
+// Time is virtual: it only moves when something waits (delay(), the frame scheduler's
+// host clock), so runs are deterministic and never sleep.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PROGMEM
+#define F(string) (string)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+// Serial port writing to stdout (silent unless enabled with hostSerialEnable)
+class HardwareSerial
+{
+public:
+  void begin(unsigned long) {}
+
+  size_t print(const char *text);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned long long value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(double value, int digits = 2);
+
+  size_t write(const uint8_t *data, size_t length);
+  int available() { return 0; } // No input on a host
+  int read() { return -1; }
+
+  size_t println() { return print("\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+extern HardwareSerial Serial;
+
+// Enable or silence Serial output
+void hostSerialEnable(bool enable);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Advance virtual time to `deadlineUs` on the micros() clock (no-op if already past)
+void hostAdvanceTo(uint32_t deadlineUs);
+
+// Deterministic random(); randomSeed() restarts the sequence
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline bool psramFound() { return true; }
+inline void yield() {}
+
+// FreeRTOS tasks map onto detached std::threads; vTaskDelay sleeps for real and
+// vTaskDelete does nothing (the thread ends when the task function returns)
+typedef void (*TaskFunction_t)(void *);
+int xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackSize, void *param,
+                            unsigned priority, void *handle, int core);
+void vTaskDelay(uint32_t ticks);
+inline void vTaskDelete(void *) {}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef HOST_HUB75_PANEL_H
+#define HOST_HUB75_PANEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Simulated HUB75 panel. Keeps an RGB888 copy of what the panel would show and counts
+// the draw calls and pixel writes reaching it.
+//
+// Like Adafruit GFX, setRotation() applies to drawPixel/drawFastHLine/drawFastVLine/
+// fillRect/fillScreen; drawPixelRGB888() addresses the physical panel directly.
+//
+// The colour depth is PIXEL_COLOR_DEPTH_BITS until setPixelColorDepthBits() lowers it.
+
+#ifndef PIXEL_COLOR_DEPTH_BITS
+#define PIXEL_COLOR_DEPTH_BITS 8
+#endif
+
+struct HUB75_I2S_CFG
+{
+  enum shift_driver
+  {
+    SHIFTREG,
+    FM6124,
+    FM6126A,
+    ICN2038S,
+    MBI5124,
+    SM5266P
+  };
+  enum clk_speed
+  {
+    HZ_8M = 8000000,
+    HZ_10M = 10000000,
+    HZ_15M = 15000000,
+    HZ_20M = 20000000
+  };
+  struct i2s_pins
+  {
+    int8_t r1, g1, b1, r2, g2, b2, a, b, c, d, e, lat, oe, clk;
+  };
+
+  uint16_t mx_width;
+  uint16_t mx_height;
+  uint16_t chain_length;
+  i2s_pins gpio;
+  shift_driver driver;
+  clk_speed i2sspeed;
+  bool double_buff;
+  bool clkphase;
+  uint16_t min_refresh_rate;
+  uint8_t latch_blanking;
+
+  HUB75_I2S_CFG(uint16_t width = 64, uint16_t height = 32, uint16_t chain = 1)
+      : mx_width(width), mx_height(height), chain_length(chain), gpio(), driver(SHIFTREG),
+        i2sspeed(HZ_10M), double_buff(false), clkphase(true), min_refresh_rate(60), latch_blanking(1)
+  {
+  }
+};
+
+// What the panel has received since the counters were last reset
+struct PanelCounters
+{
+  uint32_t drawCalls;
+  uint32_t pixelWrites;
+};
+
+class MatrixPanel_I2S_DMA
+{
+public:
+  MatrixPanel_I2S_DMA(const HUB75_I2S_CFG &config);
+  ~MatrixPanel_I2S_DMA();
+
+  bool begin();
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillScreen(uint16_t color);
+  void drawPixelRGB888(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b);
+  void fillScreenRGB888(uint8_t r, uint8_t g, uint8_t b);
+  void clearScreen();
+  void flipDMABuffer() {}
+
+  void setBrightness8(uint8_t brightness) { this->brightness = brightness; }
+  // Bit planes, 2 up to PIXEL_COLOR_DEPTH_BITS; on the board only before begin()
+  void setPixelColorDepthBits(uint8_t bits);
+  uint8_t getPixelColorDepthBits() const { return depth; }
+  void setRotation(uint8_t rotation) { this->rotation = rotation & 3; }
+  uint8_t getRotation() const { return rotation; }
+
+  // Logical size after rotation
+  int16_t width() const { return (rotation & 1) ? panelHeight : panelWidth; }
+  int16_t height() const { return (rotation & 1) ? panelWidth : panelHeight; }
+
+  static uint16_t color565(uint8_t r, uint8_t g, uint8_t b)
+  {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  }
+
+  // Simulation access
+  const uint8_t *pixels() const { return shadow; } // Physical RGB888, row-major
+  int16_t panelWidthPx() const { return panelWidth; }
+  int16_t panelHeightPx() const { return panelHeight; }
+  uint8_t currentBrightness() const { return brightness; }
+  PanelCounters counters;
+
+private:
+  void setPhysical(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b);
+  void setLogical(int16_t x, int16_t y, uint16_t color);
+
+  uint8_t *shadow;
+  int16_t panelWidth;
+  int16_t panelHeight;
+  uint8_t rotation;
+  uint8_t brightness;
+  uint8_t depth;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// LittleFS mapped onto a host directory (default "data", i.e. the sketch's data folder
+// when run from the project directory)
+class File
+{
+public:
+  File(FILE *file = nullptr) : file(file) {}
+
+  operator bool() const { return file != nullptr; }
+  int read();
+  size_t read(uint8_t *buffer, size_t length);
+  bool seek(uint32_t position);
+  size_t position();
+  size_t size();
+  int available() { return (int)(size() - position()); }
+  void close();
+
+private:
+  FILE *file;
+};
+
+class LittleFSFS
+{
+public:
+  bool begin(bool formatOnFail = false) { return true; }
+  File open(const char *path, const char *mode = "r");
+  bool exists(const char *path);
+};
+
+extern LittleFSFS LittleFS;
+
+// Directory that "/" maps to
+void hostSetFsRoot(const char *directory);
+const char *hostFsRoot();
+
+// Bytes read through File since start
+uint64_t hostFsBytesRead();
+
+#endif
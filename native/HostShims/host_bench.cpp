@@ -0,0 +1,172 @@
+#include "host_bench.h"
+#include "Arduino.h"
+#include "LittleFS.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+bool hostBenchParseArgs(int argc, char **argv, BenchOptions *options)
+{
+  options->frames = 1000;
+  options->dumpDir = nullptr;
+  options->dumpEvery = 0;
+  options->filter = nullptr;
+  options->profile = false;
+  options->assetDir = ".";
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--verbose") == 0)
+    {
+      hostSerialEnable(true);
+      continue;
+    }
+    if (strcmp(arg, "--profile") == 0)
+    {
+      options->profile = true;
+      continue;
+    }
+    if (!value)
+      goto usage;
+
+    if (strcmp(arg, "--frames") == 0)
+      options->frames = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--dump") == 0)
+      options->dumpDir = value;
+    else if (strcmp(arg, "--dump-every") == 0)
+      options->dumpEvery = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--data") == 0)
+      hostSetFsRoot(value);
+    else if (strcmp(arg, "--assets") == 0)
+      options->assetDir = value;
+    else if (strcmp(arg, "--only") == 0)
+      options->filter = value;
+    else
+      goto usage;
+    i++;
+  }
+  if (options->dumpDir)
+    mkdir(options->dumpDir, 0755); // Fine if it already exists
+  return options->frames > 0;
+
+usage:
+  fprintf(stderr, "usage: %s [--frames N] [--dump DIR] [--dump-every N] [--data DIR] [--assets DIR] [--only NAME] [--profile] [--verbose]\n", argv[0]);
+  return false;
+}
+
+void hostBenchPrintHeader()
+{
+  printf("%-36s %8s %12s %10s %12s %10s %10s  %s\n", "case", "frames", "ns/frame", "calls/fr", "pixels/fr", "allocs/fr",
+         "read B/fr", "panel hash");
+}
+
+static void dumpFrame(const MatrixPanel_I2S_DMA *panel, const BenchOptions *options, const char *name, int32_t frame)
+{
+  char path[512];
+  if (frame < 0)
+    snprintf(path, sizeof(path), "%s/%s.ppm", options->dumpDir, name);
+  else
+    snprintf(path, sizeof(path), "%s/%s_%05d.ppm", options->dumpDir, name, (int)frame);
+  if (!hostDumpPanel(panel, path))
+    fprintf(stderr, "Failed to write %s\n", path);
+}
+
+bool hostBenchSelected(const BenchOptions *options, const char *name)
+{
+  return !options->filter || strstr(name, options->filter);
+}
+
+bool hostBenchRun(const char *name, MatrixPanel_I2S_DMA *panel, BenchFrameFn render, void *ctx,
+                  const BenchOptions *options, BenchResult *result)
+{
+  if (!hostBenchSelected(options, name))
+    return false;
+
+  uint64_t totalNs = 0;
+  uint64_t allocations = 0;
+  uint64_t readBefore = hostFsBytesRead();
+  panel->counters = PanelCounters();
+
+  for (uint32_t frame = 0; frame < options->frames; frame++)
+  {
+    uint64_t allocBefore = hostAllocationCount();
+    uint64_t start = hostRealNanos();
+    render(ctx, frame);
+    totalNs += hostRealNanos() - start;
+    allocations += hostAllocationCount() - allocBefore;
+
+    if (options->dumpDir && options->dumpEvery && frame % options->dumpEvery == 0)
+      dumpFrame(panel, options, name, frame);
+  }
+
+  BenchResult r;
+  r.frames = options->frames;
+  r.nsPerFrame = (double)totalNs / r.frames;
+  r.drawCallsPerFrame = (double)panel->counters.drawCalls / r.frames;
+  r.pixelWritesPerFrame = (double)panel->counters.pixelWrites / r.frames;
+  r.allocationsPerFrame = (double)allocations / r.frames;
+  r.bytesReadPerFrame = (double)(hostFsBytesRead() - readBefore) / r.frames;
+  r.panelHash = hostPanelHash(panel);
+
+  if (options->dumpDir)
+    dumpFrame(panel, options, name, -1);
+
+  printf("%-36s %8u %12.0f %10.1f %12.1f %10.2f %10.0f  %016llx\n", name, r.frames, r.nsPerFrame,
+         r.drawCallsPerFrame, r.pixelWritesPerFrame, r.allocationsPerFrame, r.bytesReadPerFrame,
+         (unsigned long long)r.panelHash);
+  fflush(stdout);
+
+  if (result)
+    *result = r;
+  return true;
+}
+
+static int checkFailures = 0;
+
+bool hostBenchCheck(bool ok, const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  printf("check ");
+  vprintf(format, args);
+  printf(": %s\n", ok ? "ok" : "FAILED");
+  va_end(args);
+  fflush(stdout);
+  checkFailures += !ok;
+  return ok;
+}
+
+int hostBenchFailures()
+{
+  return checkFailures;
+}
+
+bool hostDumpPanel(const MatrixPanel_I2S_DMA *panel, const char *path)
+{
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+
+  size_t bytes = (size_t)panel->panelWidthPx() * panel->panelHeightPx() * 3;
+  fprintf(file, "P6\n%d %d\n255\n", panel->panelWidthPx(), panel->panelHeightPx());
+  bool ok = fwrite(panel->pixels(), 1, bytes, file) == bytes;
+  return fclose(file) == 0 && ok;
+}
+
+uint64_t hostPanelHash(const MatrixPanel_I2S_DMA *panel)
+{
+  const uint8_t *p = panel->pixels();
+  size_t bytes = (size_t)panel->panelWidthPx() * panel->panelHeightPx() * 3;
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (size_t i = 0; i < bytes; i++)
+  {
+    hash ^= p[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
@@ -0,0 +1,77 @@
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <stdint.h>
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+
+// Benchmark runner for native builds. Each case renders a number of frames against the
+// simulated panel and reports wall time, panel traffic and heap allocations per frame.
+// Frames can be dumped as PPM images for golden-output comparison.
+
+// Heap allocations since start (malloc/calloc/realloc/new; glibc hosts without a
+// sanitizer only, else 0)
+uint64_t hostAllocationCount();
+
+// Monotonic wall clock in nanoseconds
+uint64_t hostRealNanos();
+
+// Virtual-time clock for the frame scheduler: waiting advances micros() instantly.
+// Build a SchedulerClock from these to run a sketch's loop() without sleeping;
+// hostClockNow is also a BootClockFn, so boot traces record on the same clock.
+uint32_t hostClockNow(void *ctx);
+void hostClockWaitUntil(void *ctx, uint32_t deadlineUs);
+
+struct BenchOptions
+{
+  uint32_t frames;     // Frames per case
+  const char *dumpDir; // Write frames here as PPM (nullptr = no dumps)
+  uint32_t dumpEvery;  // Also dump every Nth frame (0 = final frame only)
+  const char *filter;  // Only run cases whose name contains this (nullptr = all)
+  bool profile;        // Print the frame profiler report at the end
+  const char *assetDir; // Generated assets (packed archives, converted images); default "."
+};
+
+// --frames N, --dump DIR, --dump-every N, --data DIR, --assets DIR, --only NAME, --profile,
+// --verbose.
+// Returns false (after printing usage) on a bad argument.
+bool hostBenchParseArgs(int argc, char **argv, BenchOptions *options);
+
+struct BenchResult
+{
+  uint32_t frames;
+  double nsPerFrame;
+  double drawCallsPerFrame;
+  double pixelWritesPerFrame;
+  double allocationsPerFrame;
+  double bytesReadPerFrame; // Through LittleFS
+  uint64_t panelHash; // FNV-1a of the final panel contents
+};
+
+// Render one frame; `frame` counts from 0
+typedef void (*BenchFrameFn)(void *ctx, uint32_t frame);
+
+// Whether --only lets a case or check of this name run
+bool hostBenchSelected(const BenchOptions *options, const char *name);
+
+// Run a case and print its result line. Only time spent inside `render` is measured.
+// Returns false if the case was filtered out.
+bool hostBenchRun(const char *name, MatrixPanel_I2S_DMA *panel, BenchFrameFn render, void *ctx,
+                  const BenchOptions *options, BenchResult *result = nullptr);
+
+// Column headings for the result lines
+void hostBenchPrintHeader();
+
+// Write the panel as a binary PPM (P6). Returns false on I/O failure.
+bool hostDumpPanel(const MatrixPanel_I2S_DMA *panel, const char *path);
+
+// FNV-1a hash of the panel contents
+uint64_t hostPanelHash(const MatrixPanel_I2S_DMA *panel);
+
+// Pass/fail check: prints "check <description>: ok" or "... FAILED" (printf-style
+// description) and counts failures. Returns `ok`.
+bool hostBenchCheck(bool ok, const char *format, ...);
+
+// Failed checks so far; a bench's main() returns non-zero when there are any
+int hostBenchFailures();
+
+#endif
@@ -0,0 +1,379 @@
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_bench.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+/*--------------------- ALLOCATION COUNTING -------------------------*/
+static std::atomic<uint64_t> allocationCount(0);
+
+uint64_t hostAllocationCount()
+{
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_THREAD__) && !defined(__SANITIZE_ADDRESS__)
+// Count every heap allocation (malloc, calloc, realloc and operator new) by wrapping glibc.
+// Sanitizers bring their own allocator, so the count stays 0 under them.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+extern "C" void *malloc(size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+  __libc_free(ptr);
+}
+#endif
+
+/*--------------------- SERIAL -------------------------*/
+HardwareSerial Serial;
+static bool serialEnabled = false;
+
+void hostSerialEnable(bool enable)
+{
+  serialEnabled = enable;
+}
+
+size_t HardwareSerial::print(const char *text)
+{
+  if (!serialEnabled)
+    return 0;
+  return fputs(text, stdout) >= 0 ? strlen(text) : 0;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t length)
+{
+  return serialEnabled ? fwrite(data, 1, length, stdout) : 0;
+}
+
+size_t HardwareSerial::print(char c)
+{
+  char text[2] = {c, 0};
+  return print(text);
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+  if (value < 0 && base == DEC)
+    return print('-') + print((unsigned long)-value, base);
+  return print((unsigned long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned long value, int base)
+{
+  char text[8 * sizeof(unsigned long) + 1];
+  char *p = &text[sizeof(text) - 1];
+  *p = 0;
+  if (base < 2)
+    base = DEC;
+  do
+  {
+    int digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  return print(p);
+}
+
+size_t HardwareSerial::print(double value, int digits)
+{
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+/*--------------------- TIME -------------------------*/
+// Virtual microseconds since start; only waits move it
+static std::atomic<uint64_t> virtualUs(0);
+
+unsigned long millis()
+{
+  return (unsigned long)(virtualUs.load() / 1000);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)(uint32_t)virtualUs.load();
+}
+
+void delay(unsigned long ms)
+{
+  virtualUs.fetch_add((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  virtualUs.fetch_add(us);
+}
+
+void hostAdvanceTo(uint32_t deadlineUs)
+{
+  int32_t remaining = (int32_t)(deadlineUs - (uint32_t)micros());
+  if (remaining > 0)
+    virtualUs.fetch_add(remaining);
+}
+
+uint32_t hostClockNow(void *)
+{
+  return (uint32_t)micros();
+}
+
+void hostClockWaitUntil(void *, uint32_t deadlineUs)
+{
+  hostAdvanceTo(deadlineUs);
+}
+
+uint64_t hostRealNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/*--------------------- RANDOM -------------------------*/
+static uint32_t randomState = 1;
+
+// xorshift32: same sequence on every host for a given seed
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+long random(long max)
+{
+  return max <= 0 ? 0 : nextRandom() % max;
+}
+
+long random(long min, long max)
+{
+  return max <= min ? min : min + (long)(nextRandom() % (uint32_t)(max - min));
+}
+
+void randomSeed(unsigned long seed)
+{
+  randomState = seed ? (uint32_t)seed : 1;
+}
+
+/*--------------------- TASKS -------------------------*/
+int xTaskCreatePinnedToCore(TaskFunction_t task, const char *, uint32_t, void *param, unsigned, void *, int)
+{
+  std::thread(task, param).detach();
+  return 1;
+}
+
+void vTaskDelay(uint32_t ticks)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+/*--------------------- LITTLEFS -------------------------*/
+LittleFSFS LittleFS;
+static std::string fsRoot = "data";
+static uint64_t fsBytesRead = 0;
+
+void hostSetFsRoot(const char *directory)
+{
+  fsRoot = directory;
+}
+
+const char *hostFsRoot()
+{
+  return fsRoot.c_str();
+}
+
+uint64_t hostFsBytesRead()
+{
+  return fsBytesRead;
+}
+
+int File::read()
+{
+  int value = fgetc(file);
+  if (value >= 0)
+    fsBytesRead++;
+  return value;
+}
+
+size_t File::read(uint8_t *buffer, size_t length)
+{
+  size_t got = fread(buffer, 1, length, file);
+  fsBytesRead += got;
+  return got;
+}
+
+bool File::seek(uint32_t position)
+{
+  return fseek(file, position, SEEK_SET) == 0;
+}
+
+size_t File::position()
+{
+  return ftell(file);
+}
+
+size_t File::size()
+{
+  long current = ftell(file);
+  fseek(file, 0, SEEK_END);
+  long end = ftell(file);
+  fseek(file, current, SEEK_SET);
+  return end;
+}
+
+void File::close()
+{
+  if (file)
+    fclose(file);
+  file = nullptr;
+}
+
+File LittleFSFS::open(const char *path, const char *mode)
+{
+  std::string full = fsRoot + (path[0] == '/' ? "" : "/") + path;
+  return File(fopen(full.c_str(), mode[0] == 'w' ? "wb" : "rb"));
+}
+
+bool LittleFSFS::exists(const char *path)
+{
+  File file = open(path, "r");
+  bool found = file;
+  file.close();
+  return found;
+}
+
+/*--------------------- PANEL -------------------------*/
+MatrixPanel_I2S_DMA::MatrixPanel_I2S_DMA(const HUB75_I2S_CFG &config)
+    : counters(), panelWidth(config.mx_width * config.chain_length), panelHeight(config.mx_height),
+      rotation(0), brightness(128), depth(PIXEL_COLOR_DEPTH_BITS)
+{
+  shadow = (uint8_t *)calloc((size_t)panelWidth * panelHeight, 3);
+}
+
+void MatrixPanel_I2S_DMA::setPixelColorDepthBits(uint8_t bits)
+{
+  depth = bits < 2 ? 2 : bits > PIXEL_COLOR_DEPTH_BITS ? PIXEL_COLOR_DEPTH_BITS : bits;
+}
+
+MatrixPanel_I2S_DMA::~MatrixPanel_I2S_DMA()
+{
+  free(shadow);
+}
+
+bool MatrixPanel_I2S_DMA::begin()
+{
+  return shadow != nullptr;
+}
+
+void MatrixPanel_I2S_DMA::setPhysical(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b)
+{
+  if (x < 0 || y < 0 || x >= panelWidth || y >= panelHeight)
+    return;
+  uint8_t *p = shadow + ((size_t)y * panelWidth + x) * 3;
+  p[0] = r;
+  p[1] = g;
+  p[2] = b;
+  counters.pixelWrites++;
+}
+
+// Map a logical (rotated) coordinate to the panel the way Adafruit GFX does
+void MatrixPanel_I2S_DMA::setLogical(int16_t x, int16_t y, uint16_t color)
+{
+  int16_t px = x, py = y;
+  switch (rotation)
+  {
+  case 1:
+    px = panelWidth - 1 - y;
+    py = x;
+    break;
+  case 2:
+    px = panelWidth - 1 - x;
+    py = panelHeight - 1 - y;
+    break;
+  case 3:
+    px = y;
+    py = panelHeight - 1 - x;
+    break;
+  }
+
+  uint8_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+  setPhysical(px, py, (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+void MatrixPanel_I2S_DMA::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  counters.drawCalls++;
+  setLogical(x, y, color);
+}
+
+void MatrixPanel_I2S_DMA::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  counters.drawCalls++;
+  for (int16_t i = 0; i < w; i++)
+    setLogical(x + i, y, color);
+}
+
+void MatrixPanel_I2S_DMA::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+  counters.drawCalls++;
+  for (int16_t i = 0; i < h; i++)
+    setLogical(x, y + i, color);
+}
+
+void MatrixPanel_I2S_DMA::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  counters.drawCalls++;
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      setLogical(x + i, y + j, color);
+}
+
+void MatrixPanel_I2S_DMA::fillScreen(uint16_t color)
+{
+  fillRect(0, 0, width(), height(), color);
+}
+
+void MatrixPanel_I2S_DMA::drawPixelRGB888(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b)
+{
+  counters.drawCalls++;
+  setPhysical(x, y, r, g, b);
+}
+
+void MatrixPanel_I2S_DMA::fillScreenRGB888(uint8_t r, uint8_t g, uint8_t b)
+{
+  counters.drawCalls++;
+  for (int16_t y = 0; y < panelHeight; y++)
+    for (int16_t x = 0; x < panelWidth; x++)
+      setPhysical(x, y, r, g, b);
+}
+
+void MatrixPanel_I2S_DMA::clearScreen()
+{
+  fillScreenRGB888(0, 0, 0);
+}
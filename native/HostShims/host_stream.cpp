@@ -0,0 +1,121 @@
+#include "host_stream.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+
+#define HOST_STREAM_POLL_MS 10
+#define HOST_STREAM_WAIT_MS 1000
+
+// Sender: encode each frame against the one before and push it through the host end
+static void sendFrames(HostStreamLink *link)
+{
+  size_t pixels = (size_t)link->width * link->height;
+  for (uint32_t i = 0; i < link->packets && !link->stop.load(); i++)
+  {
+    const uint16_t *frame = link->frames + (i % link->count) * pixels;
+    const uint16_t *previous = i ? link->frames + ((i - 1) % link->count) * pixels : nullptr;
+    size_t size = streamEncode(link->packet.data(), link->packet.size(), frame, previous, link->width, link->height,
+                               (uint8_t)i);
+
+    for (size_t sent = 0; sent < size && !link->stop.load();)
+    {
+      pollfd writable = {link->hostFd, POLLOUT, 0};
+      if (poll(&writable, 1, HOST_STREAM_POLL_MS) <= 0)
+        continue;
+      ssize_t n = write(link->hostFd, link->packet.data() + sent, size - sent);
+      if (n > 0)
+      {
+        sent += n;
+        link->bytesSent.fetch_add(n);
+      }
+    }
+  }
+}
+
+// Reader: the board's UART side, handing whatever arrived to the receiver and waiting
+// for the display side whenever both packet buffers are full
+static void readFrames(HostStreamLink *link)
+{
+  uint8_t chunk[4096];
+  while (!link->stop.load())
+  {
+    pollfd readable = {link->boardFd, POLLIN, 0};
+    if (poll(&readable, 1, HOST_STREAM_POLL_MS) <= 0)
+      continue;
+    ssize_t n = read(link->boardFd, chunk, sizeof(chunk));
+    if (n <= 0)
+      continue;
+
+    size_t done = streamReceive(&link->receiver, chunk, n);
+    while (done < (size_t)n && !link->stop.load())
+    {
+      std::this_thread::yield();
+      done += streamReceive(&link->receiver, chunk + done, n - done);
+    }
+  }
+}
+
+bool hostStreamStart(HostStreamLink *link, const uint16_t *frames, uint32_t count, uint16_t width, uint16_t height,
+                     uint32_t packets)
+{
+  link->frames = frames;
+  link->count = count;
+  link->width = width;
+  link->height = height;
+  link->packets = packets;
+  link->bytesSent.store(0);
+  link->stop.store(false);
+
+  link->hostFd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (link->hostFd < 0)
+    return false;
+  if (grantpt(link->hostFd) != 0 || unlockpt(link->hostFd) != 0 ||
+      (link->boardFd = open(ptsname(link->hostFd), O_RDWR | O_NOCTTY)) < 0)
+  {
+    close(link->hostFd);
+    return false;
+  }
+
+  // Raw mode: no echo, no line editing, no CR/LF translation
+  termios tio;
+  tcgetattr(link->boardFd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(link->boardFd, TCSANOW, &tio);
+  fcntl(link->hostFd, F_SETFL, O_NONBLOCK);
+  fcntl(link->boardFd, F_SETFL, O_NONBLOCK);
+
+  size_t capacity = streamMaxPacketSize(width, height);
+  link->packet.resize(capacity);
+  streamReceiverInit(&link->receiver, capacity - 2 - STREAM_HEADER_SIZE - STREAM_CRC_SIZE);
+  link->sender = std::thread(sendFrames, link);
+  link->reader = std::thread(readFrames, link);
+  return true;
+}
+
+const StreamPacket *hostStreamWait(HostStreamLink *link)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (;;)
+  {
+    const StreamPacket *packet = streamTake(&link->receiver);
+    if (packet)
+      return packet;
+    if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(HOST_STREAM_WAIT_MS))
+      return nullptr;
+    std::this_thread::yield();
+  }
+}
+
+void hostStreamStop(HostStreamLink *link)
+{
+  link->stop.store(true);
+  link->sender.join();
+  link->reader.join();
+  close(link->boardFd);
+  close(link->hostFd);
+  freeStreamReceiver(&link->receiver);
+}
@@ -0,0 +1,48 @@
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <frame_stream.h>
+
+// Serial frame streaming over a loopback link for native benchmarks. A pseudo-terminal
+// pair in raw mode stands in for the USB serial port: a sender thread encodes frames
+// (streamEncode) and writes them to the host end, a reader thread plays the board's UART
+// side and feeds the board end into a StreamReceiver. The kernel's small pty buffer
+// pushes back on the sender the way a full UART FIFO would, so the display side sees the
+// same double-buffered hand-over it gets on the board.
+
+struct HostStreamLink
+{
+  const uint16_t *frames; // count RGB565 frames of width x height, sent in a cycle
+  uint32_t count;
+  uint16_t width;
+  uint16_t height;
+  uint32_t packets; // Packets to send in all
+
+  StreamReceiver receiver;
+  int hostFd;
+  int boardFd;
+  std::thread sender;
+  std::thread reader;
+  std::vector<uint8_t> packet;
+  std::atomic<uint64_t> bytesSent;
+  std::atomic<bool> stop;
+};
+
+// Open the pty pair and start both threads: the first packet is the full first frame,
+// every later one the rectangle that changed since the frame before. Returns false if
+// no pty is available.
+bool hostStreamStart(HostStreamLink *link, const uint16_t *frames, uint32_t count, uint16_t width, uint16_t height,
+                     uint32_t packets);
+
+// Display side: wait for the next packet (nullptr if none arrives within a second).
+// Hand it back with streamRelease() as on the board.
+const StreamPacket *hostStreamWait(HostStreamLink *link);
+
+// Close the link and join both threads (unsent packets are dropped)
+void hostStreamStop(HostStreamLink *link);
+
+#endif
@@ -0,0 +1,106 @@
+#include "boot_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+
+static uint32_t platformNow(void *)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+#else
+#include <chrono>
+
+static uint32_t platformNow(void *)
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+// Slots in use (the counter can run past the end for a moment while a phase finds the
+// trace full)
+static uint8_t bootTraceCount(const BootTrace *trace)
+{
+  uint8_t count = trace->count.load(std::memory_order_relaxed);
+  return count < BOOT_TRACE_MAX_EVENTS ? count : BOOT_TRACE_MAX_EVENTS;
+}
+
+uint32_t bootTraceNow(const BootTrace *trace)
+{
+  return trace->now ? trace->now(trace->ctx) : platformNow(nullptr);
+}
+
+uint8_t bootPhaseBegin(BootTrace *trace, const char *name)
+{
+  uint8_t slot = trace->count.fetch_add(1, std::memory_order_relaxed);
+  if (slot >= BOOT_TRACE_MAX_EVENTS)
+  {
+    trace->count.store(BOOT_TRACE_MAX_EVENTS, std::memory_order_relaxed);
+    return BOOT_TRACE_FULL;
+  }
+  BootEvent *event = &trace->events[slot];
+  event->name = name;
+  event->startUs = bootTraceNow(trace);
+  event->endUs = event->startUs;
+  event->done = false;
+  return slot;
+}
+
+void bootPhaseEnd(BootTrace *trace, uint8_t phase)
+{
+  if (phase >= BOOT_TRACE_MAX_EVENTS)
+    return;
+  trace->events[phase].endUs = bootTraceNow(trace);
+  trace->events[phase].done = true;
+}
+
+void bootTraceMark(BootTrace *trace, const char *name)
+{
+  uint8_t slot = bootPhaseBegin(trace, name);
+  if (slot != BOOT_TRACE_FULL)
+    trace->events[slot].done = true; // Ends where it starts
+}
+
+const BootEvent *bootTraceFind(const BootTrace *trace, const char *name)
+{
+  uint8_t count = bootTraceCount(trace);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (trace->events[i].name && strcmp(trace->events[i].name, name) == 0)
+      return &trace->events[i];
+  }
+  return nullptr;
+}
+
+void bootTracePrint(const BootTrace *trace, BootTraceWriteFn write, void *ctx)
+{
+  uint8_t count = bootTraceCount(trace);
+
+  // Start order (phases on other tasks may have claimed their slots out of order)
+  uint8_t order[BOOT_TRACE_MAX_EVENTS];
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint8_t j = i;
+    for (; j > 0 && (int32_t)(trace->events[order[j - 1]].startUs - trace->events[i].startUs) > 0; j--)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+
+  char line[96];
+  int len = snprintf(line, sizeof(line), "boot,phase,start_us,end_us,duration_us\n");
+  write(ctx, (const uint8_t *)line, len);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    const BootEvent *event = &trace->events[order[i]];
+    if (event->done)
+      len = snprintf(line, sizeof(line), "boot,%s,%u,%u,%u\n", event->name, (unsigned)event->startUs,
+                     (unsigned)event->endUs, (unsigned)(event->endUs - event->startUs));
+    else
+      len = snprintf(line, sizeof(line), "boot,%s,%u,,\n", event->name, (unsigned)event->startUs); // Still running
+    write(ctx, (const uint8_t *)line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Boot-phase trace: when each step of setup() started and finished, up to the first
+// frame on the panel. Phases may run on different tasks at once (e.g. display bring-up
+// on one core while the filesystem mounts on the other); each claims its slot with an
+// atomic counter and only ever writes that slot. Read the trace once the phases are done.
+//
+// The clock is pluggable so a host run can record against a simulated clock. The
+// platform clock is esp_timer on the ESP32 (microseconds since the app started) and
+// std::chrono on a host.
+
+#define BOOT_TRACE_MAX_EVENTS 16
+#define BOOT_TRACE_FULL 0xFF // Returned by bootPhaseBegin() when every slot is taken
+
+// Microsecond timestamp (wraps after ~71 minutes; durations are modular)
+typedef uint32_t (*BootClockFn)(void *ctx);
+
+// Receives report text (e.g. Serial.write)
+typedef void (*BootTraceWriteFn)(void *ctx, const uint8_t *data, size_t length);
+
+struct BootEvent
+{
+  const char *name; // Static string
+  uint32_t startUs;
+  uint32_t endUs; // Equal to startUs for a mark
+  bool done;
+};
+
+// Start zero-initialised (`BootTrace trace = {};`); set `now` first to use another clock
+struct BootTrace
+{
+  BootClockFn now; // nullptr = platform clock
+  void *ctx;
+  BootEvent events[BOOT_TRACE_MAX_EVENTS];
+  std::atomic<uint8_t> count; // Slots claimed
+};
+
+// Current time on the trace's clock
+uint32_t bootTraceNow(const BootTrace *trace);
+
+// Start a phase; pass the result to bootPhaseEnd()
+uint8_t bootPhaseBegin(BootTrace *trace, const char *name);
+
+// Finish a phase (ignores BOOT_TRACE_FULL)
+void bootPhaseEnd(BootTrace *trace, uint8_t phase);
+
+// Record an instant, e.g. "first frame"
+void bootTraceMark(BootTrace *trace, const char *name);
+
+// First event called `name`, or nullptr
+const BootEvent *bootTraceFind(const BootTrace *trace, const char *name);
+
+// Write the trace as CSV: one line per event in start order, with its start and end
+// on the trace's clock and its duration
+void bootTracePrint(const BootTrace *trace, BootTraceWriteFn write, void *ctx);
+
+#endif
@@ -0,0 +1,131 @@
+#include "color_depth.h"
+
+#include <math.h>
+
+#define CLKS_DURING_LATCH 0 // The library latches on the last pixel clock
+#define DMA_DESCRIPTOR_BYTES 12 // lldesc_t
+
+// HUB75_I2S_CFG::clk_speed, slowest first
+static const uint32_t I2S_CLOCKS[] = {8000000, 10000000, 15000000, 20000000};
+
+void colorLevelsAddBytes(ColorLevels *levels, const uint8_t *data, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+    colorLevelsAdd(levels, data[i]);
+}
+
+void colorLevelsAddRGB565(ColorLevels *levels, const uint16_t *pixels, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    uint16_t color = pixels[i];
+    uint8_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+    colorLevelsAdd(levels, (r << 3) | (r >> 2));
+    colorLevelsAdd(levels, (g << 2) | (g >> 4));
+    colorLevelsAdd(levels, (b << 3) | (b >> 2));
+  }
+}
+
+void colorLevelsAddAll(ColorLevels *levels)
+{
+  for (int i = 0; i < 8; i++)
+    levels->used[i] = 0xFFFFFFFFu;
+}
+
+int colorLevelsCount(const ColorLevels *levels)
+{
+  int count = 0;
+  for (int i = 0; i < 256; i++)
+    count += colorLevelsHas(levels, i);
+  return count;
+}
+
+// The library's lumConvTab: 8-bit level to 16-bit PWM value through CIE 1931 lightness
+static uint16_t pwmValue(uint8_t level, bool cie1931)
+{
+  if (!cie1931)
+    return level << 8;
+  float lightness = level * 100.0f / 255.0f;
+  float luminance = lightness <= 8.0f ? lightness / 903.3f : powf((lightness + 16.0f) / 116.0f, 3.0f);
+  return (uint16_t)lroundf(luminance * 65535.0f);
+}
+
+uint8_t colorDepthForLevels(const ColorLevels *levels, uint8_t minBits, uint8_t maxBits, bool cie1931)
+{
+  for (uint8_t bits = minBits; bits < maxBits; bits++)
+  {
+    // The planes hold the top `bits` bits of the PWM value, which rises with the level,
+    // so it is enough to compare each used level with the one below it
+    bool shows = true;
+    int previous = -1;
+    for (int level = 0; level < 256 && shows; level++)
+    {
+      if (!colorLevelsHas(levels, level))
+        continue;
+      int shown = pwmValue(level, cie1931) >> (16 - bits);
+      shows = shown != previous && (level == 0 || shown > 0);
+      previous = shown;
+    }
+    if (shows)
+      return bits;
+  }
+  return maxBits;
+}
+
+ColorDepthTiming colorDepthTiming(const ColorDepthPanel *panel, uint8_t bits, uint32_t i2sHz, uint16_t minRefreshHz)
+{
+  ColorDepthTiming timing = {};
+  timing.bits = bits;
+  timing.i2sHz = i2sHz;
+
+  uint32_t pixelsPerRow = (uint32_t)panel->width * panel->chain;
+  uint32_t rows = panel->height / 2; // Two rows are clocked out at once
+  uint32_t psPerClock = (uint32_t)(1000000000000ULL / i2sHz);
+  uint32_t nsPerLatch = (uint32_t)((uint64_t)(pixelsPerRow + CLKS_DURING_LATCH) * psPerClock / 1000);
+
+  // Same search as the library: every plane goes out once, then each plane above the
+  // transition bit again 2^(i - t - 1) times, each repeat running on to the last plane
+  for (uint8_t transition = 0; transition < bits; transition++)
+  {
+    uint64_t nsPerRow = (uint64_t)bits * nsPerLatch;
+    for (uint8_t i = transition + 1; i < bits; i++)
+      nsPerRow += ((uint64_t)1 << (i - transition - 1)) * (bits - i) * nsPerLatch;
+    uint64_t nsPerFrame = nsPerRow * rows;
+
+    timing.transitionBit = transition;
+    timing.refreshHz = nsPerFrame ? (uint32_t)(1000000000ULL / nsPerFrame) : 0;
+    if (timing.refreshHz > minRefreshHz)
+      break;
+  }
+
+  // One descriptor for the whole row plus one per repeat, and the plane words themselves
+  uint32_t descriptorsPerRow = 1;
+  for (uint8_t i = timing.transitionBit + 1; i < bits; i++)
+    descriptorsPerRow += (uint32_t)1 << (i - timing.transitionBit - 1);
+  uint32_t wordBytes = rows * bits * (pixelsPerRow + CLKS_DURING_LATCH) * sizeof(uint16_t);
+  timing.dmaBytes = (wordBytes + descriptorsPerRow * rows * DMA_DESCRIPTOR_BYTES) * panel->frameBuffers;
+  return timing;
+}
+
+ColorDepthTiming colorDepthChoose(const ColorLevels *levels, const ColorDepthProfile *profile,
+                                  const ColorDepthPanel *panel)
+{
+  uint8_t minBits = profile->minBits < COLOR_DEPTH_MIN_BITS ? COLOR_DEPTH_MIN_BITS : profile->minBits;
+  uint8_t maxBits = profile->maxBits > COLOR_DEPTH_MAX_BITS ? COLOR_DEPTH_MAX_BITS : profile->maxBits;
+  if (maxBits < minBits)
+    maxBits = minBits;
+  uint8_t bits = colorDepthForLevels(levels, minBits, maxBits, panel->cie1931);
+
+  // A slower clock has cleaner edges; take the slowest that keeps the fastest one's
+  // plane weighting while still beating the refresh floor
+  ColorDepthTiming fastest = colorDepthTiming(panel, bits, profile->maxI2sHz, profile->minRefreshHz);
+  for (uint32_t clock : I2S_CLOCKS)
+  {
+    if (clock >= profile->maxI2sHz)
+      break;
+    ColorDepthTiming timing = colorDepthTiming(panel, bits, clock, profile->minRefreshHz);
+    if (timing.transitionBit <= fastest.transitionBit && timing.refreshHz > profile->minRefreshHz)
+      return timing;
+  }
+  return fastest;
+}
@@ -0,0 +1,96 @@
+#ifndef COLOR_DEPTH_H
+#define COLOR_DEPTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Picks the fewest colour bit planes the content needs and the panel clock to go with
+// them. The HUB75 library keeps every bit plane of every row pair in DMA memory and
+// clocks them out with binary code modulation: each plane is shown twice as long as the
+// one below it, so 8 planes of pure black and white take 255 row passes where 3 would
+// do. Fewer planes cost less DMA memory and leave refresh headroom, which buys a slower,
+// cleaner I2S clock at the same refresh rate.
+//
+// Everything here is a pure function of the content and the panel config with no
+// Arduino dependencies, so a host can check the choice. Timing and memory follow the
+// library's own estimate in its DMA setup (lsbMsbTransitionBit); the board may differ
+// by its descriptor overheads.
+
+#define COLOR_DEPTH_MIN_BITS 2  // The library's lowest setting
+#define COLOR_DEPTH_MAX_BITS 12 // PIXEL_COLOR_DEPTH_BITS_MAX
+
+// Channel levels (0-255) some content uses, one bit each
+struct ColorLevels
+{
+  uint32_t used[8];
+};
+
+#define COLOR_LEVELS_INIT {{0, 0, 0, 0, 0, 0, 0, 0}}
+
+inline void colorLevelsAdd(ColorLevels *levels, uint8_t level)
+{
+  levels->used[level >> 5] |= (uint32_t)1 << (level & 31);
+}
+
+inline bool colorLevelsHas(const ColorLevels *levels, uint8_t level)
+{
+  return levels->used[level >> 5] & ((uint32_t)1 << (level & 31));
+}
+
+// Every byte is a channel level: RGB888, planar or interleaved
+void colorLevelsAddBytes(ColorLevels *levels, const uint8_t *data, size_t count);
+
+// RGB565 pixels, each channel expanded to 8 bits the way the library's drawPixel does
+void colorLevelsAddRGB565(ColorLevels *levels, const uint16_t *pixels, size_t count);
+
+// All 256 levels, for content that fades or blends through levels it does not store
+void colorLevelsAddAll(ColorLevels *levels);
+
+int colorLevelsCount(const ColorLevels *levels);
+
+// Fewest bit planes (minBits..maxBits) at which every level the content uses still shows
+// as itself: no two used levels end up on the same output and no used non-zero level
+// goes dark. `cie1931` must match the library build (false with NO_CIE1931).
+uint8_t colorDepthForLevels(const ColorLevels *levels, uint8_t minBits, uint8_t maxBits, bool cie1931 = true);
+
+// The chain as HUB75_I2S_CFG describes it
+struct ColorDepthPanel
+{
+  uint16_t width;       // mx_width: one panel
+  uint16_t height;      // mx_height
+  uint16_t chain;       // chain_length
+  uint8_t frameBuffers; // 2 with double_buff
+  bool cie1931;
+};
+
+// Per-sketch limits
+struct ColorDepthProfile
+{
+  uint8_t minBits;       // Floor, e.g. for fades that pass through every level
+  uint8_t maxBits;       // Ceiling, at most what the library is built for
+  uint16_t minRefreshHz; // min_refresh_rate
+  uint32_t maxI2sHz;     // Fastest clock the wiring is reliable at (a HUB75_I2S_CFG::clk_speed)
+};
+
+// The library's settings for one depth and clock, and what they give
+struct ColorDepthTiming
+{
+  uint8_t bits;
+  uint8_t transitionBit; // Planes up to this one are shown once each (0 = exact BCM)
+  uint32_t i2sHz;
+  uint32_t refreshHz;
+  uint32_t dmaBytes; // Bit-plane words and descriptors, all frame buffers
+};
+
+// What the library does at `bits` planes and `i2sHz`: it raises the transition bit, which
+// cuts the repeats of the upper planes at the cost of the lower ones' weighting, until
+// the refresh rate beats minRefreshHz or there are no planes left to cut
+ColorDepthTiming colorDepthTiming(const ColorDepthPanel *panel, uint8_t bits, uint32_t i2sHz, uint16_t minRefreshHz);
+
+// The controller: the fewest planes the content needs within the profile, then the
+// slowest of the library's I2S clocks up to maxI2sHz whose transition bit is no worse
+// than the fastest allowed clock's
+ColorDepthTiming colorDepthChoose(const ColorLevels *levels, const ColorDepthProfile *profile,
+                                  const ColorDepthPanel *panel);
+
+#endif
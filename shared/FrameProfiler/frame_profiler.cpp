@@ -0,0 +1,232 @@
+#include "frame_profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef FRAME_PROFILER
+
+static const char *const stageNames[PROFILE_STAGE_COUNT] = {"load", "glitch", "blend", "convert", "present", "frame"};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+uint32_t profilerNow()
+{
+  return ESP.getCycleCount();
+}
+
+static uint32_t ticksPerUs()
+{
+  return getCpuFrequencyMhz();
+}
+
+// Internal RAM is where fragmentation hurts (DMA buffers, task stacks)
+static void sampleHeap(uint32_t *freeBytes, uint32_t *largestBlock)
+{
+  *freeBytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  *largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+#else
+#include <chrono>
+
+uint32_t profilerNow()
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static uint32_t ticksPerUs()
+{
+  return 1000;
+}
+
+// No heap introspection on a host
+static void sampleHeap(uint32_t *freeBytes, uint32_t *largestBlock)
+{
+  *freeBytes = 0;
+  *largestBlock = 0;
+}
+#endif
+
+static FrameProfiler profiler;
+static uint32_t tickScale = 0; // Ticks per microsecond, read once
+
+static void resetWindow(ProfileWindow *window)
+{
+  memset(window, 0, sizeof(*window));
+  window->minFreeHeap = UINT32_MAX;
+  window->minLargestBlock = UINT32_MAX;
+}
+
+void profilerReset()
+{
+  for (int i = 0; i < PROFILER_WINDOWS; i++)
+    resetWindow(&profiler.windows[i]);
+  profiler.current = 0;
+  profiler.completed = 0;
+  profiler.heap.freeBytes = 0;
+  profiler.heap.freeLowWater = UINT32_MAX;
+  profiler.heap.largestBlock = 0;
+  profiler.heap.largestLowWater = UINT32_MAX;
+  tickScale = ticksPerUs();
+}
+
+// Histogram bucket: 0 for <1 us, then one per power of two
+static uint8_t bucketFor(uint32_t us)
+{
+  if (us == 0)
+    return 0;
+  uint8_t bucket = 32 - __builtin_clz(us);
+  return bucket < PROFILER_BUCKETS ? bucket : PROFILER_BUCKETS - 1;
+}
+
+void profilerRecord(ProfileStage stage, uint32_t ticks)
+{
+  if (!tickScale)
+    profilerReset();
+
+  uint32_t us = ticks / tickScale;
+  ProfileWindow &window = profiler.windows[profiler.current];
+  window.samples[stage]++;
+  window.totalUs[stage] += us;
+  if (us > window.maxUs[stage])
+    window.maxUs[stage] = us;
+
+  uint16_t &count = window.histogram[stage][bucketFor(us)];
+  if (count < UINT16_MAX)
+    count++;
+}
+
+void profilerFrameEnd()
+{
+  if (!tickScale)
+    profilerReset();
+
+  HeapTelemetry &heap = profiler.heap;
+  sampleHeap(&heap.freeBytes, &heap.largestBlock);
+  if (heap.freeBytes < heap.freeLowWater)
+    heap.freeLowWater = heap.freeBytes;
+  if (heap.largestBlock < heap.largestLowWater)
+    heap.largestLowWater = heap.largestBlock;
+
+  ProfileWindow &window = profiler.windows[profiler.current];
+  if (heap.freeBytes < window.minFreeHeap)
+    window.minFreeHeap = heap.freeBytes;
+  if (heap.largestBlock < window.minLargestBlock)
+    window.minLargestBlock = heap.largestBlock;
+
+  // Close the window and start reusing the oldest one
+  if (++window.frames >= PROFILER_WINDOW_FRAMES)
+  {
+    profiler.current = (profiler.current + 1) % PROFILER_WINDOWS;
+    resetWindow(&profiler.windows[profiler.current]);
+    if (profiler.completed < PROFILER_WINDOWS - 1)
+      profiler.completed++;
+  }
+}
+
+const FrameProfiler *profilerState()
+{
+  return &profiler;
+}
+
+// Ring position of the i-th window to report, oldest first (the one being filled last)
+static const ProfileWindow *reportWindow(uint8_t i)
+{
+  uint8_t oldest = (profiler.current + PROFILER_WINDOWS - profiler.completed) % PROFILER_WINDOWS;
+  return &profiler.windows[(oldest + i) % PROFILER_WINDOWS];
+}
+
+static void writeLine(ProfilerWriteFn write, void *ctx, const char *line)
+{
+  write(ctx, (const uint8_t *)line, strlen(line));
+}
+
+void profilerDumpCsv(ProfilerWriteFn write, void *ctx)
+{
+  char line[256];
+  int len = snprintf(line, sizeof(line), "window,frames,stage,samples,mean_us,max_us");
+  for (int b = 0; b < PROFILER_BUCKETS; b++)
+    len += snprintf(line + len, sizeof(line) - len, ",h%d", b);
+  snprintf(line + len, sizeof(line) - len, "\n");
+  writeLine(write, ctx, line);
+
+  for (uint8_t i = 0; i <= profiler.completed; i++)
+  {
+    const ProfileWindow *window = reportWindow(i);
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++)
+    {
+      if (!window->samples[s])
+        continue;
+      len = snprintf(line, sizeof(line), "%u,%u,%s,%u,%u,%u", (unsigned)i, (unsigned)window->frames,
+                     stageNames[s], (unsigned)window->samples[s],
+                     (unsigned)(window->totalUs[s] / window->samples[s]), (unsigned)window->maxUs[s]);
+      for (int b = 0; b < PROFILER_BUCKETS; b++)
+        len += snprintf(line + len, sizeof(line) - len, ",%u", (unsigned)window->histogram[s][b]);
+      snprintf(line + len, sizeof(line) - len, "\n");
+      writeLine(write, ctx, line);
+    }
+  }
+
+  const HeapTelemetry &heap = profiler.heap;
+  snprintf(line, sizeof(line), "heap,free,free_low,largest,largest_low\nheap,%u,%u,%u,%u\n",
+           (unsigned)heap.freeBytes, (unsigned)heap.freeLowWater, (unsigned)heap.largestBlock,
+           (unsigned)heap.largestLowWater);
+  writeLine(write, ctx, line);
+}
+
+void profilerDumpBinary(ProfilerWriteFn write, void *ctx)
+{
+  uint32_t magic = PROFILER_MAGIC;
+  uint8_t header[4] = {PROFILE_STAGE_COUNT, PROFILER_BUCKETS, (uint8_t)(profiler.completed + 1), PROFILER_WINDOW_FRAMES};
+  write(ctx, (const uint8_t *)&magic, sizeof(magic));
+  write(ctx, header, sizeof(header));
+  for (uint8_t i = 0; i <= profiler.completed; i++)
+    write(ctx, (const uint8_t *)reportWindow(i), sizeof(ProfileWindow));
+  write(ctx, (const uint8_t *)&profiler.heap, sizeof(profiler.heap));
+}
+
+#else
+
+uint32_t profilerNow()
+{
+  return 0;
+}
+
+void profilerRecord(ProfileStage, uint32_t) {}
+void profilerFrameEnd() {}
+void profilerReset() {}
+
+const FrameProfiler *profilerState()
+{
+  return nullptr;
+}
+
+void profilerDumpCsv(ProfilerWriteFn write, void *ctx)
+{
+  const char *line = "# profiler disabled (build with -DFRAME_PROFILER)\n";
+  write(ctx, (const uint8_t *)line, strlen(line));
+}
+
+void profilerDumpBinary(ProfilerWriteFn, void *) {}
+
+#endif
+
+bool profilerHandleCommand(char command, ProfilerWriteFn write, void *ctx)
+{
+  switch (command)
+  {
+  case 'p':
+    profilerDumpCsv(write, ctx);
+    return true;
+  case 'b':
+    profilerDumpBinary(write, ctx);
+    return true;
+  case 'r':
+    profilerReset();
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,117 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-stage frame profiler. Stage timings go into log2 latency histograms, one set per
+// window of PROFILER_WINDOW_FRAMES frames, kept in a ring of the last PROFILER_WINDOWS
+// windows. Heap free size and largest free block are sampled once per frame with
+// their low-water marks. A report is written on request as CSV or packed binary.
+//
+// Define FRAME_PROFILER to enable. Without it the PROFILE_* macros expand to nothing
+// and the functions below do nothing, so instrumentation can stay in the code.
+//
+// Timing uses the CPU cycle counter on the ESP32 and std::chrono on a host. Each stage
+// should be recorded from one task only; samples that land while another task closes a
+// window may be counted in either window.
+
+enum ProfileStage : uint8_t
+{
+  PROFILE_LOAD,    // Image decode / load
+  PROFILE_GLITCH,  // Glitch composition
+  PROFILE_BLEND,   // Fades and crossfades
+  PROFILE_CONVERT, // Framebuffer -> RGB565 conversion
+  PROFILE_PRESENT, // Display writes
+  PROFILE_FRAME,   // Whole frame
+  PROFILE_STAGE_COUNT
+};
+
+#define PROFILER_BUCKETS 16       // [0,1) [1,2) [2,4) ... [16384,inf) microseconds
+#define PROFILER_WINDOWS 8        // Windows kept in the ring
+#define PROFILER_WINDOW_FRAMES 60 // Frames per window (1 s at 60 FPS)
+
+// Timings for one window of frames
+struct ProfileWindow
+{
+  uint32_t frames;
+  uint32_t samples[PROFILE_STAGE_COUNT];
+  uint32_t totalUs[PROFILE_STAGE_COUNT];
+  uint32_t maxUs[PROFILE_STAGE_COUNT];
+  uint16_t histogram[PROFILE_STAGE_COUNT][PROFILER_BUCKETS];
+  uint32_t minFreeHeap;     // Lowest free heap seen in this window
+  uint32_t minLargestBlock; // Lowest largest-free-block seen in this window
+};
+
+struct HeapTelemetry
+{
+  uint32_t freeBytes;       // Last sample
+  uint32_t freeLowWater;    // Lowest since boot (or reset)
+  uint32_t largestBlock;    // Last sample
+  uint32_t largestLowWater; // Lowest since boot (or reset)
+};
+
+struct FrameProfiler
+{
+  ProfileWindow windows[PROFILER_WINDOWS]; // Ring; windows[current] is being filled
+  uint8_t current;
+  uint8_t completed; // Finished windows in the ring (saturates at PROFILER_WINDOWS - 1)
+  HeapTelemetry heap;
+};
+
+// Receives report bytes (e.g. Serial.write)
+typedef void (*ProfilerWriteFn)(void *ctx, const uint8_t *data, size_t length);
+
+// Platform timestamp in profiler ticks (CPU cycles or nanoseconds)
+uint32_t profilerNow();
+
+// Record `ticks` (a difference of profilerNow() values) against a stage
+void profilerRecord(ProfileStage stage, uint32_t ticks);
+
+// Sample the heap and close the window after PROFILER_WINDOW_FRAMES frames. Call once
+// per frame.
+void profilerFrameEnd();
+
+// Clear all windows and low-water marks
+void profilerReset();
+
+// Write the report: CSV (one line per window and stage, then the heap line) or binary
+// (PROFILER_MAGIC, header, the raw ProfileWindow ring oldest first, HeapTelemetry)
+void profilerDumpCsv(ProfilerWriteFn write, void *ctx);
+void profilerDumpBinary(ProfilerWriteFn write, void *ctx);
+
+// Serial command: 'p' CSV report, 'b' binary report, 'r' reset. Returns true if handled.
+bool profilerHandleCommand(char command, ProfilerWriteFn write, void *ctx);
+
+// The live profiler state
+const FrameProfiler *profilerState();
+
+#define PROFILER_MAGIC 0x31465250 // "PRF1"
+
+#ifdef FRAME_PROFILER
+// Times the rest of the enclosing block against `stage`
+class ProfileScope
+{
+public:
+  explicit ProfileScope(ProfileStage stage) : stage(stage), start(profilerNow()) {}
+  ~ProfileScope() { profilerRecord(stage, profilerNow() - start); }
+
+private:
+  ProfileStage stage;
+  uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(stage)
+#define PROFILE_NOW() profilerNow()
+#define PROFILE_RECORD(stage, ticks) profilerRecord(stage, ticks)
+#define PROFILE_FRAME_END() profilerFrameEnd()
+#else
+#define PROFILE_SCOPE(stage)
+#define PROFILE_NOW() 0u
+#define PROFILE_RECORD(stage, ticks) ((void)(ticks))
+#define PROFILE_FRAME_END() ((void)0)
+#endif
+
+#endif
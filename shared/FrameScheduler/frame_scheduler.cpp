@@ -0,0 +1,136 @@
+#include "frame_scheduler.h"
+
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+
+static uint32_t platformNow(void *)
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+// Sleep whole RTOS ticks while the deadline is far away (letting other tasks run),
+// then busy-wait the final sub-tick remainder so the wake-up lands on the deadline.
+static void platformWaitUntil(void *, uint32_t deadlineUs)
+{
+  const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+  int32_t remaining = (int32_t)(deadlineUs - platformNow(nullptr));
+
+  if (remaining > (int32_t)tickUs)
+    vTaskDelay((remaining - tickUs) / tickUs);
+
+  remaining = (int32_t)(deadlineUs - platformNow(nullptr));
+  if (remaining > 0)
+    delayMicroseconds(remaining);
+}
+#else
+#include <chrono>
+#include <thread>
+
+static uint32_t platformNow(void *)
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void platformWaitUntil(void *, uint32_t deadlineUs)
+{
+  int32_t remaining = (int32_t)(deadlineUs - platformNow(nullptr));
+  if (remaining > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(remaining));
+}
+#endif
+
+void frameSchedulerInit(FrameScheduler *scheduler, uint16_t targetFps, const SchedulerClock *clock)
+{
+  memset(scheduler, 0, sizeof(*scheduler));
+  if (clock)
+    scheduler->clock = *clock;
+  else
+    scheduler->clock = {platformNow, platformWaitUntil, nullptr};
+  frameSchedulerSetRate(scheduler, targetFps);
+  frameSchedulerResetStats(scheduler);
+}
+
+void frameSchedulerSetRate(FrameScheduler *scheduler, uint16_t targetFps)
+{
+  scheduler->periodUs = 1000000UL / (targetFps ? targetFps : 1);
+}
+
+uint32_t frameSchedulerBeginFrame(FrameScheduler *scheduler)
+{
+  SchedulerClock &clock = scheduler->clock;
+  uint32_t now = clock.now(clock.ctx);
+
+  // First frame starts immediately and anchors the timeline
+  if (!scheduler->started)
+  {
+    scheduler->started = true;
+    scheduler->nextDeadlineUs = now;
+  }
+
+  uint32_t dropped = 0;
+  int32_t late = (int32_t)(now - scheduler->nextDeadlineUs);
+
+  if (late < 0)
+  {
+    // Early: wait for the absolute deadline
+    clock.waitUntil(clock.ctx, scheduler->nextDeadlineUs);
+    now = clock.now(clock.ctx);
+    late = (int32_t)(now - scheduler->nextDeadlineUs);
+    if (late < 0)
+      late = 0;
+  }
+  else if ((uint32_t)late >= scheduler->periodUs)
+  {
+    // Overran past whole frame slots: drop them rather than bursting to catch up
+    dropped = (uint32_t)late / scheduler->periodUs;
+    scheduler->nextDeadlineUs += dropped * scheduler->periodUs;
+    late -= dropped * scheduler->periodUs;
+    scheduler->stats.droppedFrames += dropped;
+    scheduler->stats.overruns++;
+  }
+
+  FrameStats &stats = scheduler->stats;
+  stats.frames++;
+  stats.lastJitterUs = (uint32_t)late;
+  stats.totalJitterUs += (uint32_t)late;
+  if ((uint32_t)late > stats.maxJitterUs)
+    stats.maxJitterUs = (uint32_t)late;
+
+  scheduler->frameStartUs = now;
+  scheduler->nextDeadlineUs += scheduler->periodUs;
+  return dropped;
+}
+
+void frameSchedulerEndFrame(FrameScheduler *scheduler)
+{
+  FrameStats &stats = scheduler->stats;
+  uint32_t elapsed = scheduler->clock.now(scheduler->clock.ctx) - scheduler->frameStartUs;
+
+  stats.lastFrameUs = elapsed;
+  stats.totalFrameUs += elapsed;
+  if (elapsed < stats.minFrameUs)
+    stats.minFrameUs = elapsed;
+  if (elapsed > stats.maxFrameUs)
+    stats.maxFrameUs = elapsed;
+}
+
+void frameSchedulerResetStats(FrameScheduler *scheduler)
+{
+  memset(&scheduler->stats, 0, sizeof(scheduler->stats));
+  scheduler->stats.minFrameUs = UINT32_MAX;
+}
+
+uint32_t frameSchedulerAverageFrameUs(const FrameScheduler *scheduler)
+{
+  return scheduler->stats.frames ? (uint32_t)(scheduler->stats.totalFrameUs / scheduler->stats.frames) : 0;
+}
+
+uint32_t frameSchedulerAverageJitterUs(const FrameScheduler *scheduler)
+{
+  return scheduler->stats.frames ? (uint32_t)(scheduler->stats.totalJitterUs / scheduler->stats.frames) : 0;
+}
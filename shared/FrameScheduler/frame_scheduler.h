@@ -0,0 +1,69 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <stdint.h>
+
+// Monotonic time source in microseconds (wraps after ~71 minutes; all maths is modular)
+typedef uint32_t (*SchedulerNowFn)(void *ctx);
+
+// Block until the absolute time `deadlineUs` on the same clock
+typedef void (*SchedulerWaitFn)(void *ctx, uint32_t deadlineUs);
+
+// Pluggable clock, so the scheduler can run against a fake clock on a host
+struct SchedulerClock
+{
+  SchedulerNowFn now;
+  SchedulerWaitFn waitUntil;
+  void *ctx;
+};
+
+// Running frame statistics
+struct FrameStats
+{
+  uint32_t frames;        // Frames started
+  uint32_t droppedFrames; // Frame slots skipped because a frame overran
+  uint32_t overruns;      // Frames that started a whole period or more late (slots dropped)
+  uint32_t lastFrameUs;   // Render time of the last frame (beginFrame -> endFrame)
+  uint32_t minFrameUs;
+  uint32_t maxFrameUs;
+  uint64_t totalFrameUs;
+  uint32_t lastJitterUs;  // How late the last frame started against its deadline
+  uint32_t maxJitterUs;
+  uint64_t totalJitterUs;
+};
+
+// Fixed-timestep scheduler: frames start on absolute deadlines one period apart, so
+// render time does not accumulate into drift. When a frame overruns past one or more
+// deadlines those slots are dropped explicitly and counted.
+struct FrameScheduler
+{
+  SchedulerClock clock;
+  uint32_t periodUs;       // 1e6 / target rate
+  uint32_t nextDeadlineUs; // Absolute start time of the next frame
+  uint32_t frameStartUs;   // Start time of the frame in progress
+  bool started;
+  FrameStats stats;
+};
+
+// Initialise for `targetFps` frames per second. Pass nullptr for the platform clock
+// (esp_timer + FreeRTOS delay on the ESP32, std::chrono on a host).
+void frameSchedulerInit(FrameScheduler *scheduler, uint16_t targetFps, const SchedulerClock *clock = nullptr);
+
+// Change the target rate; takes effect from the next deadline
+void frameSchedulerSetRate(FrameScheduler *scheduler, uint16_t targetFps);
+
+// Wait for this frame's deadline. Returns the number of frame slots dropped before it
+// (0 when on schedule).
+uint32_t frameSchedulerBeginFrame(FrameScheduler *scheduler);
+
+// Mark the end of the frame's work and record its render time
+void frameSchedulerEndFrame(FrameScheduler *scheduler);
+
+// Clear the running statistics
+void frameSchedulerResetStats(FrameScheduler *scheduler);
+
+// Mean render time and mean start jitter over the frames since the last reset
+uint32_t frameSchedulerAverageFrameUs(const FrameScheduler *scheduler);
+uint32_t frameSchedulerAverageJitterUs(const FrameScheduler *scheduler);
+
+#endif
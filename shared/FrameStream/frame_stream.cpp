@@ -0,0 +1,411 @@
+#include "frame_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Parser states of the receive side
+enum StreamState : uint8_t
+{
+  STREAM_HUNT,    // Looking for the first sync byte
+  STREAM_SYNC,    // Seen the first sync byte
+  STREAM_HEADER,
+  STREAM_PAYLOAD,
+  STREAM_CHECK    // CRC bytes
+};
+
+// CRC-32 (reflected, polynomial 0xEDB88320) four bits at a time: a 64-byte table
+uint32_t streamCrc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+  static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                     0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                     0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static inline uint16_t le16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put16(uint8_t *p, uint16_t value)
+{
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t value)
+{
+  put16(p, value & 0xFFFF);
+  put16(p + 2, value >> 16);
+}
+
+bool streamReceiverInit(StreamReceiver *receiver, uint32_t capacity, StreamByteFn stray, void *strayCtx)
+{
+  memset(receiver->packets, 0, sizeof(receiver->packets));
+  for (int i = 0; i < 2; i++)
+  {
+    receiver->packets[i].payload = (uint8_t *)malloc(capacity ? capacity : 1);
+    receiver->ready[i].store(false);
+  }
+  receiver->capacity = capacity;
+  receiver->stray = stray;
+  receiver->strayCtx = strayCtx;
+  receiver->filling = 0;
+  receiver->state = STREAM_HUNT;
+  receiver->received = 0;
+  receiver->crc = 0;
+  receiver->stalled = false;
+  receiver->packetsReceived = 0;
+  receiver->crcErrors = 0;
+  receiver->badPackets = 0;
+  receiver->stalls = 0;
+  receiver->sequenceGaps = 0;
+  receiver->bytesReceived = 0;
+  receiver->lastSequence = -1;
+  receiver->taking = 0;
+
+  if (!receiver->packets[0].payload || !receiver->packets[1].payload)
+  {
+    freeStreamReceiver(receiver);
+    return false;
+  }
+  return true;
+}
+
+void freeStreamReceiver(StreamReceiver *receiver)
+{
+  for (int i = 0; i < 2; i++)
+  {
+    free(receiver->packets[i].payload);
+    receiver->packets[i].payload = nullptr;
+  }
+}
+
+static inline void passStray(StreamReceiver *receiver, uint8_t byte)
+{
+  if (receiver->stray)
+    receiver->stray(receiver->strayCtx, byte);
+}
+
+// Header fields of the packet being received
+static inline uint8_t headerType(const StreamReceiver *receiver)
+{
+  return receiver->header[0] & ~STREAM_RLE;
+}
+
+static inline uint32_t headerLength(const StreamReceiver *receiver)
+{
+  return le32(receiver->header + 10);
+}
+
+// A header whose payload cannot match its rectangle is dropped before its payload arrives
+static bool headerValid(const StreamReceiver *receiver)
+{
+  uint8_t type = headerType(receiver);
+  uint32_t pixels = (uint32_t)le16(receiver->header + 6) * le16(receiver->header + 8);
+  uint32_t length = headerLength(receiver);
+  if (type != STREAM_FULL && type != STREAM_RECT)
+    return false;
+  if (length > receiver->capacity)
+    return false;
+  if (receiver->header[0] & STREAM_RLE)
+    return length % 3 == 0 && length <= pixels * 3 && (length > 0) == (pixels > 0);
+  return length == pixels * 2;
+}
+
+// CRC matched: publish the filled buffer to the display side
+static void publish(StreamReceiver *receiver)
+{
+  StreamPacket *packet = &receiver->packets[receiver->filling];
+  const uint8_t *h = receiver->header;
+  packet->type = headerType(receiver);
+  packet->rle = h[0] & STREAM_RLE;
+  packet->sequence = h[1];
+  packet->x = le16(h + 2);
+  packet->y = le16(h + 4);
+  packet->w = le16(h + 6);
+  packet->h = le16(h + 8);
+  packet->length = headerLength(receiver);
+
+  if (receiver->lastSequence >= 0)
+    receiver->sequenceGaps += (uint8_t)(packet->sequence - receiver->lastSequence - 1);
+  receiver->lastSequence = packet->sequence;
+  receiver->packetsReceived++;
+  receiver->bytesReceived += 2 + STREAM_HEADER_SIZE + packet->length + STREAM_CRC_SIZE;
+
+  receiver->ready[receiver->filling].store(true, std::memory_order_release);
+  receiver->filling ^= 1;
+}
+
+size_t streamReceive(StreamReceiver *receiver, const uint8_t *data, size_t length)
+{
+  size_t i = 0;
+  while (i < length)
+  {
+    switch (receiver->state)
+    {
+    case STREAM_HUNT:
+    {
+      uint8_t byte = data[i++];
+      if (byte == STREAM_SYNC0)
+        receiver->state = STREAM_SYNC;
+      else
+        passStray(receiver, byte);
+      break;
+    }
+
+    case STREAM_SYNC:
+    {
+      uint8_t byte = data[i++];
+      if (byte == STREAM_SYNC1)
+      {
+        receiver->state = STREAM_HEADER;
+        receiver->received = 0;
+        break;
+      }
+      // The first sync byte was not a packet after all
+      passStray(receiver, STREAM_SYNC0);
+      if (byte != STREAM_SYNC0)
+      {
+        passStray(receiver, byte);
+        receiver->state = STREAM_HUNT;
+      }
+      break;
+    }
+
+    case STREAM_HEADER:
+    {
+      size_t take = STREAM_HEADER_SIZE - receiver->received;
+      if (take > length - i)
+        take = length - i;
+      memcpy(receiver->header + receiver->received, data + i, take);
+      receiver->received += take;
+      i += take;
+      if (receiver->received < STREAM_HEADER_SIZE)
+        break;
+
+      if (!headerValid(receiver))
+      {
+        receiver->badPackets++;
+        receiver->state = STREAM_HUNT;
+        break;
+      }
+      receiver->crc = streamCrc32(0, receiver->header, STREAM_HEADER_SIZE);
+      receiver->received = 0;
+      receiver->state = STREAM_PAYLOAD;
+      break;
+    }
+
+    case STREAM_PAYLOAD:
+    {
+      // The buffer is still being shown: leave the rest of the input for later
+      if (receiver->ready[receiver->filling].load(std::memory_order_acquire))
+      {
+        if (!receiver->stalled)
+          receiver->stalls++;
+        receiver->stalled = true;
+        return i;
+      }
+      receiver->stalled = false;
+
+      uint32_t total = headerLength(receiver);
+      size_t take = total - receiver->received;
+      if (take > length - i)
+        take = length - i;
+      uint8_t *payload = receiver->packets[receiver->filling].payload + receiver->received;
+      memcpy(payload, data + i, take);
+      receiver->crc = streamCrc32(receiver->crc, payload, take);
+      receiver->received += take;
+      i += take;
+      if (receiver->received == total)
+      {
+        receiver->received = 0;
+        receiver->state = STREAM_CHECK;
+      }
+      break;
+    }
+
+    case STREAM_CHECK:
+    {
+      receiver->crcBytes[receiver->received++] = data[i++];
+      if (receiver->received < STREAM_CRC_SIZE)
+        break;
+
+      if (le32(receiver->crcBytes) == receiver->crc)
+        publish(receiver);
+      else
+        receiver->crcErrors++;
+      receiver->state = STREAM_HUNT;
+      break;
+    }
+    }
+  }
+
+  // A packet with no payload owns no buffer until its CRC arrives; nothing to wait for
+  return i;
+}
+
+const StreamPacket *streamTake(StreamReceiver *receiver)
+{
+  if (!receiver->ready[receiver->taking].load(std::memory_order_acquire))
+    return nullptr;
+  return &receiver->packets[receiver->taking];
+}
+
+void streamRelease(StreamReceiver *receiver)
+{
+  receiver->ready[receiver->taking].store(false, std::memory_order_release);
+  receiver->taking ^= 1;
+}
+
+bool streamApply(const StreamPacket *packet, uint16_t *pixels, uint16_t stride, uint16_t width, uint16_t height)
+{
+  if (packet->x + packet->w > width || packet->y + packet->h > height)
+    return false;
+  if (packet->type == STREAM_FULL && (packet->x || packet->y || packet->w != width || packet->h != height))
+    return false;
+
+  const uint8_t *in = packet->payload;
+  if (!packet->rle)
+  {
+    // Little-endian RGB565 on a little-endian target: the bytes are the pixels
+    for (uint16_t y = 0; y < packet->h; y++, in += packet->w * 2)
+      memcpy(pixels + (size_t)(packet->y + y) * stride + packet->x, in, packet->w * 2);
+    return true;
+  }
+
+  const uint8_t *end = in + packet->length;
+  uint16_t x = 0, y = 0;
+  uint16_t *row = pixels + (size_t)packet->y * stride + packet->x;
+  for (; in < end; in += 3)
+  {
+    uint16_t color = le16(in + 1);
+    for (int count = in[0] + 1; count > 0; count--)
+    {
+      if (y == packet->h)
+        return false;
+      row[x] = color;
+      if (++x == packet->w)
+      {
+        x = 0;
+        y++;
+        row += stride;
+      }
+    }
+  }
+  return y == packet->h;
+}
+
+// Bytes the rectangle takes as runs of up to 256 pixels, row-major
+static size_t rleSize(const uint16_t *frame, uint16_t width, uint16_t x0, uint16_t y0, uint16_t w, uint16_t h)
+{
+  size_t size = 0;
+  int run = 0;
+  uint16_t color = 0;
+  for (uint16_t y = y0; y < y0 + h; y++)
+  {
+    for (uint16_t x = x0; x < x0 + w; x++)
+    {
+      uint16_t pixel = frame[(size_t)y * width + x];
+      if (run && pixel == color && run < 256)
+      {
+        run++;
+        continue;
+      }
+      size += 3;
+      color = pixel;
+      run = 1;
+    }
+  }
+  return size;
+}
+
+size_t streamEncode(uint8_t *out, size_t capacity, const uint16_t *frame, const uint16_t *previous, uint16_t width,
+                    uint16_t height, uint8_t sequence)
+{
+  // Bounding box of the changes
+  uint16_t x0 = 0, y0 = 0, x1 = width, y1 = height;
+  if (previous)
+  {
+    x0 = width;
+    y0 = height;
+    x1 = 0;
+    y1 = 0;
+    for (uint16_t y = 0; y < height; y++)
+    {
+      for (uint16_t x = 0; x < width; x++)
+      {
+        if (frame[(size_t)y * width + x] == previous[(size_t)y * width + x])
+          continue;
+        x0 = x < x0 ? x : x0;
+        x1 = x + 1 > x1 ? x + 1 : x1;
+        y0 = y < y0 ? y : y0;
+        y1 = y + 1;
+      }
+    }
+    if (x1 == 0)
+      x0 = y0 = 0; // Nothing changed: an empty rectangle
+  }
+  uint16_t w = x1 - x0, h = y1 - y0;
+
+  size_t raw = (size_t)w * h * 2;
+  size_t runs = rleSize(frame, width, x0, y0, w, h);
+  bool rle = runs < raw;
+  size_t length = rle ? runs : raw;
+  size_t total = 2 + STREAM_HEADER_SIZE + length + STREAM_CRC_SIZE;
+  if (total > capacity)
+    return 0;
+
+  out[0] = STREAM_SYNC0;
+  out[1] = STREAM_SYNC1;
+  uint8_t *header = out + 2;
+  header[0] = (previous ? STREAM_RECT : STREAM_FULL) | (rle ? STREAM_RLE : 0);
+  header[1] = sequence;
+  put16(header + 2, x0);
+  put16(header + 4, y0);
+  put16(header + 6, w);
+  put16(header + 8, h);
+  put32(header + 10, length);
+
+  uint8_t *payload = header + STREAM_HEADER_SIZE;
+  uint8_t *p = payload;
+  int run = 0;
+  for (uint16_t y = y0; y < y1; y++)
+  {
+    for (uint16_t x = x0; x < x1; x++)
+    {
+      uint16_t pixel = frame[(size_t)y * width + x];
+      if (!rle)
+      {
+        put16(p, pixel);
+        p += 2;
+      }
+      else if (run && pixel == le16(p - 2) && run < 256)
+      {
+        p[-3] = run++;
+      }
+      else
+      {
+        p[0] = 0;
+        put16(p + 1, pixel);
+        p += 3;
+        run = 1;
+      }
+    }
+  }
+
+  put32(p, streamCrc32(0, header, STREAM_HEADER_SIZE + length));
+  return total;
+}
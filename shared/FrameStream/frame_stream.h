@@ -0,0 +1,123 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Binary protocol for driving a panel live from a host over a serial link. Every packet
+// updates one rectangle of an RGB565 frame:
+//
+//   uint8_t  sync[2]      0xA5 0x5A
+//   uint8_t  type         StreamPacketType, plus STREAM_RLE when run-length coded
+//   uint8_t  sequence     +1 per packet, so a gap shows packets were lost
+//   uint16_t x, y, w, h   rectangle the payload covers
+//   uint32_t length       payload bytes
+//   payload               raw: w * h RGB565 pixels, row by row
+//                         RLE: (uint8_t count - 1, uint16_t RGB565) runs over the same order
+//   uint32_t crc32        CRC-32 (as zlib.crc32) of everything from `type` to the payload end
+//
+// All fields little-endian. A full frame sets the stream's size; rectangles patch the
+// frame before them, and an empty one (w = h = 0) just repeats it. Bytes outside
+// packets (e.g. single-letter Serial commands) are passed on untouched.
+//
+// Receiving is double-buffered: the receive side parses and checks packets into one
+// payload buffer while the display side applies and presents the one before. Each side
+// runs on its own thread and each buffer is owned by one side at a time, handed over
+// with release/acquire flags. No Arduino dependencies so it builds on a host.
+
+#define STREAM_SYNC0 0xA5
+#define STREAM_SYNC1 0x5A
+#define STREAM_HEADER_SIZE 14 // type to length
+#define STREAM_CRC_SIZE 4
+#define STREAM_RLE 0x80       // Type flag: payload is run-length coded
+
+enum StreamPacketType : uint8_t
+{
+  STREAM_FULL = 1, // Whole frame at (0, 0); sets the stream size
+  STREAM_RECT = 2  // Part of the frame that changed since the packet before
+};
+
+// Worst case packet for a width x height stream (the encoder never sends RLE larger than raw)
+inline size_t streamMaxPacketSize(uint16_t width, uint16_t height)
+{
+  return 2 + STREAM_HEADER_SIZE + (size_t)width * height * 2 + STREAM_CRC_SIZE;
+}
+
+// A packet that passed its CRC
+struct StreamPacket
+{
+  uint8_t type; // Without STREAM_RLE
+  bool rle;
+  uint8_t sequence;
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+  uint32_t length;
+  uint8_t *payload; // Owned by the receiver
+};
+
+// Receives bytes that are not part of a packet
+typedef void (*StreamByteFn)(void *ctx, uint8_t byte);
+
+struct StreamReceiver
+{
+  StreamPacket packets[2];
+  std::atomic<bool> ready[2]; // Packet i is complete and owned by the display side
+  uint32_t capacity;          // Payload bytes per buffer
+  StreamByteFn stray;
+  void *strayCtx;
+
+  // Receive side
+  uint8_t filling; // Buffer the next payload goes into
+  uint8_t state;
+  uint32_t received; // Bytes of the current field so far
+  uint8_t header[STREAM_HEADER_SIZE];
+  uint8_t crcBytes[STREAM_CRC_SIZE];
+  uint32_t crc;
+  bool stalled;
+  uint32_t packetsReceived;
+  uint32_t crcErrors;
+  uint32_t badPackets;    // Header that cannot be right (size, type) or payload too large
+  uint32_t stalls;        // Both buffers were full: input waited for the display side
+  uint32_t sequenceGaps;  // Packets missing between two that arrived
+  uint32_t bytesReceived; // Packet bytes, stray bytes not included
+  int16_t lastSequence;   // -1 before the first packet
+
+  // Display side
+  uint8_t taking; // Buffer the next packet is taken from
+};
+
+// Allocate both payload buffers (`capacity` bytes each; streamMaxPacketSize() minus the
+// framing covers any frame up to that size). Returns false on allocation failure.
+bool streamReceiverInit(StreamReceiver *receiver, uint32_t capacity, StreamByteFn stray = nullptr,
+                        void *strayCtx = nullptr);
+
+void freeStreamReceiver(StreamReceiver *receiver);
+
+// Receive side: parse `length` bytes. Returns the bytes consumed, which is less than
+// `length` only when both buffers hold packets the display side has not released yet:
+// call again with the rest once it has.
+size_t streamReceive(StreamReceiver *receiver, const uint8_t *data, size_t length);
+
+// Display side: the next complete packet in arrival order, or nullptr
+const StreamPacket *streamTake(StreamReceiver *receiver);
+
+// Display side: hand a taken packet's buffer back to the receive side
+void streamRelease(StreamReceiver *receiver);
+
+// Apply a packet to an RGB565 frame of width x height (`stride` pixels per row).
+// Returns false if it does not fit the frame or its payload does not cover its rectangle.
+bool streamApply(const StreamPacket *packet, uint16_t *pixels, uint16_t stride, uint16_t width, uint16_t height);
+
+// Encode `frame` as one packet into `out`: the bounding box of what differs from
+// `previous` (everything when previous is nullptr), RLE when that is smaller. Returns
+// the packet size, or 0 if it does not fit in `capacity`.
+size_t streamEncode(uint8_t *out, size_t capacity, const uint16_t *frame, const uint16_t *previous, uint16_t width,
+                    uint16_t height, uint8_t sequence);
+
+// Continue a CRC-32 (start from 0)
+uint32_t streamCrc32(uint32_t crc, const uint8_t *data, size_t length);
+
+#endif
@@ -0,0 +1,121 @@
+#include "virtual_canvas.h"
+
+// Canvas area of a panel at (x, y): quarter turns swap its width and height
+static CanvasRect panelArea(const VirtualCanvas *canvas, int16_t x, int16_t y, uint8_t rotation)
+{
+  if (rotation & 1)
+    return {x, y, canvas->panelHeight, canvas->panelWidth};
+  return {x, y, canvas->panelWidth, canvas->panelHeight};
+}
+
+static void updateBounds(VirtualCanvas *canvas)
+{
+  canvas->width = 0;
+  canvas->height = 0;
+  for (uint8_t i = 0; i < canvas->panelCount; i++)
+  {
+    const CanvasRect *area = &canvas->panels[i].area;
+    if (area->x + area->w > canvas->width)
+      canvas->width = area->x + area->w;
+    if (area->y + area->h > canvas->height)
+      canvas->height = area->y + area->h;
+  }
+}
+
+bool canvasInitGrid(VirtualCanvas *canvas, int16_t panelWidth, int16_t panelHeight, uint8_t columns, uint8_t rows,
+                    uint8_t rotation, bool serpentine)
+{
+  if (columns * rows > CANVAS_MAX_PANELS)
+    return false;
+
+  canvas->panelWidth = panelWidth;
+  canvas->panelHeight = panelHeight;
+  canvas->panelCount = columns * rows;
+
+  // Quarter turns swap the size of every cell in the grid
+  int16_t cellWidth = (rotation & 1) ? panelHeight : panelWidth;
+  int16_t cellHeight = (rotation & 1) ? panelWidth : panelHeight;
+  for (uint8_t i = 0; i < canvas->panelCount; i++)
+  {
+    uint8_t row = i / columns;
+    uint8_t column = i % columns;
+    uint8_t turns = rotation;
+    if (serpentine && (row & 1))
+    {
+      column = columns - 1 - column;
+      turns += 2;
+    }
+
+    CanvasPanel *panel = &canvas->panels[i];
+    panel->rotation = turns & 3;
+    panel->area = panelArea(canvas, column * cellWidth, row * cellHeight, panel->rotation);
+  }
+
+  updateBounds(canvas);
+  canvasMarkAllDirty(canvas);
+  return true;
+}
+
+bool canvasPlacePanel(VirtualCanvas *canvas, uint8_t index, int16_t x, int16_t y, uint8_t rotation)
+{
+  if (index >= canvas->panelCount)
+    return false;
+
+  CanvasPanel *panel = &canvas->panels[index];
+  panel->rotation = rotation & 3;
+  panel->area = panelArea(canvas, x, y, panel->rotation);
+  updateBounds(canvas);
+  canvas->dirty |= (uint32_t)1 << index;
+  return true;
+}
+
+bool canvasIntersect(const CanvasRect *a, const CanvasRect *b, CanvasRect *out)
+{
+  int16_t x0 = a->x > b->x ? a->x : b->x;
+  int16_t y0 = a->y > b->y ? a->y : b->y;
+  int16_t x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+  int16_t y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+  if (x0 >= x1 || y0 >= y1)
+    return false;
+
+  *out = {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+  return true;
+}
+
+uint32_t canvasPanelsIn(const VirtualCanvas *canvas, const CanvasRect *rect)
+{
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < canvas->panelCount; i++)
+  {
+    const CanvasRect *area = &canvas->panels[i].area;
+    if (rect->x < area->x + area->w && area->x < rect->x + rect->w && rect->y < area->y + area->h &&
+        area->y < rect->y + rect->h)
+      mask |= (uint32_t)1 << i;
+  }
+  return mask;
+}
+
+// Rotations match Adafruit GFX: content pixel (u, v) lands on the panel at
+//   0: (u, v)   1: (W-1-v, u)   2: (W-1-u, H-1-v)   3: (v, H-1-u)
+// for a W x H panel; a rectangle maps to a rectangle, with its sides swapped on odd turns
+CanvasRect canvasToChain(const VirtualCanvas *canvas, uint8_t index, const CanvasRect *rect)
+{
+  const CanvasPanel *panel = &canvas->panels[index];
+  int16_t u = rect->x - panel->area.x;
+  int16_t v = rect->y - panel->area.y;
+  int16_t pw = canvas->panelWidth;
+  int16_t ph = canvas->panelHeight;
+  int16_t offset = index * pw;
+
+  switch (panel->rotation)
+  {
+  case 1:
+    return {(int16_t)(offset + pw - v - rect->h), u, rect->h, rect->w};
+  case 2:
+    return {(int16_t)(offset + pw - u - rect->w), (int16_t)(ph - v - rect->h), rect->w, rect->h};
+  case 3:
+    return {(int16_t)(offset + v), (int16_t)(ph - u - rect->w), rect->h, rect->w};
+  default:
+    return {(int16_t)(offset + u), v, rect->w, rect->h};
+  }
+}
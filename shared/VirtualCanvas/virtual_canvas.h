@@ -0,0 +1,123 @@
+#ifndef VIRTUAL_CANVAS_H
+#define VIRTUAL_CANVAS_H
+
+#include <stdint.h>
+
+// One drawing surface spread over a chain of HUB75 panels laid out as a wall. The
+// driver sees the chain as a single strip (panel i at x = i * panelWidth); the canvas
+// places each panel somewhere on a larger area with its own rotation, so a sketch draws
+// in canvas coordinates and never deals with how the wall is cabled.
+//
+// Panels also carry a dirty bit. Whoever changes what a region should show marks it
+// dirty; the render pass then only redraws panels whose bit is set and clears them, so
+// the cost of a frame follows the area that changed rather than the size of the wall.
+// No Arduino dependencies so it builds on a host.
+
+#define CANVAS_MAX_PANELS 32          // One dirty bit each
+#define CANVAS_ALL_PANELS 0xFFFFFFFF // Panel mask with every bit set
+
+struct CanvasRect
+{
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+};
+
+// Where a panel sits on the canvas
+struct CanvasPanel
+{
+  CanvasRect area;  // Canvas pixels it shows (width and height swap for quarter turns)
+  uint8_t rotation; // Quarter turns applied to its content, as Adafruit GFX setRotation()
+};
+
+struct VirtualCanvas
+{
+  int16_t width;       // Bounding box of all panels
+  int16_t height;
+  int16_t panelWidth;  // One physical panel, as the driver addresses it
+  int16_t panelHeight;
+  uint8_t panelCount;  // Panels in the chain
+  CanvasPanel panels[CANVAS_MAX_PANELS]; // By position in the chain
+  uint32_t dirty;      // Bit i: panel i needs redrawing
+};
+
+#define VIRTUAL_CANVAS_INIT {0, 0, 0, 0, 0, {}, 0}
+
+// Lay out `columns` x `rows` panels, chained row by row from the top left. With
+// `serpentine` the chain snakes: odd rows run right to left with their panels mounted
+// upside down (the usual way walls are cabled). Every panel gets `rotation` (plus the
+// half turn on snaking rows). A single chain is `rows` = 1. All panels start dirty.
+// Returns false if there are more than CANVAS_MAX_PANELS.
+bool canvasInitGrid(VirtualCanvas *canvas, int16_t panelWidth, int16_t panelHeight, uint8_t columns, uint8_t rows,
+                    uint8_t rotation = 0, bool serpentine = false);
+
+// Move chain panel `index` to (x, y) on the canvas with its own rotation, for walls that
+// are not a regular grid. The canvas grows to cover it. Returns false for a bad index.
+bool canvasPlacePanel(VirtualCanvas *canvas, uint8_t index, int16_t x, int16_t y, uint8_t rotation);
+
+// Overlap of two rectangles. Returns false (out untouched) when they do not overlap.
+bool canvasIntersect(const CanvasRect *a, const CanvasRect *b, CanvasRect *out);
+
+// Mask of the panels a canvas rectangle touches
+uint32_t canvasPanelsIn(const VirtualCanvas *canvas, const CanvasRect *rect);
+
+// The part of a canvas rectangle that lies on panel `index`, in chain (driver)
+// coordinates. `rect` must already be clipped to that panel's area.
+CanvasRect canvasToChain(const VirtualCanvas *canvas, uint8_t index, const CanvasRect *rect);
+
+// Flag every panel under `rect` for redrawing
+inline void canvasMarkDirty(VirtualCanvas *canvas, const CanvasRect *rect)
+{
+  canvas->dirty |= canvasPanelsIn(canvas, rect);
+}
+
+inline void canvasMarkAllDirty(VirtualCanvas *canvas)
+{
+  canvas->dirty = canvas->panelCount >= 32 ? CANVAS_ALL_PANELS : ((uint32_t)1 << canvas->panelCount) - 1;
+}
+
+inline void canvasClearDirty(VirtualCanvas *canvas)
+{
+  canvas->dirty = 0;
+}
+
+// A chain rectangle (from canvasToChain) of one colour as a single display call: a pixel,
+// a line or a rectangle fill (lines along a rotated panel's rows come out vertical).
+// Works with any display with Adafruit GFX drawPixel/drawFastHLine/drawFastVLine/fillRect
+// and no rotation of its own.
+template <typename Display>
+void canvasFillChainRect(Display *display, const CanvasRect *out, uint16_t color)
+{
+  if (out->w == 1 && out->h == 1)
+    display->drawPixel(out->x, out->y, color);
+  else if (out->h == 1)
+    display->drawFastHLine(out->x, out->y, out->w, color);
+  else if (out->w == 1)
+    display->drawFastVLine(out->x, out->y, out->h, color);
+  else
+    display->fillRect(out->x, out->y, out->w, out->h, color);
+}
+
+// One canvas rectangle of a single colour, split per panel, one display call per piece.
+// `panels` limits it to a mask, e.g. canvas->dirty. Returns the number of display calls.
+template <typename Display>
+uint32_t canvasFillRect(const VirtualCanvas *canvas, Display *display, const CanvasRect *rect, uint16_t color,
+                        uint32_t panels = CANVAS_ALL_PANELS)
+{
+  uint32_t calls = 0;
+  panels &= canvasPanelsIn(canvas, rect);
+  for (uint8_t i = 0; panels; i++, panels >>= 1)
+  {
+    CanvasRect part;
+    if (!(panels & 1) || !canvasIntersect(rect, &canvas->panels[i].area, &part))
+      continue;
+
+    CanvasRect out = canvasToChain(canvas, i, &part);
+    canvasFillChainRect(display, &out, color);
+    calls++;
+  }
+  return calls;
+}
+
+#endif